@@ -3,8 +3,6 @@
 
 #include <Arduino.h>
 
-// #include <EEPROM.h>
-
 #ifndef DEFAULT_CONSTANTS_ADDRESS
 #define DEFAULT_CONSTANTS_ADDRESS 0
 #endif
@@ -17,6 +15,22 @@
 #define MAX_CONSTANTS_VALUE 1000.0f
 #endif
 
+// ticks the derivative is taken over
+#ifndef PID_HISTORY_LENGTH
+#define PID_HISTORY_LENGTH 5
+#endif
+
+// getPIDPeriod() thresholds
+#ifndef PID_RAMP_RATE_C_PER_S
+#define PID_RAMP_RATE_C_PER_S 0.2f // setpoint moving at least this fast counts as a ramp
+#endif
+#ifndef PID_CROSSING_LOOKAHEAD_S
+#define PID_CROSSING_LOOKAHEAD_S 3.0f // oven due to reach the setpoint within this counts as a crossing
+#endif
+#ifndef PID_STEADY_RATE_C_PER_S
+#define PID_STEADY_RATE_C_PER_S 0.2f // oven temperature changing slower than this, on a steady setpoint, counts as a hold
+#endif
+
 extern bool flag_PID_running;
 
 struct PID_Constants
@@ -38,7 +52,7 @@ struct PID
     // PID constants
     PID_Constants constants;
 
-    // time that has passed
+    // time since the last calculatePID(). varies; see getPIDPeriod()
     double dt;
 
     // inputs
@@ -49,16 +63,26 @@ struct PID
 
     // calculated filter components
     double integral;
-    double derivative;
+    double derivative; // of the error with the setpoint held still: -d(input)/dt
+
+    // added to the output as is; run-to-run learning, see learning.h. 0 otherwise
+    double feedforward;
 
     // output
     double output;
     // output relative to threshold will dictate if error is big enough to warrant the heater to turn on
 
-    double temperatureHistory[5]; // Array to store the last 5 temperature readings
-    int historyIndex;             // Index for the current position in the temperature history array
+    double inputHistory[PID_HISTORY_LENGTH]; // temperatures of the last ticks, for the derivative
+    double dtHistory[PID_HISTORY_LENGTH];    // dt of each of those ticks
+    int historyIndex;                        // where the next tick goes
+    int historyLength;                       // ticks in the history so far
+
+    // setpoint at the last getPIDPeriod(), to tell a ramp
+    double prev_target;
 };
 
+extern PID pid;
+
 /*!
     @brief  Verifies if the PID constants are proper
 
@@ -67,28 +91,6 @@ struct PID
 */
 bool is_PID_constants_valid(PID_Constants *ptr_constants_to_check);
 
-/*!
-    @brief  Writes the supplied PID constants to EEPROM
-
-    @param index an int which is the address to write the data to.
-
-    @param ptr_constants a pointer to the PID_Constants you want to write to EEPROM
-
-    @return boolean: success = true. fail = false
-*/
-bool save_PID_constants_to_EEPROM(int index, PID_Constants *ptr_constants);
-
-/*!
-    @brief  Writes the supplied PID constants to EEPROM
-
-    @param index an int which is the address to write the data to.
-
-    @param ptr_constants a pointer to the PID_Constants you want to write to EEPROM
-
-    @return boolean: success = true. fail = false
-*/
-bool get_PID_constants_from_EEPROM(int index, PID_Constants *ptr_constants);
-
 /**
  * @brief calculate PID
  *
@@ -98,6 +100,20 @@ bool get_PID_constants_from_EEPROM(int index, PID_Constants *ptr_constants);
  */
 bool calculatePID(PID *pid);
 
+/**
+ * @brief Forget the derivative history, so the first ticks after the PID starts don't take the derivative across the gap
+ */
+void resetPIDHistory(PID *pid);
+
+/**
+ * @brief Pick how long to wait before the next calculatePID(). Call right after it.
+ * fast_ms while the setpoint ramps or the oven is about to cross it, slow_ms while the setpoint is steady
+ * and the error barely changes (a hold, or idling at a standby setpoint), normal_ms otherwise.
+ *
+ * @return unsigned long the period, ms
+ */
+unsigned long getPIDPeriod(PID *pid, unsigned long fast_ms, unsigned long normal_ms, unsigned long slow_ms);
+
 /**
  * @brief Prints a csv of the states of a PID object
  *
@@ -0,0 +1,69 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// no Arduino.h: the queue logic also builds on a host
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+Batch production queue.
+
+A batch runs the selected profile a set number of times. Between runs the oven holds SETTING_STANDBY_C
+instead of cooling all the way down. The next run starts by itself as soon as the board has been
+confirmed loaded and the oven is within SETTING_START_WINDOW_C of standby, whichever happens last.
+
+Throughput is counted from when the first run started, so it includes the cooldown and loading time
+between boards.
+*/
+
+#ifndef MAX_BATCH_RUNS
+#define MAX_BATCH_RUNS 99
+#endif
+
+struct BatchQueue
+{
+    bool active;
+    bool loaded;      // next board confirmed in the oven
+    uint8_t total;    // runs queued
+    uint8_t done;     // runs finished
+    uint32_t start_s; // when the first run started. 0: not started yet
+};
+
+/**
+ * @brief Queue total runs. Nothing starts until the first board is confirmed loaded.
+ */
+void beginBatch(BatchQueue *ptr_batch, uint8_t total);
+
+/**
+ * @brief Drop the rest of the batch
+ */
+void endBatch(BatchQueue *ptr_batch);
+
+/**
+ * @brief Whether the next run can start: the board is loaded and the oven is within window_c of standby_c
+ */
+bool isBatchReady(const BatchQueue *ptr_batch, float temp_c, uint16_t standby_c, uint16_t window_c);
+
+/**
+ * @brief Note that a queued run started
+ *
+ * @param now_s current time in seconds
+ */
+void startBatchRun(BatchQueue *ptr_batch, uint32_t now_s);
+
+/**
+ * @brief Count a finished run
+ *
+ * @return true: more runs queued
+ * @return false: that was the last one; the batch is over
+ */
+bool finishBatchRun(BatchQueue *ptr_batch);
+
+/**
+ * @brief Boards per hour since the first run started, x10. 0 before a board has finished.
+ *
+ * @param now_s current time in seconds
+ */
+uint16_t getBatchRate(const BatchQueue *ptr_batch, uint32_t now_s);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef BUTTONS_H
 #define BUTTONS_H
 
+#include <Arduino.h>
 #include "config.h"
 
 #ifndef LB
@@ -19,6 +20,70 @@
 #define SB 3
 #endif
 
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 20 // pin has to read the same for this long before a press/release counts
+#endif
+
+#ifndef BUTTON_LONG_PRESS_MS
+#define BUTTON_LONG_PRESS_MS 800
+#endif
+
+#ifndef BUTTON_REPEAT_DELAY_MS
+#define BUTTON_REPEAT_DELAY_MS 400 // hold this long before a button starts auto-repeating
+#endif
+
+#ifndef BUTTON_REPEAT_INTERVAL_MS
+#define BUTTON_REPEAT_INTERVAL_MS 100
+#endif
+
+// auto-repeat acceleration. step size for a repeat depends on how long the button has been held
+#ifndef BUTTON_ACCEL_STEP_5_MS
+#define BUTTON_ACCEL_STEP_5_MS 1500
+#endif
+#ifndef BUTTON_ACCEL_STEP_10_MS
+#define BUTTON_ACCEL_STEP_10_MS 3000
+#endif
+#ifndef BUTTON_ACCEL_STEP_50_MS
+#define BUTTON_ACCEL_STEP_50_MS 4500
+#endif
+
+#ifndef BUTTON_QUEUE_SIZE
+#define BUTTON_QUEUE_SIZE 16 // must be a power of 2
+#endif
+
+// button ids, index into the sampling table
+#define BUTTON_LEFT 0
+#define BUTTON_RIGHT 1
+#define BUTTON_UP 2
+#define BUTTON_DOWN 3
+#define BUTTON_SELECT 4
+#define NUM_BUTTONS 5
+
+// event types
+#define BUTTON_EVENT_PRESS 0
+#define BUTTON_EVENT_RELEASE 1
+#define BUTTON_EVENT_LONG_PRESS 2
+#define BUTTON_EVENT_REPEAT 3 // generated while held, after BUTTON_REPEAT_DELAY_MS
+
+struct ButtonEvent
+{
+    uint8_t button;
+    uint8_t type;
+    uint8_t step; // 1 for a press, 1/5/10/50 for a repeat depending on how long it's been held
+};
+
+// step of the press or repeat that raised the current flag. see editor.h
+extern uint8_t button_step;
+// the current flag was raised by an auto-repeat rather than a push. only number editing should act on those
+extern bool button_repeat;
+
+/**
+ * @brief Change how long a pin has to settle before a press/release counts (SETTING_BUTTON_DEBOUNCE_MS)
+ *
+ * @param debounce_ms 1 - 255
+ */
+void setButtonDebounce(uint8_t debounce_ms);
+
 // flags
 extern bool left_button_pressed;
 extern bool right_button_pressed;
@@ -26,10 +91,50 @@ extern bool up_button_pressed;
 extern bool down_button_pressed;
 extern bool select_button_pressed;
 
+/*!
+    @brief  Set the button pins to inputs and start sampling them from the timer 0 compare interrupt.
+
+    The button pins on the Mega (2-6) are not all interrupt capable, so instead of pin change
+    interrupts every button is sampled once a millisecond. Each one runs through its own debounce
+    state machine and pushes press/release/long-press events into a queue, so a press is never
+    lost no matter how long loop() takes.
+
+    @return None
+*/
+void initializeButtons(void);
+
+/*!
+    @brief  Take the oldest event off the button queue.
+
+    @param ptr_event pointer to the event to fill
+
+    @return boolean; false if the queue was empty
+*/
+bool popButtonEvent(ButtonEvent *ptr_event);
+
+/*!
+    @brief  Whether a button is currently held down (debounced)
+
+    @param button button id, e.g. BUTTON_LEFT
+
+    @return boolean; true if held
+*/
+bool isButtonHeld(uint8_t button);
+
+/*!
+    @brief  Number of events dropped because the queue was full. Should stay 0.
+
+    @return uint8_t count, saturates at 255
+*/
+uint8_t getDroppedButtonEvents(void);
+
 /*!
     @brief  Check the states of various buttons and assign their states to corresponding flags.
 
-    This function checks if any of the specified buttons are pressed and updates the respective flags.
+    This function takes press events off the button queue and updates the respective flags.
+    At most one flag is set per call, so every queued press is handled by its own pass of loop().
+    Auto-repeats of the arrow buttons count as presses; button_step says how far the repeat should move and
+    button_repeat tells them apart from a push.
     It's used to handle user inputs from the buttons in the system.
 
     @param left_button_pressed A pointer to a boolean flag that will be set to true if the left button is pressed.
@@ -7,6 +7,9 @@
 #ifndef EEPROM_INITIAL_ADDRESS
 #define EEPROM_INITIAL_ADDRESS 0
 #endif
+#ifndef EEPROM_SIZE
+#define EEPROM_SIZE 4096 // ATmega2560
+#endif
 
 /*
 Pin definitions
@@ -17,8 +20,17 @@ Pin definitions
 #ifndef HEAT_RELAY_PIN
 #define HEAT_RELAY_PIN 9
 #endif
+#ifndef SD_CS_PIN
+#define SD_CS_PIN 53 // hardware SS on the Mega
+#endif
 #ifndef MS_BETWEEN_PID
-#define MS_BETWEEN_PID 500
+#define MS_BETWEEN_PID 500 // control period when nothing calls for a faster or slower one, see getPIDPeriod()
+#endif
+#ifndef FAST_MS_BETWEEN_PID
+#define FAST_MS_BETWEEN_PID 250 // while the setpoint ramps or the oven is about to cross it. no faster than the thermocouple is read
+#endif
+#ifndef SLOW_MS_BETWEEN_PID
+#define SLOW_MS_BETWEEN_PID 2000 // while the setpoint is steady and the oven barely moving
 #endif
 #ifndef LB
 #define LB 3
@@ -53,7 +65,7 @@ SPI pins for thermocouple board
 Reflow profiles Config
 */
 #ifndef NUM_REFLOW_PROFILES
-#define NUM_REFLOW_PROFILES 10
+#define NUM_REFLOW_PROFILES 100 // stored packed, PACKED_PROFILE_SIZE bytes + CRC each. only loaded into RAM when used
 #endif
 
 #ifndef MAX_TEMP_C
@@ -118,7 +130,7 @@ Default PID constants
 #define DEFAULT_PID_I 0.0f
 #endif
 #ifndef DEFAULT_PID_D
-#define DEFAULT_PID_D 22.0f
+#define DEFAULT_PID_D 10.0f
 #endif
 #ifndef DEFAULT_PID_THRESHOLD
 #define DEFAULT_PID_THRESHOLD 0.1f
@@ -174,6 +186,18 @@ Modes
 #define MODE_EDIT_PID_PRAMS 7 // left and right to select param, up and down to mod. save or cancel brings you back to -1
 #endif
 
+#ifndef MODE_EDIT_SETTINGS
+#define MODE_EDIT_SETTINGS 8 // up and down to pick a setting, left and right to change it. save keeps it, cancel reverts. both go back to 0
+#endif
+
+#ifndef MODE_BATCH_STANDBY
+#define MODE_BATCH_STANDBY 11 // holds standby between batch runs. select confirms the board is loaded, left drops the batch and goes back to 2
+#endif
+
+#ifndef MODE_RESUME_RUN
+#define MODE_RESUME_RUN 9 // shown at boot when a run was cut off. resume carries on in 3, discard goes to -1
+#endif
+
 #ifndef MODE_STATUS
 #define MODE_STATUS -1 // hitting select takes you to 0. otherwise it displays the temp inside the oven.
 #endif
@@ -193,4 +217,30 @@ Screen
 #define SHIMMY_PERIOD 5000 // the amount of time that passes in between cycling information.
 #endif
 
+/*
+Batch mode defaults (SETTING_BATCH_RUNS etc.)
+*/
+#ifndef DEFAULT_BATCH_RUNS
+#define DEFAULT_BATCH_RUNS 10
+#endif
+
+#ifndef DEFAULT_STANDBY_C
+#define DEFAULT_STANDBY_C 60 // oven held here between batch runs
+#endif
+
+#ifndef DEFAULT_START_WINDOW_C
+#define DEFAULT_START_WINDOW_C 10 // next run can start within this far of standby
+#endif
+
+/*
+Profile preview graph
+*/
+#ifndef PROFILE_GRAPH_AMBIENT_C
+#define PROFILE_GRAPH_AMBIENT_C 25 // temperature the preview curve starts from
+#endif
+
+#ifndef PROFILE_GRAPH_TOP
+#define PROFILE_GRAPH_TOP 32 // first pixel row of the graph area. menu and labels live above it
+#endif
+
 #endif
\ No newline at end of file
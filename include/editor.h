@@ -0,0 +1,80 @@
+#ifndef EDITOR_H
+#define EDITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Numeric editing. Left/right change the highlighted field by button_step, which grows while
+the button is held (1, 5, 10, 50), so going across a whole range takes a few seconds.
+*/
+
+#ifndef PID_EDIT_RESOLUTION
+#define PID_EDIT_RESOLUTION 0.1f // one step of a PID constant
+#endif
+
+#ifndef MIN_THRESHOLD_VALUE
+#define MIN_THRESHOLD_VALUE (-MAX_CONSTANTS_VALUE)
+#endif
+
+#ifndef MAX_THRESHOLD_VALUE
+#define MAX_THRESHOLD_VALUE MAX_CONSTANTS_VALUE
+#endif
+
+/*!
+    @brief  Move an int by the current button step, clamped to a range
+
+    @param ptr_value pointer to the value to edit
+    @param direction 1 to increase, -1 to decrease
+    @param min_value lowest value allowed
+    @param max_value highest value allowed
+
+    @return None; edits the value in place
+*/
+void editIntValue(int *ptr_value, int direction, int min_value, int max_value);
+
+/*!
+    @brief  Move a double by the current button step times a resolution, clamped to a range
+
+    @param ptr_value pointer to the value to edit
+    @param direction 1 to increase, -1 to decrease
+    @param resolution size of a single step
+    @param min_value lowest value allowed
+    @param max_value highest value allowed
+
+    @return None; edits the value in place
+*/
+void editDoubleValue(double *ptr_value, int direction, double resolution, double min_value, double max_value);
+
+/*!
+    @brief  Move a setting by its step times the current button step, clamped to its range.
+    Choice settings (thermocouple type, on/off) always move one at a time.
+
+    @param id SETTING_ id
+    @param direction 1 to increase, -1 to decrease
+
+    @return None; the setting is changed and applied, not saved
+*/
+void editSetting(uint8_t id, int direction);
+
+/*!
+    @brief  Step a stage gate (SegmentGate) to the next or previous one, wrapping around
+
+    @param ptr_gate pointer to the gate to edit
+    @param direction 1 for the next gate, -1 for the previous
+
+    @return None; edits the gate in place
+*/
+void editGate(uint8_t *ptr_gate, int direction);
+
+/*!
+    @brief  Name of a stage gate for the edit screen: "Time", "Temp" or "Both"
+
+    @param gate SegmentGate
+    @param buffer at least STR_LEN
+
+    @return None
+*/
+void formatGate(uint8_t gate, char *buffer);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef EEPROM_CACHE_H
+#define EEPROM_CACHE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Write-behind cache in front of the EEPROM.
+
+Writes are staged in RAM slots and only bytes that differ from what's already in the EEPROM
+are marked dirty. serviceEepromCache() then writes one dirty byte per call, and only when the
+EEPROM has finished the previous one (~3.3ms each), so saving never stalls loop().
+
+Within a slot bytes are written from the highest address down, and slots drain oldest first; rewriting a
+staged range makes it the youngest again. Records that put their CRC in front of the payload therefore get
+the CRC written last.
+
+The slots hold the biggest burst one loop() pass stages: a 34 byte record (2 slots), a journal entry (2),
+a trace sample and trace header (2), and a learning record at the end of a run (2). Only a write beyond that,
+or one that partly overlaps a staged range, has to drain a slot first; that stalls loop() for at most
+EEPROM_CACHE_SLOT_SIZE bytes, ~3.3ms each (~106ms).
+*/
+
+#ifndef EEPROM_CACHE_SLOTS
+#define EEPROM_CACHE_SLOTS 8
+#endif
+
+#ifndef EEPROM_CACHE_SLOT_SIZE
+#define EEPROM_CACHE_SLOT_SIZE 32 // max 32, one dirty bit per byte
+#endif
+
+struct EepromCacheSlot
+{
+    uint16_t address;
+    uint8_t length; // 0 means the slot is free
+    uint8_t age;    // 0 is the oldest. drained first
+    uint32_t dirty; // bit i set: data[i] still has to be written
+    uint8_t data[EEPROM_CACHE_SLOT_SIZE];
+};
+
+/**
+ * @brief Stage a write. Bytes equal to what's already stored are never written.
+ * Only blocks when every slot is busy, or when it overlaps a pending write of a different range;
+ * then the oldest/overlapping slot is drained first, at most ~106ms per slot.
+ *
+ * @param address EEPROM address
+ * @param data bytes to write
+ * @param length number of bytes. longer than a slot is split across slots
+ */
+void eepromCacheWrite(uint16_t address, const void *data, uint16_t length);
+
+/**
+ * @brief Read from the EEPROM, seeing staged writes that haven't reached it yet
+ *
+ * @param address EEPROM address
+ * @param data where to put the bytes
+ * @param length number of bytes
+ */
+void eepromCacheRead(uint16_t address, void *data, uint16_t length);
+
+/**
+ * @brief Write at most one dirty byte, if the EEPROM is ready for it. Call every loop().
+ *
+ * @return true: nothing left to write
+ * @return false: writes still pending
+ */
+bool serviceEepromCache(void);
+
+/**
+ * @brief Whether every staged write has reached the EEPROM
+ */
+bool isEepromCacheIdle(void);
+
+/**
+ * @brief Block until every staged write has reached the EEPROM
+ */
+void flushEepromCache(void);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "config.h"
+#include "reflow.h"
+
+// ambient start, then the end of every segment
+#ifndef PROFILE_GRAPH_POINTS
+#define PROFILE_GRAPH_POINTS (MAX_PROFILE_SEGMENTS + 1)
+#endif
+
+/**
+ * @brief Cached time/temperature curve of a profile, already scaled to screen pixels.
+ * Built once when a profile is selected or edited, so drawing it is just a few lines.
+ */
+struct ProfileGraph
+{
+    uint8_t num_points;
+    uint8_t x[PROFILE_GRAPH_POINTS];
+    uint8_t y[PROFILE_GRAPH_POINTS];
+    uint16_t total_time_s; // estimated runtime of the whole profile
+    int peak_temp_c;
+};
+
+extern ProfileGraph selected_profile_graph;
+
+/**
+ * @brief Estimate how long a segment profile takes to run in this oven, from the oven model (oven_model.h)
+ *
+ * @param ptr_segments pointer to the segment profile
+ * @return uint16_t estimated runtime in seconds
+ */
+uint16_t estimateSegmentsRuntime(const SegmentProfile *ptr_segments);
+
+/**
+ * @brief Estimate how long a profile takes to run, including the ramp from soak up to reflow temp.
+ *
+ * @param ptr_profile pointer to the profile
+ * @return uint16_t estimated runtime in seconds
+ */
+uint16_t estimateProfileRuntime(ReflowProfile *ptr_profile);
+
+/**
+ * @brief Compute the polyline, runtime and peak for a segment profile and store it in the supplied graph.
+ *
+ * @param ptr_segments pointer to the segment profile to preview
+ * @param ptr_graph pointer to the graph cache to fill
+ */
+void buildSegmentGraph(const SegmentProfile *ptr_segments, ProfileGraph *ptr_graph);
+
+/**
+ * @brief Compute the polyline, runtime and peak for a profile and store it in the supplied graph.
+ *
+ * @param ptr_profile pointer to the profile to preview
+ * @param ptr_graph pointer to the graph cache to fill
+ */
+void buildProfileGraph(ReflowProfile *ptr_profile, ProfileGraph *ptr_graph);
+
+/**
+ * @brief Draw a cached graph into the display buffer. Does not push the buffer to the screen.
+ *
+ * @param ptr_graph pointer to the graph cache
+ */
+void drawProfileGraph(ProfileGraph *ptr_graph);
+
+#endif
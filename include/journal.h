@@ -0,0 +1,97 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Wear-leveled journal for values that change all the time (run counters, heater on-time, run checkpoints).
+
+Every commit appends a snapshot of all values, with a sequence number and CRC, to the next entry of a ring
+in EEPROM, so each cell is only written once every JOURNAL_NUM_ENTRIES commits. On boot the ring is
+scanned for the valid entry with the newest sequence number. A torn write fails its CRC and the previous
+entry is used instead.
+
+Values are kept in RAM; reads never touch the EEPROM. Setting a value only marks the journal dirty, and
+serviceJournal() commits at most once per JOURNAL_COMMIT_INTERVAL_MS. Use commitJournal() for changes that
+must not be lost.
+*/
+
+#ifndef JOURNAL_BASE_ADDRESS
+#define JOURNAL_BASE_ADDRESS 2944 // right after the trace slots
+#endif
+
+#ifndef JOURNAL_NUM_ENTRIES
+#define JOURNAL_NUM_ENTRIES 20
+#endif
+
+#ifndef JOURNAL_COMMIT_INTERVAL_MS
+#define JOURNAL_COMMIT_INTERVAL_MS 60000UL
+#endif
+
+// keys. all values are uint32_t
+#define JOURNAL_RUN_COUNT 0      // profile runs started
+#define JOURNAL_LAST_PROFILE 1   // slot of the last profile run
+#define JOURNAL_HEATER_ON_S 2    // total seconds the heater relay has been on
+#define JOURNAL_COMPLETED_RUNS 3 // profile runs that finished, not cancelled or cut off
+// checkpoint of the run in progress, see recovery.h
+#define JOURNAL_CHECKPOINT_PROFILE 4   // slot of the running profile + 1. 0: no run in progress
+#define JOURNAL_CHECKPOINT_STEP 5      // step index, flags and step end offset
+#define JOURNAL_CHECKPOINT_ELAPSED_S 6 // seconds into the step
+#define JOURNAL_CHECKPOINT_TEMP 7      // oven temperature at the checkpoint, 0.1C
+
+// fixed so adding a key doesn't change the entry layout
+#define JOURNAL_NUM_KEYS 8
+
+struct JournalEntry
+{
+    uint16_t sequence; // counts up every commit. the newest valid entry wins
+    uint32_t values[JOURNAL_NUM_KEYS];
+    uint16_t crc; // over sequence and values
+};
+
+#define JOURNAL_END_ADDRESS (JOURNAL_BASE_ADDRESS + JOURNAL_NUM_ENTRIES * sizeof(JournalEntry))
+
+/**
+ * @brief Find the newest journal entry and load its values. Values start at 0 if there is none.
+ * Call once in setup().
+ */
+void beginJournal(void);
+
+/**
+ * @brief Get a journaled value. Just a RAM read.
+ *
+ * @param key JOURNAL_ key
+ * @return uint32_t value. 0 for an unknown key
+ */
+uint32_t getJournalValue(uint8_t key);
+
+/**
+ * @brief Set a journaled value. Written on the next commit.
+ *
+ * @param key JOURNAL_ key
+ * @param value new value
+ */
+void setJournalValue(uint8_t key, uint32_t value);
+
+/**
+ * @brief Add to a journaled counter. Written on the next commit.
+ */
+void addJournalValue(uint8_t key, uint32_t amount);
+
+/**
+ * @brief Write the values to the next journal entry now, if any changed
+ */
+void commitJournal(void);
+
+/**
+ * @brief Commit if values changed and JOURNAL_COMMIT_INTERVAL_MS has passed since the last commit. Call every loop().
+ */
+void serviceJournal(void);
+
+/**
+ * @brief Print the journaled values to Serial
+ */
+void printJournal(void);
+
+#endif
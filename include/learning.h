@@ -0,0 +1,129 @@
+#ifndef LEARNING_H
+#define LEARNING_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "segments.h"
+
+/*
+Run-to-run learning (iterative learning control).
+
+The same profile on the same oven makes the same tracking errors at the same points of every run. Each run is
+split into LEARNING_BIN_S bins; the mean error (target - oven) of every bin is recorded, and when the run
+finishes each bin's correction moves toward removing it:
+    correction[j] += constrain(LEARNING_GAIN * error[j + LEARNING_LEAD_BINS], +-LEARNING_MAX_STEP)
+The next run adds correction[j] to the PID output as a feedforward term. The lead makes up for the oven's lag:
+heat added in one bin shows up in the next. The step limit keeps one bad run (door opened, odd load) from
+undoing what was learned.
+
+Corrections are kept per profile in LEARNING_NUM_SLOTS EEPROM records after the oven model record. A slot
+holds a CRC of the profile's segments; once the profile is edited it no longer matches, and learning starts
+over. When every slot is taken, the least run profile gives up its slot.
+
+Only whole runs started from the beginning teach anything; a resumed run neither learns nor applies corrections.
+Paused time and cooldowns (setpoint COOLDOWN_SETPOINT_C) don't count.
+
+record (at LEARNING_BASE_ADDRESS + slot * LEARNING_SLOT_SIZE, see writeRecordAt()):
+    | crc16 (2) | profile CRC (2) | profile index (1) | runs learned (1) | correction, LEARNING_UNIT (1) x LEARNING_NUM_BINS |
+*/
+
+#ifndef LEARNING_BASE_ADDRESS
+#define LEARNING_BASE_ADDRESS 3708 // after the oven model record
+#endif
+
+#ifndef LEARNING_NUM_SLOTS
+#define LEARNING_NUM_SLOTS 8
+#endif
+
+#ifndef LEARNING_NUM_BINS
+#define LEARNING_NUM_BINS 28 // fills a RECORD_MAX_PAYLOAD record
+#endif
+
+#ifndef LEARNING_BIN_S
+#define LEARNING_BIN_S 16 // LEARNING_NUM_BINS of these cover 448s; later parts of a run aren't corrected
+#endif
+
+#ifndef LEARNING_LEAD_BINS
+#define LEARNING_LEAD_BINS 1
+#endif
+
+#ifndef LEARNING_GAIN
+#define LEARNING_GAIN 0.5f // output per C of mean error, per run
+#endif
+
+#ifndef LEARNING_MAX_STEP
+#define LEARNING_MAX_STEP 5.0f // most one bin's correction changes in one run, output
+#endif
+
+#define LEARNING_NO_PROFILE 0xFF // profile_index of a cleared slot
+#define LEARNING_UNIT 0.5f       // output per count of a stored correction
+#define LEARNING_SLOT_SIZE (sizeof(uint16_t) + sizeof(LearningRecord))
+
+struct LearningRecord
+{
+    uint16_t profile_crc; // profile the corrections were learned on
+    uint8_t profile_index;
+    uint8_t runs;                         // runs learned from, up to 255
+    int8_t correction[LEARNING_NUM_BINS]; // LEARNING_UNIT
+};
+
+struct RunLearning
+{
+    bool active; // a run is recording
+    uint8_t slot;
+    LearningRecord record;
+    uint32_t elapsed_ms;                   // run time, without pauses
+    float error_sum;                       // of the current bin so far
+    uint16_t error_count;                  // samples in error_sum
+    int16_t mean_error[LEARNING_NUM_BINS]; // 0.1C. INT16_MIN: no samples
+};
+
+extern RunLearning learning;
+
+/**
+ * @brief Load the corrections learned for a profile and start recording a run of it. A profile that changed
+ * since, or was never run, starts with no corrections.
+ *
+ * @param profile_index slot or library index being run
+ */
+void beginLearning(RunLearning *ptr_learning, uint8_t profile_index, const SegmentProfile *ptr_segments);
+
+/**
+ * @brief Stop recording without learning anything, e.g. a cancelled or resumed run. Corrections stop too.
+ */
+void cancelLearning(RunLearning *ptr_learning);
+
+/**
+ * @brief Feedforward to add to the PID output now. 0 when not recording.
+ */
+float getLearningCorrection(const RunLearning *ptr_learning);
+
+/**
+ * @brief Record one PID tick. Call after calculatePID(), except while paused.
+ *
+ * @param dt_s time since the last tick
+ * @param target_c setpoint of the tick
+ * @param error_c target - oven temperature
+ */
+void stepLearning(RunLearning *ptr_learning, float dt_s, float target_c, float error_c);
+
+/**
+ * @brief Update the corrections from the run that just finished and save them
+ *
+ * @return float mean absolute tracking error of the run, C. Should come down over the first few runs
+ */
+float finishLearning(RunLearning *ptr_learning);
+
+/**
+ * @brief Forget everything learned, for every profile
+ */
+void clearLearning(void);
+
+/**
+ * @brief Read a slot's record
+ *
+ * @return false: empty
+ */
+bool readLearningSlot(uint8_t slot, LearningRecord *ptr_record);
+
+#endif
@@ -1,5 +1,6 @@
 #ifndef MENU_H
 #define MENU_H
+#include <Arduino.h>
 #include "Adafruit_SSD1306.h"
 #ifndef STR_LEN
 #define STR_LEN 10
@@ -17,13 +18,35 @@
 #define SCREEN_HEIGHT 64
 #endif
 
+#ifndef DISPLAY_I2C_ADDRESS
+#define DISPLAY_I2C_ADDRESS 0x3C
+#endif
+
+#ifndef DISPLAY_I2C_CLOCK
+#define DISPLAY_I2C_CLOCK 400000UL // SSD1306 and DS3231 are both fine at 400kHz
+#endif
+
+#ifndef DISPLAY_I2C_RESTORE_CLOCK
+#define DISPLAY_I2C_RESTORE_CLOCK 100000UL // bus speed left behind for the other I2C devices, same as Adafruit_SSD1306
+#endif
+
+#ifndef DISPLAY_FLUSH_BYTES_PER_STEP
+#define DISPLAY_FLUSH_BYTES_PER_STEP 64 // ~1.6ms of bus time at 400kHz. 1024 byte frame takes 16 steps
+#endif
+
 extern Adafruit_SSD1306 display;
 
+#ifndef NUM_ITEMS
+#define NUM_ITEMS(array) (sizeof(array) / sizeof((array)[0]))
+#endif
+
+/**
+ * @brief A selectable menu entry. Tables of these are stored in flash (PROGMEM), so read them with getMenuItem().
+ */
 struct MenuItem
 {
     char text[STR_LEN];
     int mode;
-    bool highlighted;
 };
 
 struct ScreenItem
@@ -34,24 +57,128 @@ struct ScreenItem
 struct MenuScreen
 {
     int numMenuItems;
-    MenuItem *menuItems;
+    const MenuItem *menuItems; // PROGMEM table
     int selectedMenuItemIndex;
-    int numScreenItems;
-    ScreenItem screenItems[WINDOW_SIZE];
+    int numScreenItems;        // maximum is WINDOW_SIZE
+    ScreenItem *screenItems;   // RAM, since the text gets rewritten at runtime
+    uint8_t dirtyRows;         // bit i set: screenItems[i] changed since the screen was last drawn
+    // virtual list: when set, menu items are generated on demand instead of read from menuItems,
+    // so only the WINDOW_SIZE rows on screen ever exist in RAM
+    void (*menuItemAt)(int index, MenuItem *ptr_menu_item);
+};
+
+// types of value a BoundScreenItem can point at
+#define BOUND_DOUBLE 0
+#define BOUND_INT 1
+
+/**
+ * @brief A screen item tied to a variable. Its text is only re-formatted when the variable changes
+ * at display precision, and only then is its row marked dirty for redrawing.
+ */
+struct BoundScreenItem
+{
+    MenuScreen *ptr_menu_screen;
+    uint8_t screen_item_index;
+    const void *ptr_value; // double or int, depending on type
+    uint8_t type;
+    uint8_t decimals; // digits after the point. for BOUND_INT the value is taken as already scaled
+    char suffix;      // appended unit, 0 for none
+    long last_scaled; // value the text was last formatted from
+    bool formatted;
 };
 
 bool initializeScreen(void);
 
-void drawMenuItem(MenuItem *ptr_menu_item, uint8_t pos_x, uint8_t pos_y);
+/**
+ * @brief Copy a menu item out of a screen's flash table into RAM, or generate it for a virtual list
+ *
+ * @param ptr_menu_screen pointer to the MenuScreen
+ * @param index index of the menu item
+ * @param ptr_menu_item pointer to the RAM MenuItem to fill
+ */
+void getMenuItem(MenuScreen *ptr_menu_screen, int index, MenuItem *ptr_menu_item);
+
+/**
+ * @brief Mode a menu item switches to when selected
+ *
+ * @param ptr_menu_screen pointer to the MenuScreen
+ * @param index index of the menu item
+ * @return int the mode
+ */
+int getMenuItemMode(MenuScreen *ptr_menu_screen, int index);
+
+void drawMenuItem(MenuItem *ptr_menu_item, bool highlighted, uint8_t pos_x, uint8_t pos_y);
 
 void drawScreenItem(ScreenItem *ptr_screen_item, uint8_t pos_x, uint8_t pos_y);
 
+void renderMenuScreen(MenuScreen *ptr_menu_screen);
+
 void drawMenuScreen(MenuScreen *ptr_menu_screen);
 
-void initializeMenuItem(MenuItem *ptr_menu_item, char *text, int text_length, int mode, bool highlighted);
+/**
+ * @brief Ask for only some pages (8 pixel rows each) of the display buffer to be sent to the screen.
+ * Menu screens draw one item per page, so bit i covers screenItems[i].
+ *
+ * @param page_mask bit i set: send page i
+ */
+void requestDisplayPagesFlush(uint8_t page_mask);
+
+/**
+ * @brief Ask for the display buffer to be sent to the screen. Does not block; the frame is sent
+ * a chunk at a time by stepDisplayFlush(). Asking again while a frame is in flight sends another once it's done.
+ */
+void requestDisplayFlush(void);
+
+/**
+ * @brief Send the next DISPLAY_FLUSH_BYTES_PER_STEP bytes of a requested frame over I2C. Call once per loop().
+ *
+ * Every I2C transaction is started and finished inside the call, so the bus is always idle
+ * in between steps and other devices on it (the DS3231) can be used freely.
+ *
+ * @return true: nothing left to send
+ * @return false: a frame is still in flight
+ */
+bool stepDisplayFlush(void);
+
+/**
+ * @brief Whether the last requested frame has been completely sent to the screen
+ */
+bool isDisplayFlushDone(void);
+
+void initializeScreenItem(ScreenItem *ptr_screen_item, const char *text, int text_length);
+
+/**
+ * @brief Set the text of one of a screen's items, marking its row dirty only if the text actually changed.
+ *
+ * @param ptr_menu_screen pointer to the MenuScreen
+ * @param index index of the screen item
+ * @param text null terminated text. truncated to STR_LEN - 1
+ */
+void setScreenItemText(MenuScreen *ptr_menu_screen, int index, const char *text);
+
+/**
+ * @brief Format a fixed point number without dtostrf/sprintf.
+ *
+ * @param scaled the value times 10^decimals, e.g. 1234 with 1 decimal is 123.4
+ * @param decimals number of digits after the point
+ * @param suffix unit character appended to the end. 0 for none
+ * @param buffer output. needs room for the digits, sign, point, suffix and terminator
+ * @return uint8_t length of the string written
+ */
+uint8_t formatFixed(long scaled, uint8_t decimals, char suffix, char *buffer);
 
-void initializeScreenItem(ScreenItem *ptr_screen_item, char *text, int text_length);
+/**
+ * @brief Round a double to a fixed point integer with the supplied number of decimals
+ */
+long toFixed(double value, uint8_t decimals);
 
-void initializeMenuScreen(MenuScreen *ptr_menu_screen, int numMenuItems, MenuItem *menuItems, int selectedMenuItemIndex, int numScreenItems, ScreenItem screenItems[]);
+/**
+ * @brief Re-format a bound screen item if its value changed at display precision.
+ *
+ * @param ptr_bound_item pointer to the bound item
+ * @return true: text changed and the row was marked dirty
+ * @return false: nothing to do
+ */
+bool updateBoundScreenItem(BoundScreenItem *ptr_bound_item);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef OVEN_MODEL_H
+#define OVEN_MODEL_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "segments.h"
+#include "reflow.h"
+
+/*
+Oven capability model.
+
+How fast this oven can heat, as a rate at every OVEN_MODEL_STEP_C from OVEN_MODEL_STEP_C up (linear in
+between, flat past the ends), and how fast it cools with the heater off. Kept in a CRC-checked EEPROM
+record after the settings and set over serial ("oven").
+
+predictSegments() plays a profile against the model: where the oven can't keep up, the run doesn't fail,
+it lags (a time based segment ends before the oven got there) or stretches (a gated segment waits longer
+than its nominal time, or past its timeout). Both show up as flags here, at edit time, instead of
+silently at run time, and the predicted times are what the preview graph and runtime show.
+
+record (at OVEN_MODEL_RECORD_ADDRESS, see writeRecordAt()):
+    | crc16 (2) | heat rates, 0.1 C/s (1) x OVEN_MODEL_POINTS | cool rate, 0.1 C/s (1) |
+*/
+
+#ifndef OVEN_MODEL_RECORD_ADDRESS
+#define OVEN_MODEL_RECORD_ADDRESS 3700 // after the settings record at its largest
+#endif
+
+#ifndef OVEN_MODEL_POINTS
+#define OVEN_MODEL_POINTS 5
+#endif
+
+#ifndef OVEN_MODEL_STEP_C
+#define OVEN_MODEL_STEP_C 50 // heat rate points at 50, 100, ... 250C
+#endif
+
+#ifndef OVEN_MODEL_CHUNK_C
+#define OVEN_MODEL_CHUNK_C 5 // heating time is added up this many degrees at a time
+#endif
+
+// typical small convection oven: slows down as it gets hotter
+#ifndef DEFAULT_OVEN_HEAT_RATES
+#define DEFAULT_OVEN_HEAT_RATES {25, 22, 18, 14, 10}
+#endif
+
+#ifndef DEFAULT_OVEN_COOL_RATE
+#define DEFAULT_OVEN_COOL_RATE 10
+#endif
+
+// predictSegments() flags
+#define OVEN_LAGS 0x01      // time based segment ends before the oven gets within its band
+#define OVEN_STRETCHES 0x02 // gated segment waits for the oven longer than its nominal time
+#define OVEN_TIMES_OUT 0x04 // gated or until-temp segment waits longer than its timeout
+
+struct OvenModel
+{
+    uint8_t heat[OVEN_MODEL_POINTS]; // 0.1 C/s at (i + 1) * OVEN_MODEL_STEP_C
+    uint8_t cool;                    // 0.1 C/s
+};
+
+extern OvenModel oven_model;
+
+struct OvenPrediction
+{
+    uint32_t end_s[MAX_PROFILE_SEGMENTS];   // when each segment is predicted to end, from the start of the run
+    uint16_t reach_s[MAX_PROFILE_SEGMENTS]; // how long into the segment the oven gets within its band
+    uint8_t flags[MAX_PROFILE_SEGMENTS];    // OVEN_ flags
+    uint32_t total_s;
+    uint8_t first_flagged; // first segment with OVEN_LAGS or OVEN_TIMES_OUT. num_segments: none
+};
+
+/**
+ * @brief Load the model from EEPROM. A missing or corrupt record gets the defaults.
+ */
+void loadOvenModel(void);
+
+void saveOvenModel(void);
+
+/**
+ * @brief Fastest the oven heats at a temperature, C/s
+ */
+float getOvenHeatRate(float temp_c);
+
+/**
+ * @brief Slowest heat rate between ambient and up_to_c, 0.1 C/s. What a ramp anywhere below up_to_c can count on.
+ */
+uint16_t getOvenMinHeatRate(int up_to_c);
+
+/**
+ * @brief Play a profile against the oven model
+ *
+ * @param start_c oven temperature the run starts from
+ */
+void predictSegments(const SegmentProfile *ptr_segments, float start_c, OvenPrediction *ptr_prediction);
+
+/**
+ * @brief Lengthen the preheat and soak times of a profile that the oven can't keep up with, so each stage
+ * lasts until the oven gets to it. Starts from PROFILE_GRAPH_AMBIENT_C. Capped at MAX_TIME_S.
+ *
+ * @return true: something was changed
+ */
+bool fitProfileToOven(ReflowProfile *ptr_profile);
+
+#endif
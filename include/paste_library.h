@@ -0,0 +1,77 @@
+#ifndef PASTE_LIBRARY_H
+#define PASTE_LIBRARY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "menu.h"
+#include "reflow.h"
+
+/*
+Built-in library of standard solder paste and bake profiles.
+
+The library is a read-only table in flash (PROGMEM). An entry only takes RAM while it is selected, as
+the SegmentProfile that gets run. Library profiles can be run straight from the run menu, and the ones
+shaped like preheat/soak/reflow can be copied into an EEPROM slot to be edited.
+
+Library profiles share profile_index with the EEPROM slots: LIBRARY_PROFILE_INDEX + n is library entry n.
+That is what the trace, journal and run checkpoint record.
+
+Temperatures follow the usual paste datasheet windows; gate band, timeout and abort come from the
+SETTING_GATE_ settings like every other profile.
+*/
+
+#define LIBRARY_PROFILE_INDEX 0x80
+
+#if NUM_REFLOW_PROFILES > LIBRARY_PROFILE_INDEX
+#error "NUM_REFLOW_PROFILES overlaps the library profile indexes"
+#endif
+
+#define LIBRARY_SAC305 0
+#define LIBRARY_SN63PB37 1
+#define LIBRARY_SNBI 2
+#define LIBRARY_BAKE_125C 3
+#define LIBRARY_BAKE_90C 4
+#define NUM_LIBRARY_PROFILES 5
+
+/**
+ * @brief Whether a profile index is a library entry rather than an EEPROM slot
+ */
+static inline bool isLibraryProfile(uint8_t profile_index)
+{
+    return profile_index >= LIBRARY_PROFILE_INDEX;
+}
+
+/**
+ * @brief Copy a library entry's name out of flash
+ *
+ * @param library_index LIBRARY_ entry
+ * @param buffer at least STR_LEN
+ */
+void getLibraryProfileName(uint8_t library_index, char *buffer);
+
+/**
+ * @brief One line summary of a library entry's segment for the run list, e.g. "Ramp 150C"
+ *
+ * @param library_index LIBRARY_ entry
+ * @param segment segment number
+ * @param buffer at least STR_LEN. " " past the last segment
+ */
+void describeLibrarySegment(uint8_t library_index, uint8_t segment, char *buffer);
+
+/**
+ * @brief Load a library entry's segments
+ *
+ * @param library_index LIBRARY_ entry
+ * @return false: no such entry
+ */
+bool loadLibraryProfile(uint8_t library_index, SegmentProfile *ptr_segments);
+
+/**
+ * @brief Convert a library entry into a preheat/soak/reflow profile for an EEPROM slot, see segmentsToProfile()
+ *
+ * @param library_index LIBRARY_ entry
+ * @return false: the entry isn't shaped like preheat/soak/reflow, e.g. a bake
+ */
+bool libraryToReflowProfile(uint8_t library_index, ReflowProfile *ptr_profile);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "run_plan.h"
+
+/*
+Run checkpoints for power-loss recovery.
+
+While a profile runs, its position in the run plan is written to the journal (JOURNAL_CHECKPOINT_ keys). Step
+changes and pauses are committed straight away; in between, the position is updated every
+RUN_CHECKPOINT_INTERVAL_S and committed at the journal's own rate, JOURNAL_COMMIT_INTERVAL_MS, so a resumed
+run may repeat up to that much of a step. A finished, cancelled or aborted run clears it.
+A checkpoint still there at boot means the run was cut off; it can be resumed if the oven is still within
+RESUME_TOLERANCE_C of the temperature it was at.
+
+JOURNAL_CHECKPOINT_STEP: step index (bits 0-7) | end_known (8) | gate_met (9) | rising (10) | run log part (11-15) | step end offset s (16-31)
+*/
+
+#ifndef RUN_CHECKPOINT_INTERVAL_S
+#define RUN_CHECKPOINT_INTERVAL_S 30 // how often the position is updated in RAM
+#endif
+
+#ifndef RESUME_TOLERANCE_C
+#define RESUME_TOLERANCE_C 20
+#endif
+
+struct RunCheckpoint
+{
+    uint8_t profile_index;
+    PlanPosition position;
+    uint8_t log_part; // run log file part being written
+    float temp_c;     // oven temperature when it was taken
+};
+
+/**
+ * @brief Record where a run is up to and commit the journal now
+ *
+ * @param profile_index slot being run
+ * @param now_s current time in seconds
+ * @param temp_c current oven temperature
+ */
+void saveRunCheckpoint(uint8_t profile_index, const PlanRun *ptr_run, uint32_t now_s, float temp_c);
+
+/**
+ * @brief Save a checkpoint if the run moved to another step, or update it uncommitted once
+ * RUN_CHECKPOINT_INTERVAL_S has passed. Call every tick of a run.
+ */
+void serviceRunCheckpoint(uint8_t profile_index, const PlanRun *ptr_run, uint32_t now_s, float temp_c);
+
+/**
+ * @brief Mark that no run is in progress. Committed with the next journal commit.
+ */
+void clearRunCheckpoint(void);
+
+/**
+ * @brief Read the checkpoint of a run that was cut off
+ *
+ * @return true: there is one
+ */
+bool findRunCheckpoint(RunCheckpoint *ptr_checkpoint);
+
+/**
+ * @brief Whether the oven is close enough to the checkpoint's temperature to carry on the run
+ *
+ * @param temp_c current oven temperature
+ */
+bool isCheckpointResumable(const RunCheckpoint *ptr_checkpoint, float temp_c);
+
+#endif
@@ -3,11 +3,11 @@
 
 #include <Arduino.h>
 
-// #include <EEPROM.h>
 #include "PID.h"
+#include "segments.h"
 
 #ifndef NUM_REFLOW_PROFILES
-#define NUM_REFLOW_PROFILES 10
+#define NUM_REFLOW_PROFILES 100
 #endif
 
 #ifndef MAX_TEMP_C
@@ -62,6 +62,32 @@
 #define DEFAULT_REFLOW_TEMP 225
 #endif
 
+// stage gates, see segments.h. GATE_TIME is how every stage ran before gates
+#ifndef DEFAULT_PREHEAT_GATE
+#define DEFAULT_PREHEAT_GATE GATE_TIME
+#endif
+
+#ifndef DEFAULT_SOAK_GATE
+#define DEFAULT_SOAK_GATE GATE_TIME
+#endif
+
+#ifndef DEFAULT_REFLOW_GATE
+#define DEFAULT_REFLOW_GATE GATE_TIME
+#endif
+
+// defaults of the gate settings shared by every stage (SETTING_GATE_*)
+#ifndef DEFAULT_GATE_BAND_C
+#define DEFAULT_GATE_BAND_C 5
+#endif
+
+#ifndef DEFAULT_GATE_TIMEOUT_S
+#define DEFAULT_GATE_TIMEOUT_S 300 // 0: wait forever
+#endif
+
+#ifndef DEFAULT_GATE_ABORT
+#define DEFAULT_GATE_ABORT 1 // 0: carry on after a timeout
+#endif
+
 extern bool reflow_profile_running;
 
 struct ReflowProfile
@@ -73,38 +99,83 @@ struct ReflowProfile
     int soak_time_s;
     int reflow_temp;
     int reflow_hold_time_s;
+    // SegmentGate of each stage; when its time starts counting
+    uint8_t preheat_gate;
+    uint8_t soak_gate;
+    uint8_t reflow_gate;
 };
 
 extern ReflowProfile default_reflow_profile;
 
+/*
+Packed profile encoding, little-endian bit order:
+    fan_on (1) | preheat_temp_c (9) | preheat_time_s (10) | soak_temp_c (9) | soak_time_s (10) | reflow_temp (9) | reflow_hold_time_s (10)
+    | preheat_gate (2) | soak_gate (2) | reflow_gate (2)
+64 bits in 8 bytes. The gates were spare bits written as 0 before, so older records read as GATE_TIME.
+*/
+#define PACKED_PROFILE_SIZE 8
+#define PACKED_TEMP_BITS 9  // 0 - 511 C
+#define PACKED_TIME_BITS 10 // 0 - 1023 s
+#define PACKED_GATE_BITS 2
+
+#if MAX_TEMP_C > 511 || MAX_TIME_S > 1023
+#error "MAX_TEMP_C/MAX_TIME_S no longer fit the packed profile encoding"
+#endif
+
 /*!
-    @brief  Verifies if the data in a Reflow profile is proper
+    @brief  Encode a profile into PACKED_PROFILE_SIZE bytes. Fields are clamped to what fits (0 - 511C, 0 - 1023s).
 
-    @param ptr_profile_to_check pointer to the profile to verify.
+    @param ptr_profile pointer to the profile to encode
+    @param packed output buffer, PACKED_PROFILE_SIZE bytes
 
+    @return None
+*/
+void packProfile(ReflowProfile *ptr_profile, uint8_t packed[PACKED_PROFILE_SIZE]);
 
-    @return boolean; whether the supplied ReflowProfile Passes
+/*!
+    @brief  Decode a profile written by packProfile()
+
+    @param packed input buffer, PACKED_PROFILE_SIZE bytes
+    @param ptr_profile pointer to the profile to fill
+
+    @return None
 */
-bool isProfileValid(ReflowProfile *ptr_profile_to_check);
+void unpackProfile(const uint8_t packed[PACKED_PROFILE_SIZE], ReflowProfile *ptr_profile);
+
+/*!
+    @brief  Convert a preheat/soak/reflow profile into segments: hold at preheat, hold at soak,
+    hold until the oven reaches reflow temp, then hold there. Every segment gets the profile's fan setting,
+    the holds get their stage's gate, and band/timeout/abort come from the SETTING_GATE_ settings.
+
+    @param ptr_profile pointer to the profile to convert
+    @param ptr_segments pointer to the segment profile to fill
+
+    @return None
+*/
+void profileToSegments(ReflowProfile *ptr_profile, SegmentProfile *ptr_segments);
 
 /*!
-    @brief  Saves the supplied array of profiles to specified address
+    @brief  Convert segments back into the nearest preheat/soak/reflow profile, e.g. to save a library or
+    synthesized profile in a slot. They have to be: ramp or hold, ramp or hold, ramp or hold-until-temp up to
+    the peak, hold at the peak, then only cooling. Each stage time is how long its segment takes from the
+    previous target, starting at PROFILE_GRAPH_AMBIENT_C; ramp rates and controlled cooling are lost.
 
+    @param ptr_segments pointer to the segments to convert
+    @param ptr_profile pointer to the profile to fill
 
-    @return boolean; success/fail
+    @return boolean; false if the segments aren't shaped like that, or the result isn't a valid profile
 */
-bool saveProfilesToEEPROM(ReflowProfile profiles_array[], int num_of_profiles, int address);
-
-/**
- * @brief Get the reflow Profiles From EEPROM. stores them into the provided array
- *
- * @param profiles_array array to store the profiles retrieved from EEPROM
- * @param num_of_profiles the number of profiles that should exist
- * @param address the address on EEPROM that the profiles exist at
- * @return true. success
- * @return false. failure
- */
-bool getProfilesFromEEPROM(ReflowProfile profiles_array[], int num_of_profiles, int address);
+bool segmentsToProfile(const SegmentProfile *ptr_segments, ReflowProfile *ptr_profile);
+
+/*!
+    @brief  Verifies if the data in a Reflow profile is proper
+
+    @param ptr_profile_to_check pointer to the profile to verify.
+
+
+    @return boolean; whether the supplied ReflowProfile Passes
+*/
+bool isProfileValid(ReflowProfile *ptr_profile_to_check);
 
 /*!
     @brief attaches all the default reflow profile values to the default profile
@@ -0,0 +1,150 @@
+#ifndef RUN_LOG_H
+#define RUN_LOG_H
+
+// no Arduino.h: the logger core also builds on a host, see tools/run_log_bench.cpp
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+Full-resolution run logger.
+
+Every PID tick of a run is appended as a fixed-size record to a RAM block. Full blocks are handed to a
+storage backend (SD card on the oven, a plain file on a host) a chunk at a time from serviceRunLog(),
+so the control tick never waits for a whole block write. Two blocks are kept: one filling, one draining.
+If both are busy the record is dropped and counted.
+
+Files only ever receive whole blocks, so on an SD card every write lines up with a sector. A run gets
+its own file, RUNnnnnn.Lpp; after RUN_LOG_MAX_FILE_BLOCKS blocks the part number pp goes up and a new
+file is started. Every RUN_LOG_FLUSH_BLOCKS blocks the file is flushed, so its size is on the card and a
+power cut only loses what came after.
+
+block (RUN_LOG_BLOCK_SIZE bytes):
+    | magic "RL" (2) | run number (2) | block sequence (2) | record count (1) | record size (1) | records | zero padding |
+record (RUN_LOG_RECORD_SIZE bytes), little-endian:
+    | ms since start (4) | temp C (f32) | target C (f32) | P (f32) | I (f32) | D (f32) | output (f32) | heater (1) | fan (1) |
+*/
+
+#ifndef RUN_LOG_BLOCK_SIZE
+#define RUN_LOG_BLOCK_SIZE 512
+#endif
+
+#ifndef RUN_LOG_WRITE_CHUNK
+#define RUN_LOG_WRITE_CHUNK 64 // bytes handed to the backend per serviceRunLog() call
+#endif
+
+#ifndef RUN_LOG_MAX_FILE_BLOCKS
+#define RUN_LOG_MAX_FILE_BLOCKS 2048 // 1MB per file
+#endif
+
+#ifndef RUN_LOG_FLUSH_BLOCKS
+#define RUN_LOG_FLUSH_BLOCKS 4 // an SD flush rewrites the directory entry and FAT; a few ms each time
+#endif
+
+#define RUN_LOG_MAGIC 0x4C52 // "RL"
+#define RUN_LOG_HEADER_SIZE 8
+#define RUN_LOG_RECORD_SIZE 30
+#define RUN_LOG_RECORDS_PER_BLOCK ((RUN_LOG_BLOCK_SIZE - RUN_LOG_HEADER_SIZE) / RUN_LOG_RECORD_SIZE)
+#define RUN_LOG_NAME_LEN 13 // 8.3 name and terminator
+
+struct RunLogSample
+{
+    uint32_t ms; // since the run started
+    float temp_c;
+    float target_c;
+    float p_term;
+    float i_term;
+    float d_term;
+    float output;
+    bool heater_on;
+    bool fan_on;
+};
+
+/**
+ * @brief Where finished blocks go. All functions return false on failure; logging then stops until the next run.
+ */
+struct RunLogBackend
+{
+    bool (*open)(const char *name);                     // create a new file
+    bool (*write)(const uint8_t *data, uint16_t length); // append
+    bool (*flush)(void);                                // make what was appended so far survive a power cut
+    bool (*close)(void);                                // flush and close the open file
+};
+
+struct RunLogStats
+{
+    uint32_t records;         // logged this run
+    uint32_t dropped_records; // lost because both blocks were busy
+    uint16_t blocks;          // written this run
+    uint8_t files;            // opened this run
+    bool failed;              // backend returned an error; logging stopped
+};
+
+/**
+ * @brief Pick the storage backend. NULL disables logging.
+ */
+void setRunLogBackend(const RunLogBackend *ptr_backend);
+
+/**
+ * @brief Open the first file of a run and start logging. Ends a run still being logged.
+ *
+ * @param run_number used in the file names and block headers
+ * @param first_part part number of the first file. 0 for a new run; a resumed run carries on after the parts it already wrote
+ * @return true: logging
+ * @return false: no backend, or the file couldn't be created
+ */
+bool beginRunLog(uint16_t run_number, uint8_t first_part);
+
+/**
+ * @brief Append one sample. Only copies into RAM; never calls the backend.
+ */
+void logRunSample(const RunLogSample *ptr_sample);
+
+/**
+ * @brief Hand at most RUN_LOG_WRITE_CHUNK bytes of a finished block to the backend. Call every loop().
+ */
+void serviceRunLog(void);
+
+/**
+ * @brief Write out everything still buffered, including the partly filled block, and close the file. Blocks until done.
+ */
+void endRunLog(void);
+
+bool isRunLogActive(void);
+
+/**
+ * @brief Part number of the file being written, or last written
+ */
+uint8_t getRunLogPart(void);
+
+/**
+ * @brief Counters for the current (or last) run
+ */
+const RunLogStats *getRunLogStats(void);
+
+#ifdef ARDUINO
+extern const RunLogBackend run_log_sd_backend;
+
+/**
+ * @brief Start the SD card and log to it
+ *
+ * @param cs_pin SD card chip select
+ * @return true: card found, logging enabled
+ */
+bool beginSdRunLog(uint8_t cs_pin);
+#else
+extern const RunLogBackend run_log_file_backend;
+
+/**
+ * @brief Directory the host file backend writes into. Default is the working directory.
+ */
+void setRunLogDirectory(const char *path);
+#endif
+
+/**
+ * @brief Name of a run's log file part, e.g. RUN00012.L00
+ *
+ * @param name at least RUN_LOG_NAME_LEN
+ */
+void runLogFileName(uint16_t run_number, uint8_t part, char *name);
+
+#endif
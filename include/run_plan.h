@@ -0,0 +1,144 @@
+#ifndef RUN_PLAN_H
+#define RUN_PLAN_H
+
+// no Arduino.h: like the segment engine, this also builds on a host
+#include <stdint.h>
+#include <stddef.h>
+#include "segments.h"
+
+/*
+Compiled run plan.
+
+When Run is pressed, the segment profile is validated once and compiled into a RunPlan: every step's
+starting setpoint, signed ramp slope, duration, and gate parameters are worked out up front. The setpoint
+a segment starts from never depends on the oven (only the first one starts at the oven temperature), so
+this is all known before the run starts.
+
+Each tick, stepRunPlan() then only compares the time against the current step's end time and, on ramps,
+does one multiply-add for the setpoint. Steps advance incrementally; nothing is re-derived from the profile.
+*/
+
+// compileRunPlan() results
+#define PLAN_OK 0
+#define PLAN_EMPTY 1      // no segments, or more than MAX_PROFILE_SEGMENTS
+#define PLAN_BAD_TYPE 2   // unknown segment type
+#define PLAN_BAD_GATE 3   // unknown gate
+#define PLAN_BAD_TARGET 4 // target outside the allowed range
+#define PLAN_TOO_LONG 5   // time based steps add up to more than PLAN_MAX_DURATION_S
+
+#ifndef PLAN_MAX_DURATION_S
+#define PLAN_MAX_DURATION_S (24UL * 60 * 60)
+#endif
+
+struct PlanStep
+{
+    uint8_t type; // SegmentType
+    bool fan_on;
+    uint8_t gate; // SegmentGate
+    bool abort_on_timeout;
+    uint8_t band_c;
+    uint16_t timeout_s; // 0: wait forever
+    int16_t target_c;
+    float start_c;       // setpoint when the step starts
+    float slope_c_per_s; // SEGMENT_RAMP setpoint change per second, signed. 0 otherwise
+    uint32_t duration_s; // SEGMENT_RAMP: time to reach target_c. SEGMENT_HOLD: hold time. otherwise 0
+};
+
+struct RunPlan
+{
+    uint8_t num_steps;
+    uint8_t error_step; // step compileRunPlan() stopped at when it failed
+    uint32_t timed_s;   // total of the time based steps; the run takes at least this long
+    PlanStep steps[MAX_PROFILE_SEGMENTS];
+};
+
+/**
+ * @brief Where a running plan is up to
+ */
+struct PlanRun
+{
+    uint8_t index;         // current step; num_steps once finished
+    uint32_t step_start_s; // when the current step started
+    uint32_t step_end_s;   // when a time based step finishes, once known
+    bool end_known;        // step_end_s is valid; gated steps only know it once the gate is met
+    float setpoint_c;      // setpoint to hand to the PID
+    bool rising;           // SEGMENT_HOLD_UNTIL_TEMP: waiting for the oven to come up rather than down
+    bool gate_met;         // oven has been within the current step's band
+    bool timed_out;        // run stopped because a gate or SEGMENT_HOLD_UNTIL_TEMP timed out
+    bool paused;           // setpoint held and the step clock frozen
+    uint32_t paused_s;     // when it was paused
+};
+
+/**
+ * @brief Where a run is up to within its plan, independent of the clock. Saved as a checkpoint
+ * so a run can be picked up again with seekRunPlan() after a reset.
+ */
+struct PlanPosition
+{
+    uint8_t index;         // current step
+    bool end_known;        // see PlanRun
+    bool gate_met;         // see PlanRun
+    bool rising;           // see PlanRun
+    uint32_t elapsed_s;    // seconds into the step
+    uint16_t end_offset_s; // step end relative to its start, when end_known; at most UINT16_MAX
+};
+
+/**
+ * @brief Validate a segment profile and compile it into a plan
+ *
+ * @param start_c oven temperature the first segment starts from
+ * @param min_c lowest allowed target
+ * @param max_c highest allowed target
+ * @return uint8_t PLAN_OK, or the PLAN_ error; ptr_plan->error_step says which segment
+ */
+uint8_t compileRunPlan(const SegmentProfile *ptr_profile, float start_c, int min_c, int max_c, RunPlan *ptr_plan);
+
+/**
+ * @brief Start running a compiled plan
+ *
+ * @param now_s current time in seconds
+ * @param temp_c current oven temperature
+ */
+void beginRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, uint32_t now_s, float temp_c);
+
+/**
+ * @brief Advance the run to now_s and update setpoint_c. Finished steps are skipped in the same call,
+ * so zero-length steps never cost a tick.
+ *
+ * @param now_s current time in seconds
+ * @param temp_c current oven temperature
+ * @return true: still running
+ * @return false: every step is finished, or a timeout aborted the run (timed_out is set)
+ */
+bool stepRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, uint32_t now_s, float temp_c);
+
+/**
+ * @brief Hold the current setpoint and freeze the step clock. stepRunPlan() changes nothing while paused.
+ */
+void pauseRunPlan(PlanRun *ptr_run, uint32_t now_s);
+
+/**
+ * @brief Carry on from where pauseRunPlan() stopped. The paused time doesn't count toward any step or timeout.
+ */
+void resumeRunPlan(PlanRun *ptr_run, uint32_t now_s);
+
+/**
+ * @brief Read a run's position, for a checkpoint. A step whose end is more than UINT16_MAX s after its start
+ * (a long wait for a temperature gate) is given a later start, so the time it has left is kept.
+ */
+void getRunPlanPosition(const PlanRun *ptr_run, uint32_t now_s, PlanPosition *ptr_position);
+
+/**
+ * @brief Put a run begun with beginRunPlan() back where a checkpoint left off. The step carries on
+ * from the same number of seconds in; the time the oven was off doesn't count.
+ *
+ * @return false: the position doesn't fit this plan; the run is left at its start
+ */
+bool seekRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, const PlanPosition *ptr_position, uint32_t now_s);
+
+/**
+ * @brief Fan setting of the current step. Off once the run is finished.
+ */
+bool isRunPlanFanOn(const PlanRun *ptr_run, const RunPlan *ptr_plan);
+
+#endif
@@ -2,57 +2,95 @@
 #define SCREENS_H
 
 #include "menu.h"
+#include "reflow.h"
 
 // currently selected index
 extern int index_to_highlight;
 
 // status screen
-extern ScreenItem *status_screen_items;
+extern ScreenItem status_screen_items[];
 extern MenuScreen status_screen;
 
 // home screen
-extern MenuItem *home_screen_menu_items;
+extern const MenuItem home_screen_menu_items[] PROGMEM;
 extern MenuScreen home_screen;
-extern ScreenItem *home_screen_items;
+extern ScreenItem home_screen_items[];
 
 // run reflow screen
-extern MenuItem *run_reflow_screen_menu_items;
 extern MenuScreen run_reflow_screen;
-extern ScreenItem *run_reflow_screen_items;
+extern ScreenItem run_reflow_screen_items[];
 
 // profile selected to run Screen
-extern MenuItem *selected_to_run_menu_items;
+extern const MenuItem selected_to_run_menu_items[] PROGMEM;
 extern MenuScreen selected_to_run_screen;
-extern ScreenItem *selected_to_run_screen_items;
+extern ScreenItem selected_to_run_screen_items[];
 
 // edit PID screen
-extern MenuItem *edit_pid_menu_items;
+extern const MenuItem edit_pid_menu_items[] PROGMEM;
 extern MenuScreen edit_pid_screen;
-extern ScreenItem *edit_pid_screen_items;
+extern ScreenItem edit_pid_screen_items[];
 
 // edit reflow profile screen
-extern MenuItem *edit_reflow_menu_items;
+extern const MenuItem edit_reflow_menu_items[] PROGMEM;
 extern MenuScreen edit_reflow_screen;
-extern ScreenItem *edit_reflow_screen_items;
+extern ScreenItem edit_reflow_screen_items[];
 
 // select profile to edit screen
-extern MenuItem *select_profile_to_edit_menu_items;
 extern MenuScreen select_profile_to_edit_screen;
-extern ScreenItem *select_profile_to_edit_screen_items;
+extern ScreenItem select_profile_to_edit_screen_items[];
 
-void initializeStatusScreen();
-void initializeHomeScreen();
-void initializeRunReflowScreen();
-void initializeSelectedToRunScreen();
-void initializeEditPIDScreen();
-void initializeEditReflowScreen();
-void initializeSelectProfileToEditScreen();
+// edit settings screen
+extern MenuScreen edit_settings_screen;
+extern ScreenItem edit_settings_screen_items[];
+
+// resume run screen
+extern const MenuItem resume_run_menu_items[] PROGMEM;
+extern MenuScreen resume_run_screen;
+extern ScreenItem resume_run_screen_items[];
+
+/**
+ * @brief virtual list generators for the run reflow and select profile to edit screens.
+ * Item 0 is "Cancel". In the edit list item i is profile i; the run list has the library profiles first, see runListProfileIndex().
+ *
+ * @param index index of the item in the list
+ * @param ptr_menu_item pointer to the MenuItem to fill
+ */
+void runReflowMenuItemAt(int index, MenuItem *ptr_menu_item);
+void selectProfileToEditMenuItemAt(int index, MenuItem *ptr_menu_item);
+
+/**
+ * @brief virtual list generator for the edit settings screen: "Cancel", the settings, "Save"
+ */
+void editSettingsMenuItemAt(int index, MenuItem *ptr_menu_item);
+
+/**
+ * @brief profile_index of a run list item: a library profile (see paste_library.h) or an EEPROM slot
+ *
+ * @param index item index, 1 or more
+ */
+uint8_t runListProfileIndex(int index);
+
+/**
+ * @brief build the cached preview graph and the peak/runtime/fan labels for the profile selected to run.
+ * Call whenever the selected profile changes; drawing the screen afterwards does no formatting.
+ *
+ * @param ptr_profile pointer to the selected profile
+ */
+void populateSelectedToRunScreen(ReflowProfile *ptr_profile);
+
+/**
+ * @brief same as populateSelectedToRunScreen(), for a profile that is already segments (a library profile)
+ */
+void populateSelectedToRunSegments(const SegmentProfile *ptr_segments);
 
 /**
- * @brief run all the initialization methods to create all the screens
+ * @brief fill in which profile and step a cut off run was at, and the oven temperature it was at then
  *
+ * @param profile_index slot of the profile
+ * @param step_index step of the run plan
+ * @param temp_c oven temperature at the checkpoint
  */
-void initializeAllScreens();
+void populateResumeRunScreen(uint8_t profile_index, uint8_t step_index, float temp_c);
 
 void set_item_to_highlight(MenuScreen *screen, int index);
 void increment_highlight(MenuScreen *screen);
@@ -0,0 +1,72 @@
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+// no Arduino.h: segment profiles are also built on a host
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+N-segment ramp/soak profiles.
+
+A profile is a list of segments run one after the other. Each segment drives the setpoint toward its
+target_c and says when it is finished:
+    SEGMENT_RAMP            setpoint moves from where the last segment left it to target_c at value/10 C/s. value 0 steps straight there
+    SEGMENT_HOLD            setpoint sits at target_c for value seconds
+    SEGMENT_HOLD_UNTIL_TEMP setpoint sits at target_c until the oven reaches it, from whichever side it started on
+    SEGMENT_COOLDOWN        heater off until the oven drops to target_c
+Every segment has its own fan setting.
+
+Ramps and holds also have a gate, which decides when their time counts:
+    GATE_TIME          from when the segment starts (a loaded oven may still be on its way)
+    GATE_TEMP          only once the oven is within +-band_c of target_c, so a hold is a real dwell at temperature
+    GATE_TIME_AND_TEMP from the start, but the segment can't end before the oven has been within the band
+A gate, and SEGMENT_HOLD_UNTIL_TEMP, wait at most timeout_s (0: forever). Then the run either aborts or
+carries on as if the temperature had been reached, per abort_on_timeout.
+
+Profiles are not run directly; they are compiled into a RunPlan first, see run_plan.h.
+*/
+
+#ifndef MAX_PROFILE_SEGMENTS
+#define MAX_PROFILE_SEGMENTS 8
+#endif
+
+#ifndef COOLDOWN_SETPOINT_C
+#define COOLDOWN_SETPOINT_C 0 // setpoint during SEGMENT_COOLDOWN; low enough that the PID never heats
+#endif
+
+enum SegmentType
+{
+    SEGMENT_RAMP = 0,
+    SEGMENT_HOLD,
+    SEGMENT_HOLD_UNTIL_TEMP,
+    SEGMENT_COOLDOWN,
+    NUM_SEGMENT_TYPES
+};
+
+enum SegmentGate
+{
+    GATE_TIME = 0,
+    GATE_TEMP,
+    GATE_TIME_AND_TEMP,
+    NUM_GATES
+};
+
+struct ProfileSegment
+{
+    uint8_t type; // SegmentType
+    bool fan_on;
+    int16_t target_c;
+    uint16_t value; // SEGMENT_RAMP: rate in 0.1 C/s. SEGMENT_HOLD: seconds. otherwise unused
+    uint8_t gate;   // SegmentGate; SEGMENT_RAMP and SEGMENT_HOLD only
+    uint8_t band_c; // gate tolerance either side of target_c
+    uint16_t timeout_s;
+    bool abort_on_timeout;
+};
+
+struct SegmentProfile
+{
+    uint8_t num_segments;
+    ProfileSegment segments[MAX_PROFILE_SEGMENTS];
+};
+
+#endif
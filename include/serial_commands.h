@@ -0,0 +1,27 @@
+#ifndef SERIAL_COMMANDS_H
+#define SERIAL_COMMANDS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Text commands over the serial port, one per line:
+    help            list commands
+    trace [run]     dump the stored run traces as CSV (see trace.h)
+    journal         print the run counters and totals (see journal.h)
+    get [key]       print one or all settings (see settings.h)
+    set key value   change a setting and save it
+
+binary frames for the host provisioning tool share the port; see serial_protocol.h.
+*/
+
+#ifndef SERIAL_COMMAND_MAX_LENGTH
+#define SERIAL_COMMAND_MAX_LENGTH 32
+#endif
+
+/**
+ * @brief Read whatever serial input is waiting and run any complete command lines. Call every loop().
+ */
+void serviceSerialCommands(void);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SERIAL_PROTOCOL_H
+#define SERIAL_PROTOCOL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Binary profile/PID protocol on the serial port, for provisioning ovens from a host
+(see tools/reflow_link.py). Shares the port with the text commands: a frame can start
+wherever a text line could.
+
+frame:
+    | sync 0xA5 | payload length (1) | command (1) | payload | crc16 (2) |
+crc is CRC-16/CCITT (crc16() in storage.h), starting at 0xFFFF, over length, command and payload.
+all multi-byte fields are little-endian.
+
+every request gets one reply frame with command | PROTOCOL_REPLY and a status byte first in the payload.
+
+commands:
+    PING            ->  status | protocol version (1) | number of profile slots (1)
+    READ_PROFILE    slot (1)  ->  status | slot (1) | profile (14)
+    WRITE_PROFILE   slot (1) | profile (14, or 13 without gates)  ->  status | slot (1)
+    READ_PID        ->  status | PID constants (16)
+    WRITE_PID       PID constants (16)  ->  status
+
+profile (14): fan_on (1) | preheat_temp_c (2) | preheat_time_s (2) | soak_temp_c (2) | soak_time_s (2) | reflow_temp (2) | reflow_hold_time_s (2)
+    | gates (1): preheat_gate bits 0-1, soak_gate bits 2-3, reflow_gate bits 4-5. version 1 had no gates byte
+PID constants (16): PID_k | PID_i | PID_d | threshold, each an IEEE 754 float (4)
+*/
+
+#define PROTOCOL_SYNC 0xA5
+#define PROTOCOL_VERSION 2
+#define PROTOCOL_MAX_PAYLOAD 32
+#define PROTOCOL_REPLY 0x80
+
+#ifndef PROTOCOL_FRAME_TIMEOUT_MS
+#define PROTOCOL_FRAME_TIMEOUT_MS 250 // a frame stalled this long is dropped
+#endif
+
+// commands
+#define PROTOCOL_PING 0x01
+#define PROTOCOL_READ_PROFILE 0x10
+#define PROTOCOL_WRITE_PROFILE 0x11
+#define PROTOCOL_READ_PID 0x20
+#define PROTOCOL_WRITE_PID 0x21
+
+// reply status
+#define PROTOCOL_OK 0
+#define PROTOCOL_BAD_CRC 1
+#define PROTOCOL_UNKNOWN_COMMAND 2
+#define PROTOCOL_BAD_LENGTH 3
+#define PROTOCOL_BAD_SLOT 4
+#define PROTOCOL_INVALID_VALUE 5 // failed isProfileValid()/is_PID_constants_valid(); nothing written
+#define PROTOCOL_BUSY 6          // oven is running; nothing written
+#define PROTOCOL_EMPTY_SLOT 7    // read: slot has no stored profile; the default is returned
+
+#define PROTOCOL_PROFILE_SIZE 14
+#define PROTOCOL_V1_PROFILE_SIZE 13 // without the gates byte
+#define PROTOCOL_PID_SIZE 16
+
+/**
+ * @brief Is a frame partially received. While it is, every serial byte belongs to it.
+ */
+bool isProtocolFrameActive(void);
+
+/**
+ * @brief Feed one byte from the serial port. The first byte of a frame must be PROTOCOL_SYNC.
+ * Once a whole frame is in, it is handled and the reply is written to Serial.
+ *
+ * @param data received byte
+ */
+void feedProtocolByte(uint8_t data);
+
+#endif
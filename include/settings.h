@@ -0,0 +1,128 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "menu.h"
+
+/*
+Runtime settings registry.
+
+Each setting has a definition in flash (name, range, default) and a value in RAM, loaded from
+an EEPROM record at boot. The compile-time constants they replace are now just the defaults.
+Reads are a plain array lookup, so getSetting() is fine in the hot path.
+
+record (at SETTINGS_RECORD_ADDRESS, see writeRecordAt()):
+    | crc16 (2) | number of values (1) | value (2) x number of values |
+a record with fewer values than NUM_SETTINGS (older firmware) keeps the ones it has; the rest get defaults.
+*/
+
+#ifndef SETTINGS_RECORD_ADDRESS
+#define SETTINGS_RECORD_ADDRESS 3664 // right after the journal
+#endif
+
+// setting ids. append only; the id is the position in the record
+#define SETTING_PID_PERIOD_MS 0      // MS_BETWEEN_PID
+#define SETTING_THERMO_READ_MS 1     // MIN_TIME_BETWEEN_THERMO_READ
+#define SETTING_SHIMMY_PERIOD_MS 2   // SHIMMY_PERIOD
+#define SETTING_THERMOCOUPLE_TYPE 3  // MAX31856_TCTYPE_B - MAX31856_TCTYPE_T
+#define SETTING_BUTTON_DEBOUNCE_MS 4 // BUTTON_DEBOUNCE_MS
+#define SETTING_GATE_BAND_C 5        // DEFAULT_GATE_BAND_C
+#define SETTING_GATE_TIMEOUT_S 6     // DEFAULT_GATE_TIMEOUT_S
+#define SETTING_GATE_ABORT 7         // DEFAULT_GATE_ABORT
+#define SETTING_BATCH_RUNS 8         // DEFAULT_BATCH_RUNS
+#define SETTING_STANDBY_C 9          // DEFAULT_STANDBY_C
+#define SETTING_START_WINDOW_C 10    // DEFAULT_START_WINDOW_C
+#define NUM_SETTINGS 11
+
+#define SETTINGS_MAX_STORED 15 // (RECORD_MAX_PAYLOAD - 1) / 2
+
+// how a value is shown and edited
+#define SETTING_TYPE_MS 0
+#define SETTING_TYPE_THERMOCOUPLE 1 // shown as the type letter
+#define SETTING_TYPE_C 2
+#define SETTING_TYPE_S 3
+#define SETTING_TYPE_ON_OFF 4
+#define SETTING_TYPE_COUNT 5 // plain number
+
+#ifndef SETTING_KEY_LEN
+#define SETTING_KEY_LEN 12
+#endif
+
+struct SettingDef
+{
+    char name[STR_LEN];        // menu label
+    char key[SETTING_KEY_LEN]; // serial name
+    uint8_t type;
+    uint8_t step; // one edit step, before button acceleration
+    uint16_t min;
+    uint16_t max;
+    uint16_t default_value;
+};
+
+extern const SettingDef setting_defs[NUM_SETTINGS] PROGMEM;
+extern uint16_t setting_values[NUM_SETTINGS];
+
+/**
+ * @brief Current value of a setting
+ *
+ * @param id SETTING_ id
+ */
+static inline uint16_t getSetting(uint8_t id)
+{
+    return setting_values[id];
+}
+
+/**
+ * @brief Load the settings from EEPROM. Missing, corrupt or out of range values get their default.
+ * Applies them, see applySettings().
+ */
+void loadSettings(void);
+
+/**
+ * @brief Write all settings to EEPROM
+ */
+void saveSettings(void);
+
+/**
+ * @brief Change a setting in RAM and apply it. Not saved until saveSettings().
+ *
+ * @param id SETTING_ id
+ * @param value new value
+ * @return true: set
+ * @return false: unknown id or value out of range; nothing changed
+ */
+bool setSetting(uint8_t id, uint16_t value);
+
+/**
+ * @brief Push settings that aren't read through getSetting() to where they're used (thermocouple, button ISR)
+ */
+void applySettings(void);
+
+/**
+ * @brief Copy a setting's definition out of flash
+ */
+void getSettingDef(uint8_t id, SettingDef *ptr_def);
+
+/**
+ * @brief Find a setting by its serial key
+ *
+ * @return int SETTING_ id, -1 if there's none
+ */
+int findSetting(const char *key);
+
+/**
+ * @brief Format a setting's value for display, e.g. "500ms", "K", "On" or "10"
+ *
+ * @param buffer at least STR_LEN
+ */
+void formatSetting(uint8_t id, char *buffer);
+
+/**
+ * @brief Parse a value typed over serial ("500", a thermocouple letter, "on"/"off")
+ *
+ * @return true: parsed and set
+ */
+bool parseSetting(uint8_t id, const char *text);
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "PID.h"
+#include "reflow.h"
+
+/*
+EEPROM record store.
+
+layout:
+    header  | magic (2) | layout version (1) | number of profile slots (1) |
+    record  | crc16 (2) | PID_Constants |
+    record  | crc16 (2) | packed profile (PACKED_PROFILE_SIZE) |  x NUM_REFLOW_PROFILES
+
+each record has its own CRC, so one torn write only loses that record. the CRC is seeded with
+the record id, so a record read from the wrong slot never passes.
+profiles are stored packed (see packProfile()) so 100 of them fit in about 1KB.
+*/
+
+#ifndef STORE_BASE_ADDRESS
+#define STORE_BASE_ADDRESS EEPROM_INITIAL_ADDRESS
+#endif
+
+#ifndef STORE_MAGIC
+#define STORE_MAGIC 0x5246 // "RF"
+#endif
+
+// bump whenever a record struct or the layout changes, and add a step to migrateStore()
+#ifndef STORE_LAYOUT_VERSION
+#define STORE_LAYOUT_VERSION 3
+#endif
+
+// record ids
+#define RECORD_PID_CONSTANTS 0
+#define RECORD_PROFILE(index) (1 + (index))
+// records other modules keep at their own addresses, outside the store (see readRecordAt())
+#define RECORD_SETTINGS 0xF0
+#define RECORD_OVEN_MODEL 0xF1
+#define RECORD_LEARNING(slot) (0xF2 + (slot))
+
+#define RECORD_MAX_PAYLOAD 32
+
+// results of beginStore()
+#define STORE_OK 0
+#define STORE_FORMATTED 1 // no store found; empty store written. records need defaults
+#define STORE_MIGRATED 2  // older layout converted to the current one
+
+struct StoreHeader
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t num_profiles;
+};
+
+/**
+ * @brief counts up on every writeProfileRecord(), so screens holding a copy of a profile know to reload it
+ */
+extern uint8_t profile_write_count;
+
+// first address after the store. other EEPROM users go above this
+#define STORE_END_ADDRESS (STORE_BASE_ADDRESS + sizeof(StoreHeader) + sizeof(uint16_t) + sizeof(PID_Constants) + NUM_REFLOW_PROFILES * (sizeof(uint16_t) + PACKED_PROFILE_SIZE))
+
+/**
+ * @brief CRC-16/CCITT, one byte at a time
+ *
+ * @param crc running crc. start with 0xFFFF
+ * @param data next byte
+ * @return uint16_t updated crc
+ */
+uint16_t crc16Update(uint16_t crc, uint8_t data);
+
+/**
+ * @brief CRC-16/CCITT over a buffer
+ */
+uint16_t crc16(uint16_t crc, const void *data, uint16_t length);
+
+/**
+ * @brief Check the store header, migrating or formatting the EEPROM if it's not the current layout.
+ * Call once in setup() before reading any records.
+ *
+ * @return uint8_t STORE_OK, STORE_FORMATTED or STORE_MIGRATED
+ */
+uint8_t beginStore(void);
+
+/**
+ * @brief Read a CRC-checked record kept outside the store, written by writeRecordAt()
+ *
+ * @param address EEPROM address of the record
+ * @param record_id RECORD_ id, seeds the CRC
+ * @param payload where to put the payload
+ * @param length payload length, at most RECORD_MAX_PAYLOAD
+ * @return true: CRC matched
+ * @return false: record missing or corrupt; payload is garbage
+ */
+bool readRecordAt(uint16_t address, uint8_t record_id, void *payload, uint16_t length);
+
+/**
+ * @brief Write a record outside the store: crc16 (2) followed by the payload. The CRC reaches the EEPROM last.
+ *
+ * @param address EEPROM address of the record
+ * @param record_id RECORD_ id, seeds the CRC
+ * @param payload payload to write
+ * @param length payload length, at most RECORD_MAX_PAYLOAD
+ */
+void writeRecordAt(uint16_t address, uint8_t record_id, const void *payload, uint16_t length);
+
+/**
+ * @brief Read the PID constants record
+ *
+ * @param ptr_constants where to put it
+ * @return true: CRC matched
+ * @return false: record missing or corrupt; ptr_constants is garbage
+ */
+bool readPIDConstantsRecord(PID_Constants *ptr_constants);
+
+/**
+ * @brief Write the PID constants record with a fresh CRC
+ */
+void writePIDConstantsRecord(PID_Constants *ptr_constants);
+
+/**
+ * @brief Read one profile record
+ *
+ * @param index profile slot, 0 to NUM_REFLOW_PROFILES - 1
+ * @param ptr_profile where to put it
+ * @return true: CRC matched
+ * @return false: bad index, record missing or corrupt
+ */
+bool readProfileRecord(uint8_t index, ReflowProfile *ptr_profile);
+
+/**
+ * @brief Read one profile record, falling back to the default profile if it's missing or corrupt.
+ * The default isn't written back; the slot is only written when the user saves it.
+ *
+ * @param index profile slot, 0 to NUM_REFLOW_PROFILES - 1
+ * @param ptr_profile where to put it
+ * @return true: the stored profile was loaded
+ * @return false: ptr_profile holds the default profile
+ */
+bool loadProfile(uint8_t index, ReflowProfile *ptr_profile);
+
+/**
+ * @brief Write one profile record with a fresh CRC
+ *
+ * @param index profile slot, 0 to NUM_REFLOW_PROFILES - 1
+ * @param ptr_profile profile to write
+ * @return true: written
+ * @return false: bad index
+ */
+bool writeProfileRecord(uint8_t index, ReflowProfile *ptr_profile);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+// no Arduino.h: the synthesizer also runs on a host, see tools/profile_synth.cpp
+#include <stdint.h>
+#include <stddef.h>
+#include "segments.h"
+
+/*
+Profile synthesizer.
+
+Paste datasheets give windows, not setpoints: a ramp limit, a soak band and how long to spend in it,
+a time above liquidus (TAL) range and a peak range. synthesizeProfile() turns those, plus how fast the
+oven can heat and cool, into segments that land in the middle of every window, with every free ramp run
+as fast as both the paste and the oven allow so the cycle is as short as it can be:
+
+    RAMP to soak_min_c at the ramp rate, waiting for the oven (GATE_TIME_AND_TEMP)
+    RAMP soak_min_c -> soak_max_c over the middle soak time (HOLD if the band is one temperature)
+    RAMP to the peak at the ramp rate, waiting for the oven
+    HOLD at the peak for whatever the middle TAL has left after the rise and fall through liquidus
+    RAMP down to end_c at the paste cooling limit if the oven would cool faster, otherwise COOLDOWN to end_c
+
+The peak is the middle of its window unless the rise and fall alone would overshoot the middle TAL;
+then it comes down toward peak_min_c.
+
+Rates are in 0.1 C/s, like SEGMENT_RAMP values.
+*/
+
+// synthesizeProfile() results
+#define SYNTH_OK 0
+#define SYNTH_BAD_WINDOW 1  // a window is upside down, or soak/liquidus/peak/end are out of order
+#define SYNTH_NO_RATE 2     // ramp limit or oven heat/cool rate is 0
+#define SYNTH_SOAK_SLOW 3   // the oven can't cross the soak band within soak_max_s
+#define SYNTH_TAL_LONG 4    // even at peak_min_c and no hold, rise and fall take longer than tal_max_s
+
+// SAC305-style windows the serial "synth" command starts from
+#ifndef SYNTH_DEFAULT_RAMP
+#define SYNTH_DEFAULT_RAMP 30 // 3 C/s
+#endif
+
+#ifndef SYNTH_DEFAULT_COOL
+#define SYNTH_DEFAULT_COOL 60 // 6 C/s
+#endif
+
+#ifndef SYNTH_DEFAULT_END_C
+#define SYNTH_DEFAULT_END_C 100 // cooldown ends here
+#endif
+
+struct PasteWindow
+{
+    uint16_t max_ramp; // heating limit, 0.1 C/s
+    uint16_t max_cool; // cooling limit, 0.1 C/s. 0: none
+    int16_t soak_min_c;
+    int16_t soak_max_c;
+    uint16_t soak_min_s;
+    uint16_t soak_max_s;
+    int16_t liquidus_c;
+    uint16_t tal_min_s; // time above liquidus
+    uint16_t tal_max_s;
+    int16_t peak_min_c;
+    int16_t peak_max_c;
+};
+
+struct OvenRates
+{
+    uint16_t heat; // fastest the oven heats, 0.1 C/s
+    uint16_t cool; // fastest it cools with the heater off, 0.1 C/s
+};
+
+/**
+ * @brief What the synthesized profile works out to
+ */
+struct SynthReport
+{
+    uint16_t ramp;     // heating rate used, 0.1 C/s
+    uint16_t cool;     // cooling rate expected through liquidus, 0.1 C/s
+    int16_t peak_c;
+    uint16_t soak_s;   // time in the soak band
+    uint16_t hold_s;   // time held at the peak
+    uint16_t tal_s;    // expected time above liquidus
+    uint32_t total_s;  // from start_c down to end_c
+};
+
+/**
+ * @brief Build a profile from paste windows and oven rates
+ *
+ * @param start_c oven temperature the profile starts from
+ * @param end_c temperature the cooldown ends at; below liquidus
+ * @param fan_on fan setting of every segment
+ * @return uint8_t SYNTH_OK or a SYNTH_ error; ptr_segments and ptr_report are only filled on SYNTH_OK
+ */
+uint8_t synthesizeProfile(const PasteWindow *ptr_window, const OvenRates *ptr_oven, int16_t start_c, int16_t end_c, bool fan_on,
+                          SegmentProfile *ptr_segments, SynthReport *ptr_report);
+
+/**
+ * @brief Fill in a SAC305-style window, the starting point of the serial "synth" command
+ */
+void defaultPasteWindow(PasteWindow *ptr_window);
+
+#endif
@@ -6,20 +6,65 @@
 #include <SPI.h>
 #include "Adafruit_MAX31856.h"
 
-#define MIN_TIME_BETWEEN_THERMO_READ 400
+/*
+The MAX31856 is run in one-shot mode without waiting: serviceTemperature() starts a conversion, then polls
+for it on later passes of loop(), so a conversion never stalls the loop. Conversions are only started when a
+reading is wanted: in time for the next PID tick (scheduleTemperature()), or every THERMO_IDLE_READ_MS while
+nothing is controlled. A slow PID period means fewer conversions.
+*/
+
+#ifndef MIN_TIME_BETWEEN_THERMO_READ
+#define MIN_TIME_BETWEEN_THERMO_READ 250 // shortest time from the start of one conversion to the next
+#endif
+
+#ifndef THERMO_CONVERSION_MS
+#define THERMO_CONVERSION_MS 185 // longest a one-shot conversion takes (50Hz filter)
+#endif
+
+#ifndef THERMO_CONVERSION_TIMEOUT_MS
+#define THERMO_CONVERSION_TIMEOUT_MS 250 // a conversion not done by then failed
+#endif
+
+#ifndef THERMO_IDLE_READ_MS
+#define THERMO_IDLE_READ_MS 1000 // between readings when no PID tick asks for one; the status screen still updates
+#endif
+
+#ifndef DEFAULT_THERMOCOUPLE_TYPE
+#define DEFAULT_THERMOCOUPLE_TYPE MAX31856_TCTYPE_K
+#endif
 
 // extern MAX6675 thermocouple;
 extern Adafruit_MAX31856 thermocouple;
-extern unsigned long last_time_ran;
 extern double last_temp;
 
 /*!
     @brief  Reads the current temperature from the thermocouple and updates the provided pointer.
+    Blocks for a whole conversion; only for setup(). loop() uses serviceTemperature().
     @param  temp Pointer to a double where the current temperature will be stored.
     @return boolean. success or failure.
 */
 bool getTemperature(double *temp);
 
+/*!
+    @brief  Start a conversion when one is due, and pick up its result once it's done. Call every loop(); never blocks.
+    @param  temp Pointer to a double that gets the new temperature. Untouched until a conversion finishes.
+    @return boolean. true: a new reading arrived.
+*/
+bool serviceTemperature(double *temp);
+
+/*!
+    @brief  Have a fresh reading by due_ms, e.g. the next PID tick. Until the next call, readings then go back
+    to one per THERMO_IDLE_READ_MS.
+    @param  due_ms millis() the reading is wanted at
+*/
+void scheduleTemperature(unsigned long due_ms);
+
 bool initializeTemperature();
 
+/*!
+    @brief  Switch the amplifier to another thermocouple type. Remembered and applied by initializeTemperature() if called before it.
+    @param  type MAX31856_TCTYPE_ value
+*/
+void applyThermocoupleType(uint8_t type);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+Run trace recorder.
+
+While a profile runs, one sample per second (time, temperature, target, heater state) is written to a
+ring of EEPROM slots, so the last TRACE_NUM_SLOTS runs survive a power cycle. Dump them over serial
+with the "trace" command.
+
+slot layout:
+    TraceHeader | samples ...
+
+samples are deltas from the previous one (the first from the header's start values):
+    short: | heater (1) | 0 (1) | temp delta, 1/4 C, -32 to 31 (6) |     time delta is 1s, target unchanged
+    long:  | heater (1) | 1 (1) | 0 (6) | varint time delta (s) | zigzag varint temp delta (1/4 C) | zigzag varint target delta (C) |
+almost every sample is the short form, so an 8 minute run takes about 500 bytes.
+runs longer than a slot holds keep their first part and are flagged truncated.
+*/
+
+#ifndef TRACE_BASE_ADDRESS
+#define TRACE_BASE_ADDRESS 1024 // above the record store (STORE_END_ADDRESS)
+#endif
+
+#ifndef TRACE_NUM_SLOTS
+#define TRACE_NUM_SLOTS 3
+#endif
+
+#ifndef TRACE_SLOT_SIZE
+#define TRACE_SLOT_SIZE 640 // about 10 minutes at 1 sample/s
+#endif
+
+#ifndef TRACE_SAMPLE_PERIOD_S
+#define TRACE_SAMPLE_PERIOD_S 1
+#endif
+
+#ifndef TRACE_CHECKPOINT_SAMPLES
+#define TRACE_CHECKPOINT_SAMPLES 30 // header rewritten this often, so a power cut loses at most this many samples
+#endif
+
+#define TRACE_MAX_SAMPLE_BYTES 10 // long form: flags + 3 varints of up to 3 bytes
+
+// TraceHeader.flags
+#define TRACE_FLAG_ENDED 0x01     // run finished or was cancelled. not set: power was lost mid-run
+#define TRACE_FLAG_TRUNCATED 0x02 // slot filled up; later samples were dropped
+
+struct TraceHeader
+{
+    uint16_t crc;        // over the rest of the header, seeded with the crc of the samples
+    uint16_t run_number; // counts up every run. the lowest one is overwritten next
+    uint32_t start_time; // unix time of the first sample
+    uint8_t profile_index;
+    uint8_t flags;
+    uint16_t num_samples;
+    uint16_t length;      // bytes of sample data after the header
+    int16_t start_temp;   // 1/4 C
+    int16_t start_target; // C
+};
+
+/**
+ * @brief Start recording a run into the oldest trace slot
+ *
+ * @param start_time unix time the run started
+ * @param profile_index profile slot being run
+ */
+void beginTrace(uint32_t start_time, uint8_t profile_index);
+
+/**
+ * @brief Record a sample if TRACE_SAMPLE_PERIOD_S has passed since the last one. Call every loop() while running.
+ *
+ * @param now unix time
+ * @param temp_c current temperature
+ * @param target_c current target
+ * @param heater_on heater relay state
+ */
+void recordTraceSample(uint32_t now, double temp_c, double target_c, bool heater_on);
+
+/**
+ * @brief Finish the current trace, if one is being recorded
+ */
+void endTrace(void);
+
+/**
+ * @brief Is a trace being recorded
+ */
+bool isTraceRecording(void);
+
+/**
+ * @brief Print every stored trace, oldest first, to Serial as CSV. Blocks until sent.
+ *
+ * @param run_number only print this run. -1: all of them
+ * @return uint8_t number of traces printed
+ */
+uint8_t dumpTraces(long run_number);
+
+#endif
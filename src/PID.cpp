@@ -1,5 +1,4 @@
 #include "PID.h"
-#include <EEPROM.h>
 
 bool flag_PID_running = false;
 
@@ -28,38 +27,25 @@ bool is_PID_constants_valid(PID_Constants *ptr_constants_to_check)
     return true;
 }
 
-bool save_PID_constants_to_EEPROM(int index, PID_Constants *ptr_constants)
+void resetPIDHistory(PID *pid)
 {
-    if ((index + sizeof(PID_Constants)) > EEPROM.length())
-    {
-        return false;
-    }
-
-    EEPROM.put(index, *ptr_constants);
-
-    return true;
-}
-
-bool get_PID_constants_from_EEPROM(int index, PID_Constants *ptr_constants)
-{
-    if ((index + sizeof(PID_Constants)) > EEPROM.length())
-    {
-        return false;
-    }
-
-    EEPROM.get(index, *ptr_constants);
-
-    return true;
+    pid->historyIndex = 0;
+    pid->historyLength = 0;
+    pid->prev_target = pid->target;
 }
 
 bool calculatePID(PID *pid)
 {
+    pid->error = pid->target - pid->input;
 
     // Update the temperature history
-    pid->temperatureHistory[pid->historyIndex] = pid->input;
-    pid->historyIndex = (pid->historyIndex + 1) % 5; // Update the index, wrapping around
-
-    pid->error = pid->target - pid->input;
+    pid->inputHistory[pid->historyIndex] = pid->input;
+    pid->dtHistory[pid->historyIndex] = pid->dt;
+    pid->historyIndex = (pid->historyIndex + 1) % PID_HISTORY_LENGTH; // Update the index, wrapping around
+    if (pid->historyLength < PID_HISTORY_LENGTH)
+    {
+        pid->historyLength++;
+    }
 
     if (abs(pid->error) <= 0.5f)
     {
@@ -82,14 +68,21 @@ bool calculatePID(PID *pid)
 
     // pid->derivative = (pid->error - pid->prev_error) / pid->dt;
 
-    // Calculate the derivative using the current and 5th previous reading
-    int previousIndex = (pid->historyIndex + 4) % 5;
-    double previousTemperature = pid->temperatureHistory[previousIndex];
-    pid->derivative = (pid->input - previousTemperature) / (pid->dt * 5);
+    // Calculate the derivative from the oldest temperature in the history. ticks aren't evenly spaced,
+    // so the time since then is the sum of every dt after it. taken on the temperature rather than the
+    // error, so a setpoint step or ramp doesn't kick it; on a steady setpoint the two are the same
+    int oldestIndex = (pid->historyIndex + PID_HISTORY_LENGTH - pid->historyLength) % PID_HISTORY_LENGTH;
+    double span = 0.0f;
+    for (int i = 1; i < pid->historyLength; i++)
+    {
+        span += pid->dtHistory[(oldestIndex + i) % PID_HISTORY_LENGTH];
+    }
+    pid->derivative = span > 0.0f ? -(pid->input - pid->inputHistory[oldestIndex]) / span : 0.0f;
 
     pid->output = pid->constants.PID_k * pid->error +
                   pid->constants.PID_i * pid->integral +
-                  pid->constants.PID_d * pid->derivative;
+                  pid->constants.PID_d * pid->derivative +
+                  pid->feedforward;
 
     pid->prev_error = pid->error;
 
@@ -98,6 +91,32 @@ bool calculatePID(PID *pid)
     return pid->output > pid->constants.threshold;
 }
 
+unsigned long getPIDPeriod(PID *pid, unsigned long fast_ms, unsigned long normal_ms, unsigned long slow_ms)
+{
+    double target_rate = pid->dt > 0.0f ? abs(pid->target - pid->prev_target) / pid->dt : 0.0f;
+    pid->prev_target = pid->target;
+
+    // setpoint on the move
+    if (target_rate >= PID_RAMP_RATE_C_PER_S)
+    {
+        return fast_ms;
+    }
+
+    // holding steady; nothing is going to change quickly
+    if (abs(pid->derivative) <= PID_STEADY_RATE_C_PER_S)
+    {
+        return slow_ms;
+    }
+
+    // error shrinking toward zero and due to get there soon: where overshoot starts
+    if (pid->error * pid->derivative < 0.0f && -pid->error / pid->derivative <= PID_CROSSING_LOOKAHEAD_S)
+    {
+        return fast_ms;
+    }
+
+    return normal_ms;
+}
+
 void csvPID(PID *pid)
 {
     // Time,dt,input,target,error,P,I,D,output,threshold
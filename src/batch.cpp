@@ -0,0 +1,53 @@
+#include "batch.h"
+
+void beginBatch(BatchQueue *ptr_batch, uint8_t total)
+{
+    ptr_batch->active = total > 0;
+    ptr_batch->loaded = false;
+    ptr_batch->total = total > MAX_BATCH_RUNS ? MAX_BATCH_RUNS : total;
+    ptr_batch->done = 0;
+    ptr_batch->start_s = 0;
+}
+
+void endBatch(BatchQueue *ptr_batch)
+{
+    ptr_batch->active = false;
+    ptr_batch->loaded = false;
+}
+
+bool isBatchReady(const BatchQueue *ptr_batch, float temp_c, uint16_t standby_c, uint16_t window_c)
+{
+    float error = temp_c - standby_c;
+    return ptr_batch->active && ptr_batch->loaded && error <= window_c && error >= -(float)window_c;
+}
+
+void startBatchRun(BatchQueue *ptr_batch, uint32_t now_s)
+{
+    ptr_batch->loaded = false;
+    if (ptr_batch->done == 0)
+    {
+        ptr_batch->start_s = now_s;
+    }
+}
+
+bool finishBatchRun(BatchQueue *ptr_batch)
+{
+    ptr_batch->done++;
+    if (ptr_batch->done >= ptr_batch->total)
+    {
+        endBatch(ptr_batch);
+    }
+    return ptr_batch->active;
+}
+
+uint16_t getBatchRate(const BatchQueue *ptr_batch, uint32_t now_s)
+{
+    uint32_t elapsed = now_s - ptr_batch->start_s;
+    if (ptr_batch->done == 0 || elapsed == 0)
+    {
+        return 0;
+    }
+
+    uint32_t rate = (uint32_t)ptr_batch->done * 36000UL / elapsed;
+    return rate > 0xFFFF ? 0xFFFF : rate;
+}
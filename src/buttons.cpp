@@ -1,15 +1,37 @@
 #include <Arduino.h>
 #include "buttons.h"
 
-// Time constants
-const unsigned long BUTTON_RATE_LIMIT = 200; // 200 milliseconds for rate limit
+// debounce states
+#define BUTTON_STATE_RELEASED 0
+#define BUTTON_STATE_PRESSING 1 // went low, waiting for it to stay low
+#define BUTTON_STATE_PRESSED 2
+#define BUTTON_STATE_RELEASING 3 // went high, waiting for it to stay high
 
-// Last press time for each button
-unsigned long lastPressTimeLeft = 0;
-unsigned long lastPressTimeRight = 0;
-unsigned long lastPressTimeUp = 0;
-unsigned long lastPressTimeDown = 0;
-unsigned long lastPressTimeSelect = 0;
+struct ButtonSampler
+{
+    volatile uint8_t *input_register;
+    uint8_t bit_mask;
+    uint8_t state;
+    uint8_t debounce_ms;
+    uint16_t held_ms;
+    uint16_t next_repeat_ms;
+};
+
+const uint8_t button_pins[NUM_BUTTONS] = {LB, RB, UB, DB, SB};
+ButtonSampler button_samplers[NUM_BUTTONS];
+
+// single producer (ISR) / single consumer (loop) ring. each index is only written by one side
+// and is a single byte, so no locking is needed.
+volatile ButtonEvent button_queue[BUTTON_QUEUE_SIZE];
+volatile uint8_t button_queue_head = 0; // written by ISR
+volatile uint8_t button_queue_tail = 0; // written by loop
+volatile uint8_t dropped_button_events = 0;
+
+uint8_t button_step = 1;
+bool button_repeat = false;
+
+// read by the ISR; a single byte, so no locking needed
+static volatile uint8_t button_debounce_ms = BUTTON_DEBOUNCE_MS;
 
 // flags
 bool left_button_pressed;
@@ -18,57 +40,204 @@ bool up_button_pressed;
 bool down_button_pressed;
 bool select_button_pressed;
 
-void checkButtonStates(bool *left_button_pressed, bool *right_button_pressed, bool *down_button_pressed, bool *up_button_pressed, bool *select_button_pressed)
+/**
+ * @brief push an event from the ISR. drops it if the queue is full
+ */
+static void pushButtonEvent(uint8_t button, uint8_t type, uint8_t step)
 {
-    unsigned long currentTime = millis();
-
-    // Check left button with rate limit
-    if (currentTime - lastPressTimeLeft > BUTTON_RATE_LIMIT && !digitalRead(LB))
-    {
-        *left_button_pressed = true;
-        lastPressTimeLeft = currentTime;
-    }
-    else
+    uint8_t next = (button_queue_head + 1) & (BUTTON_QUEUE_SIZE - 1);
+    if (next == button_queue_tail)
     {
-        *left_button_pressed = false;
+        if (dropped_button_events < 255)
+        {
+            dropped_button_events++;
+        }
+        return;
     }
 
-    if (currentTime - lastPressTimeRight > BUTTON_RATE_LIMIT && !digitalRead(RB))
+    button_queue[button_queue_head].button = button;
+    button_queue[button_queue_head].type = type;
+    button_queue[button_queue_head].step = step;
+    button_queue_head = next;
+}
+
+/**
+ * @brief how far an auto-repeat moves a value, accelerating the longer the button is held
+ */
+static uint8_t repeatStep(uint16_t held_ms)
+{
+    if (held_ms >= BUTTON_ACCEL_STEP_50_MS)
     {
-        *right_button_pressed = true;
-        lastPressTimeRight = currentTime;
+        return 50;
     }
-    else
+    if (held_ms >= BUTTON_ACCEL_STEP_10_MS)
     {
-        *right_button_pressed = false;
+        return 10;
     }
-    if (currentTime - lastPressTimeDown > BUTTON_RATE_LIMIT && !digitalRead(DB))
+    if (held_ms >= BUTTON_ACCEL_STEP_5_MS)
     {
-        *down_button_pressed = true;
-        lastPressTimeDown = currentTime;
+        return 5;
     }
-    else
+    return 1;
+}
+
+/**
+ * @brief sample every button once and advance its debounce state machine. runs every ~1ms
+ */
+static void sampleButtons(void)
+{
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++)
     {
-        *down_button_pressed = false;
+        ButtonSampler *ptr_sampler = &button_samplers[i];
+        // normally open with pullups: pressed reads LOW
+        bool down = !(*(ptr_sampler->input_register) & ptr_sampler->bit_mask);
+
+        switch (ptr_sampler->state)
+        {
+        case BUTTON_STATE_RELEASED:
+            if (down)
+            {
+                ptr_sampler->state = BUTTON_STATE_PRESSING;
+                ptr_sampler->debounce_ms = 0;
+            }
+            break;
+        case BUTTON_STATE_PRESSING:
+            if (!down)
+            {
+                ptr_sampler->state = BUTTON_STATE_RELEASED;
+            }
+            else if (++ptr_sampler->debounce_ms >= button_debounce_ms)
+            {
+                ptr_sampler->state = BUTTON_STATE_PRESSED;
+                ptr_sampler->held_ms = 0;
+                ptr_sampler->next_repeat_ms = BUTTON_REPEAT_DELAY_MS;
+                pushButtonEvent(i, BUTTON_EVENT_PRESS, 1);
+            }
+            break;
+        case BUTTON_STATE_PRESSED:
+            if (!down)
+            {
+                ptr_sampler->state = BUTTON_STATE_RELEASING;
+                ptr_sampler->debounce_ms = 0;
+            }
+            else if (ptr_sampler->held_ms < 0xFFFF)
+            {
+                ptr_sampler->held_ms++;
+                if (ptr_sampler->held_ms == BUTTON_LONG_PRESS_MS)
+                {
+                    pushButtonEvent(i, BUTTON_EVENT_LONG_PRESS, 0);
+                }
+                if (ptr_sampler->held_ms == ptr_sampler->next_repeat_ms)
+                {
+                    pushButtonEvent(i, BUTTON_EVENT_REPEAT, repeatStep(ptr_sampler->held_ms));
+                    ptr_sampler->next_repeat_ms += BUTTON_REPEAT_INTERVAL_MS;
+                }
+            }
+            break;
+        case BUTTON_STATE_RELEASING:
+            if (down)
+            {
+                // bounce; still held
+                ptr_sampler->state = BUTTON_STATE_PRESSED;
+            }
+            else if (++ptr_sampler->debounce_ms >= button_debounce_ms)
+            {
+                ptr_sampler->state = BUTTON_STATE_RELEASED;
+                pushButtonEvent(i, BUTTON_EVENT_RELEASE, 0);
+            }
+            break;
+        }
     }
-    if (currentTime - lastPressTimeUp > BUTTON_RATE_LIMIT && !digitalRead(UB))
+}
+
+// timer 0 runs millis(). its compare A interrupt fires once per overflow (~1.024ms) without disturbing it
+ISR(TIMER0_COMPA_vect)
+{
+    sampleButtons();
+}
+
+void initializeButtons(void)
+{
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++)
     {
-        *up_button_pressed = true;
-        lastPressTimeUp = currentTime;
+        // buttons Normally open. when pressed, they will read LOW
+        pinMode(button_pins[i], INPUT_PULLUP);
+        button_samplers[i].input_register = portInputRegister(digitalPinToPort(button_pins[i]));
+        button_samplers[i].bit_mask = digitalPinToBitMask(button_pins[i]);
+        button_samplers[i].state = BUTTON_STATE_RELEASED;
     }
-    else
+
+    OCR0A = 0x80;
+    TIMSK0 |= _BV(OCIE0A);
+}
+
+bool popButtonEvent(ButtonEvent *ptr_event)
+{
+    if (button_queue_tail == button_queue_head)
     {
-        *up_button_pressed = false;
+        return false;
     }
-    if (currentTime - lastPressTimeSelect > BUTTON_RATE_LIMIT && !digitalRead(SB))
-    {
-        *select_button_pressed = true;
 
-        lastPressTimeSelect = currentTime;
-    }
-    else
+    ptr_event->button = button_queue[button_queue_tail].button;
+    ptr_event->type = button_queue[button_queue_tail].type;
+    ptr_event->step = button_queue[button_queue_tail].step;
+    button_queue_tail = (button_queue_tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+
+    return true;
+}
+
+bool isButtonHeld(uint8_t button)
+{
+    uint8_t state = button_samplers[button].state;
+    return state == BUTTON_STATE_PRESSED || state == BUTTON_STATE_RELEASING;
+}
+
+uint8_t getDroppedButtonEvents(void)
+{
+    return dropped_button_events;
+}
+
+void setButtonDebounce(uint8_t debounce_ms)
+{
+    button_debounce_ms = debounce_ms > 0 ? debounce_ms : 1;
+}
+
+void checkButtonStates(bool *left_button_pressed, bool *right_button_pressed, bool *down_button_pressed, bool *up_button_pressed, bool *select_button_pressed)
+{
+    resetButtonStates(left_button_pressed, right_button_pressed, down_button_pressed, up_button_pressed, select_button_pressed);
+
+    // skip releases and long presses; stop at the first press so the rest wait for the next pass.
+    // repeats count as presses, except for select which should only ever fire once per push
+    ButtonEvent event;
+    while (popButtonEvent(&event))
     {
-        *select_button_pressed = false;
+        if (event.type != BUTTON_EVENT_PRESS && !(event.type == BUTTON_EVENT_REPEAT && event.button != BUTTON_SELECT))
+        {
+            continue;
+        }
+
+        button_step = event.step;
+        button_repeat = event.type == BUTTON_EVENT_REPEAT;
+
+        switch (event.button)
+        {
+        case BUTTON_LEFT:
+            *left_button_pressed = true;
+            break;
+        case BUTTON_RIGHT:
+            *right_button_pressed = true;
+            break;
+        case BUTTON_UP:
+            *up_button_pressed = true;
+            break;
+        case BUTTON_DOWN:
+            *down_button_pressed = true;
+            break;
+        case BUTTON_SELECT:
+            *select_button_pressed = true;
+            break;
+        }
+        return;
     }
 
     return;
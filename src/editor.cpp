@@ -0,0 +1,77 @@
+#include "editor.h"
+#include "buttons.h"
+#include "settings.h"
+#include "segments.h"
+
+void editIntValue(int *ptr_value, int direction, int min_value, int max_value)
+{
+    long value = (long)*ptr_value + (long)direction * button_step;
+
+    if (value < min_value)
+    {
+        value = min_value;
+    }
+    if (value > max_value)
+    {
+        value = max_value;
+    }
+
+    *ptr_value = (int)value;
+}
+
+void editDoubleValue(double *ptr_value, int direction, double resolution, double min_value, double max_value)
+{
+    double value = *ptr_value + direction * resolution * button_step;
+
+    if (value < min_value)
+    {
+        value = min_value;
+    }
+    if (value > max_value)
+    {
+        value = max_value;
+    }
+
+    *ptr_value = value;
+}
+
+void editSetting(uint8_t id, int direction)
+{
+    SettingDef def;
+    getSettingDef(id, &def);
+
+    long step = def.type == SETTING_TYPE_THERMOCOUPLE || def.type == SETTING_TYPE_ON_OFF ? 1 : (long)def.step * button_step;
+    long value = (long)getSetting(id) + direction * step;
+
+    if (value < def.min)
+    {
+        value = def.min;
+    }
+    if (value > def.max)
+    {
+        value = def.max;
+    }
+
+    setSetting(id, value);
+}
+
+void editGate(uint8_t *ptr_gate, int direction)
+{
+    *ptr_gate = (*ptr_gate + NUM_GATES + direction) % NUM_GATES;
+}
+
+void formatGate(uint8_t gate, char *buffer)
+{
+    switch (gate)
+    {
+    case GATE_TEMP:
+        strcpy_P(buffer, PSTR("Temp"));
+        break;
+    case GATE_TIME_AND_TEMP:
+        strcpy_P(buffer, PSTR("Both"));
+        break;
+    default:
+        strcpy_P(buffer, PSTR("Time"));
+        break;
+    }
+}
@@ -0,0 +1,217 @@
+#include "eeprom_cache.h"
+#include <EEPROM.h>
+#include <avr/eeprom.h>
+
+EepromCacheSlot eeprom_cache_slots[EEPROM_CACHE_SLOTS];
+uint8_t eeprom_cache_used_slots = 0;
+
+static void freeSlot(EepromCacheSlot *ptr_slot)
+{
+    for (uint8_t i = 0; i < EEPROM_CACHE_SLOTS; i++)
+    {
+        if (eeprom_cache_slots[i].length > 0 && eeprom_cache_slots[i].age > ptr_slot->age)
+        {
+            eeprom_cache_slots[i].age--;
+        }
+    }
+
+    ptr_slot->length = 0;
+    eeprom_cache_used_slots--;
+}
+
+/**
+ * @brief make a slot the last to drain, as if it had just been staged
+ */
+static void makeYoungest(EepromCacheSlot *ptr_slot)
+{
+    for (uint8_t i = 0; i < EEPROM_CACHE_SLOTS; i++)
+    {
+        if (eeprom_cache_slots[i].length > 0 && eeprom_cache_slots[i].age > ptr_slot->age)
+        {
+            eeprom_cache_slots[i].age--;
+        }
+    }
+
+    ptr_slot->age = eeprom_cache_used_slots - 1;
+}
+
+/**
+ * @brief write the highest dirty byte of a slot, freeing the slot once it's clean.
+ * EEPROM has to be ready.
+ */
+static void writeNextByte(EepromCacheSlot *ptr_slot)
+{
+    for (int8_t i = ptr_slot->length - 1; i >= 0; i--)
+    {
+        if (ptr_slot->dirty & ((uint32_t)1 << i))
+        {
+            eeprom_write_byte((uint8_t *)(ptr_slot->address + i), ptr_slot->data[i]);
+            ptr_slot->dirty &= ~((uint32_t)1 << i);
+            break;
+        }
+    }
+
+    if (ptr_slot->dirty == 0)
+    {
+        freeSlot(ptr_slot);
+    }
+}
+
+static EepromCacheSlot *oldestSlot(void)
+{
+    for (uint8_t i = 0; i < EEPROM_CACHE_SLOTS; i++)
+    {
+        if (eeprom_cache_slots[i].length > 0 && eeprom_cache_slots[i].age == 0)
+        {
+            return &eeprom_cache_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void drainSlot(EepromCacheSlot *ptr_slot)
+{
+    while (ptr_slot->length > 0)
+    {
+        while (!eeprom_is_ready())
+        {
+        }
+        writeNextByte(ptr_slot);
+    }
+}
+
+/**
+ * @brief stage one chunk that fits in a slot
+ */
+static void stageChunk(uint16_t address, const uint8_t *data, uint8_t length)
+{
+    EepromCacheSlot *ptr_slot = NULL;
+
+    for (uint8_t i = 0; i < EEPROM_CACHE_SLOTS; i++)
+    {
+        EepromCacheSlot *ptr_other = &eeprom_cache_slots[i];
+        if (ptr_other->length == 0)
+        {
+            continue;
+        }
+
+        if (ptr_other->address == address && ptr_other->length == length)
+        {
+            // same range again; overwrite it in place. it now has to land after everything staged
+            // before it, e.g. a trace header after the samples it covers
+            ptr_slot = ptr_other;
+            makeYoungest(ptr_slot);
+        }
+        else if (address < ptr_other->address + ptr_other->length && ptr_other->address < address + length)
+        {
+            // partial overlap; get the older write out of the way so order is kept
+            drainSlot(ptr_other);
+        }
+    }
+
+    if (ptr_slot == NULL)
+    {
+        if (eeprom_cache_used_slots == EEPROM_CACHE_SLOTS)
+        {
+            drainSlot(oldestSlot());
+        }
+
+        for (uint8_t i = 0; i < EEPROM_CACHE_SLOTS; i++)
+        {
+            if (eeprom_cache_slots[i].length == 0)
+            {
+                ptr_slot = &eeprom_cache_slots[i];
+                break;
+            }
+        }
+
+        ptr_slot->address = address;
+        ptr_slot->length = length;
+        ptr_slot->age = eeprom_cache_used_slots;
+        eeprom_cache_used_slots++;
+    }
+
+    ptr_slot->dirty = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        ptr_slot->data[i] = data[i];
+        if (EEPROM.read(address + i) != data[i])
+        {
+            ptr_slot->dirty |= (uint32_t)1 << i;
+        }
+    }
+
+    if (ptr_slot->dirty == 0)
+    {
+        freeSlot(ptr_slot);
+    }
+}
+
+void eepromCacheWrite(uint16_t address, const void *data, uint16_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    // last chunk first, so the front of a long record (where the CRC sits) drains last
+    while (length > 0)
+    {
+        uint8_t chunk = length % EEPROM_CACHE_SLOT_SIZE;
+        if (chunk == 0)
+        {
+            chunk = EEPROM_CACHE_SLOT_SIZE;
+        }
+        length -= chunk;
+        stageChunk(address + length, bytes + length, chunk);
+    }
+}
+
+void eepromCacheRead(uint16_t address, void *data, uint16_t length)
+{
+    uint8_t *bytes = (uint8_t *)data;
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        bytes[i] = EEPROM.read(address + i);
+    }
+
+    // staged bytes win over what's stored
+    for (uint8_t s = 0; s < EEPROM_CACHE_SLOTS; s++)
+    {
+        EepromCacheSlot *ptr_slot = &eeprom_cache_slots[s];
+        for (uint8_t i = 0; i < ptr_slot->length; i++)
+        {
+            uint16_t slot_address = ptr_slot->address + i;
+            if (slot_address >= address && slot_address < address + length)
+            {
+                bytes[slot_address - address] = ptr_slot->data[i];
+            }
+        }
+    }
+}
+
+bool serviceEepromCache(void)
+{
+    if (eeprom_cache_used_slots == 0)
+    {
+        return true;
+    }
+
+    if (eeprom_is_ready())
+    {
+        writeNextByte(oldestSlot());
+    }
+
+    return eeprom_cache_used_slots == 0;
+}
+
+bool isEepromCacheIdle(void)
+{
+    return eeprom_cache_used_slots == 0;
+}
+
+void flushEepromCache(void)
+{
+    while (eeprom_cache_used_slots > 0)
+    {
+        drainSlot(oldestSlot());
+    }
+}
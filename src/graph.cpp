@@ -0,0 +1,115 @@
+#include "graph.h"
+#include "menu.h"
+#include "oven_model.h"
+
+/**
+ * @brief graph cache for the profile on the MODE_PROFILE_SELECTED_TO_RUN screen
+ */
+ProfileGraph selected_profile_graph;
+
+/**
+ * @brief fill in end times and temperatures of every segment, after an ambient start point.
+ * Times are what the oven model predicts, see oven_model.h.
+ *
+ * @return uint16_t predicted total runtime, capped at 65535s
+ */
+static uint16_t estimateSegmentPoints(const SegmentProfile *ptr_segments, uint32_t times[PROFILE_GRAPH_POINTS], int temps[PROFILE_GRAPH_POINTS])
+{
+    OvenPrediction prediction;
+    predictSegments(ptr_segments, PROFILE_GRAPH_AMBIENT_C, &prediction);
+
+    times[0] = 0;
+    temps[0] = PROFILE_GRAPH_AMBIENT_C;
+
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        times[i + 1] = prediction.end_s[i];
+        temps[i + 1] = ptr_segments->segments[i].target_c;
+    }
+
+    return prediction.total_s > 0xFFFF ? 0xFFFF : prediction.total_s;
+}
+
+uint16_t estimateSegmentsRuntime(const SegmentProfile *ptr_segments)
+{
+    uint32_t times[PROFILE_GRAPH_POINTS];
+    int temps[PROFILE_GRAPH_POINTS];
+
+    return estimateSegmentPoints(ptr_segments, times, temps);
+}
+
+uint16_t estimateProfileRuntime(ReflowProfile *ptr_profile)
+{
+    SegmentProfile segments;
+    profileToSegments(ptr_profile, &segments);
+
+    return estimateSegmentsRuntime(&segments);
+}
+
+/**
+ * @brief scale a temperature into a pixel row of the graph area. Hotter is higher up.
+ */
+static uint8_t scaleTemp(int temp_c, int peak_c)
+{
+    int height = SCREEN_HEIGHT - 1 - PROFILE_GRAPH_TOP;
+    int span = peak_c - PROFILE_GRAPH_AMBIENT_C;
+
+    if (span <= 0)
+    {
+        return SCREEN_HEIGHT - 1;
+    }
+    if (temp_c < PROFILE_GRAPH_AMBIENT_C)
+    {
+        temp_c = PROFILE_GRAPH_AMBIENT_C;
+    }
+
+    return (SCREEN_HEIGHT - 1) - (uint8_t)((long)(temp_c - PROFILE_GRAPH_AMBIENT_C) * height / span);
+}
+
+void buildSegmentGraph(const SegmentProfile *ptr_segments, ProfileGraph *ptr_graph)
+{
+    // corners of the curve; the oven ramps in between them
+    uint32_t times[PROFILE_GRAPH_POINTS];
+    int temps[PROFILE_GRAPH_POINTS];
+
+    uint16_t total = estimateSegmentPoints(ptr_segments, times, temps);
+    uint8_t num_points = ptr_segments->num_segments + 1;
+
+    int peak = PROFILE_GRAPH_AMBIENT_C;
+    for (uint8_t i = 0; i < num_points; i++)
+    {
+        peak = max(peak, temps[i]);
+    }
+
+    for (uint8_t i = 0; i < num_points; i++)
+    {
+        ptr_graph->x[i] = total == 0 ? 0 : (uint8_t)(min(times[i], (uint32_t)total) * (SCREEN_WIDTH - 1) / total);
+        ptr_graph->y[i] = scaleTemp(temps[i], peak);
+    }
+
+    ptr_graph->num_points = num_points;
+    ptr_graph->total_time_s = total;
+    ptr_graph->peak_temp_c = peak;
+}
+
+void buildProfileGraph(ReflowProfile *ptr_profile, ProfileGraph *ptr_graph)
+{
+    SegmentProfile segments;
+    profileToSegments(ptr_profile, &segments);
+
+    buildSegmentGraph(&segments, ptr_graph);
+}
+
+void drawProfileGraph(ProfileGraph *ptr_graph)
+{
+    // baseline (ambient) and the profile curve
+    display.drawFastHLine(0, SCREEN_HEIGHT - 1, SCREEN_WIDTH, SSD1306_WHITE);
+    for (uint8_t i = 1; i < ptr_graph->num_points; i++)
+    {
+        display.drawLine(ptr_graph->x[i - 1], ptr_graph->y[i - 1], ptr_graph->x[i], ptr_graph->y[i], SSD1306_WHITE);
+    }
+
+    // drop line at the end of the run
+    uint8_t last = ptr_graph->num_points - 1;
+    display.drawFastVLine(ptr_graph->x[last], ptr_graph->y[last], SCREEN_HEIGHT - ptr_graph->y[last], SSD1306_WHITE);
+}
@@ -0,0 +1,117 @@
+#include "journal.h"
+#include "trace.h"
+#include "storage.h"
+#include "eeprom_cache.h"
+#include <stddef.h>
+
+#define JOURNAL_ENTRY_ADDRESS(index) (JOURNAL_BASE_ADDRESS + (index) * sizeof(JournalEntry))
+
+static_assert(JOURNAL_BASE_ADDRESS >= TRACE_BASE_ADDRESS + TRACE_NUM_SLOTS * TRACE_SLOT_SIZE, "journal overlaps the trace slots");
+static_assert(JOURNAL_END_ADDRESS <= EEPROM_SIZE, "journal doesn't fit in the EEPROM");
+
+static JournalEntry journal;
+static uint8_t journal_index; // entry holding the newest values
+static bool journal_dirty = false;
+static unsigned long last_commit_ms;
+
+// for printJournal(). in flash, like the menu texts
+#define JOURNAL_KEY_NAME_LEN 15
+static const char journal_key_names[JOURNAL_NUM_KEYS][JOURNAL_KEY_NAME_LEN] PROGMEM = {"runs", "last profile", "heater on s", "completed runs", "ckpt profile", "ckpt step", "ckpt step s", "ckpt 0.1C"};
+
+static uint16_t entryCRC(JournalEntry *ptr_entry)
+{
+    return crc16(0xFFFF, ptr_entry, offsetof(JournalEntry, crc));
+}
+
+void beginJournal(void)
+{
+    bool found = false;
+
+    // the ring is small; a straight scan of every entry is a few hundred byte reads
+    for (uint8_t i = 0; i < JOURNAL_NUM_ENTRIES; i++)
+    {
+        JournalEntry entry;
+        eepromCacheRead(JOURNAL_ENTRY_ADDRESS(i), &entry, sizeof(entry));
+        if (entry.crc != entryCRC(&entry))
+        {
+            continue;
+        }
+
+        // sequence numbers wrap; compare by difference
+        if (!found || (int16_t)(entry.sequence - journal.sequence) > 0)
+        {
+            journal = entry;
+            journal_index = i;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        memset(&journal, 0, sizeof(journal));
+        // the first commit goes to entry 0
+        journal_index = JOURNAL_NUM_ENTRIES - 1;
+        journal.sequence = 0xFFFF;
+    }
+
+    journal_dirty = false;
+    last_commit_ms = millis();
+}
+
+uint32_t getJournalValue(uint8_t key)
+{
+    if (key >= JOURNAL_NUM_KEYS)
+    {
+        return 0;
+    }
+    return journal.values[key];
+}
+
+void setJournalValue(uint8_t key, uint32_t value)
+{
+    if (key >= JOURNAL_NUM_KEYS || journal.values[key] == value)
+    {
+        return;
+    }
+    journal.values[key] = value;
+    journal_dirty = true;
+}
+
+void addJournalValue(uint8_t key, uint32_t amount)
+{
+    setJournalValue(key, getJournalValue(key) + amount);
+}
+
+void commitJournal(void)
+{
+    if (!journal_dirty)
+    {
+        return;
+    }
+
+    journal_index = (journal_index + 1) % JOURNAL_NUM_ENTRIES;
+    journal.sequence++;
+    journal.crc = entryCRC(&journal);
+    eepromCacheWrite(JOURNAL_ENTRY_ADDRESS(journal_index), &journal, sizeof(journal));
+
+    journal_dirty = false;
+    last_commit_ms = millis();
+}
+
+void serviceJournal(void)
+{
+    if (journal_dirty && millis() - last_commit_ms >= JOURNAL_COMMIT_INTERVAL_MS)
+    {
+        commitJournal();
+    }
+}
+
+void printJournal(void)
+{
+    for (uint8_t i = 0; i < JOURNAL_NUM_KEYS; i++)
+    {
+        Serial.print((const __FlashStringHelper *)journal_key_names[i]);
+        Serial.print(F(": "));
+        Serial.println(journal.values[i]);
+    }
+}
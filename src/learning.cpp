@@ -0,0 +1,204 @@
+#include "learning.h"
+#include "storage.h"
+#include "oven_model.h"
+
+static_assert(LEARNING_BASE_ADDRESS >= OVEN_MODEL_RECORD_ADDRESS + sizeof(uint16_t) + sizeof(OvenModel), "learning records overlap the oven model record");
+static_assert(LEARNING_BASE_ADDRESS + LEARNING_NUM_SLOTS * LEARNING_SLOT_SIZE <= EEPROM_SIZE, "learning records don't fit in the EEPROM");
+static_assert(sizeof(LearningRecord) <= RECORD_MAX_PAYLOAD, "learning record too big");
+
+// mean_error of a bin with no samples
+#define NO_ERROR INT16_MIN
+
+RunLearning learning;
+
+static uint16_t slotAddress(uint8_t slot)
+{
+    return LEARNING_BASE_ADDRESS + slot * LEARNING_SLOT_SIZE;
+}
+
+bool readLearningSlot(uint8_t slot, LearningRecord *ptr_record)
+{
+    return readRecordAt(slotAddress(slot), RECORD_LEARNING(slot), ptr_record, sizeof(LearningRecord));
+}
+
+/**
+ * @brief CRC of everything that changes how a profile runs. Field by field, so struct padding doesn't count.
+ */
+static uint16_t profileCrc(const SegmentProfile *ptr_segments)
+{
+    uint16_t crc = crc16(0xFFFF, &ptr_segments->num_segments, 1);
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &ptr_segments->segments[i];
+        crc = crc16(crc, &ptr_segment->type, sizeof(ptr_segment->type));
+        crc = crc16(crc, &ptr_segment->fan_on, sizeof(ptr_segment->fan_on));
+        crc = crc16(crc, &ptr_segment->target_c, sizeof(ptr_segment->target_c));
+        crc = crc16(crc, &ptr_segment->value, sizeof(ptr_segment->value));
+        crc = crc16(crc, &ptr_segment->gate, sizeof(ptr_segment->gate));
+        crc = crc16(crc, &ptr_segment->band_c, sizeof(ptr_segment->band_c));
+        crc = crc16(crc, &ptr_segment->timeout_s, sizeof(ptr_segment->timeout_s));
+        crc = crc16(crc, &ptr_segment->abort_on_timeout, sizeof(ptr_segment->abort_on_timeout));
+    }
+    return crc;
+}
+
+void beginLearning(RunLearning *ptr_learning, uint8_t profile_index, const SegmentProfile *ptr_segments)
+{
+    // the profile's own slot, otherwise an empty one, otherwise the least run one
+    int8_t found = -1;
+    uint16_t least_runs = 0xFFFF;
+    for (uint8_t slot = 0; slot < LEARNING_NUM_SLOTS; slot++)
+    {
+        LearningRecord record;
+        if (!readLearningSlot(slot, &record))
+        {
+            record.runs = 0;
+        }
+        else if (record.profile_index == profile_index)
+        {
+            found = slot;
+            ptr_learning->record = record;
+            break;
+        }
+
+        if (record.runs < least_runs)
+        {
+            least_runs = record.runs;
+            ptr_learning->slot = slot;
+        }
+    }
+
+    uint16_t crc = profileCrc(ptr_segments);
+    if (found >= 0)
+    {
+        ptr_learning->slot = found;
+    }
+    if (found < 0 || ptr_learning->record.profile_crc != crc)
+    {
+        // new to this slot, or edited since: start over
+        ptr_learning->record.profile_crc = crc;
+        ptr_learning->record.profile_index = profile_index;
+        ptr_learning->record.runs = 0;
+        memset(ptr_learning->record.correction, 0, sizeof(ptr_learning->record.correction));
+    }
+
+    ptr_learning->elapsed_ms = 0;
+    ptr_learning->error_sum = 0;
+    ptr_learning->error_count = 0;
+    for (uint8_t i = 0; i < LEARNING_NUM_BINS; i++)
+    {
+        ptr_learning->mean_error[i] = NO_ERROR;
+    }
+    ptr_learning->active = true;
+}
+
+void cancelLearning(RunLearning *ptr_learning)
+{
+    ptr_learning->active = false;
+}
+
+/**
+ * @brief bin the run is in now. LEARNING_NUM_BINS once past the last one
+ */
+static uint8_t currentBin(const RunLearning *ptr_learning)
+{
+    uint32_t bin = ptr_learning->elapsed_ms / (LEARNING_BIN_S * 1000UL);
+    return bin < LEARNING_NUM_BINS ? bin : LEARNING_NUM_BINS;
+}
+
+float getLearningCorrection(const RunLearning *ptr_learning)
+{
+    uint8_t bin = currentBin(ptr_learning);
+    if (!ptr_learning->active || bin >= LEARNING_NUM_BINS)
+    {
+        return 0;
+    }
+
+    return ptr_learning->record.correction[bin] * LEARNING_UNIT;
+}
+
+void stepLearning(RunLearning *ptr_learning, float dt_s, float target_c, float error_c)
+{
+    if (!ptr_learning->active)
+    {
+        return;
+    }
+
+    uint8_t bin = currentBin(ptr_learning);
+    if (bin < LEARNING_NUM_BINS && target_c > COOLDOWN_SETPOINT_C)
+    {
+        ptr_learning->error_sum += error_c;
+        ptr_learning->error_count++;
+    }
+
+    ptr_learning->elapsed_ms += (uint32_t)(dt_s * 1000);
+
+    // close the bin once the run has moved past it
+    if (currentBin(ptr_learning) != bin && bin < LEARNING_NUM_BINS)
+    {
+        if (ptr_learning->error_count > 0)
+        {
+            float mean = ptr_learning->error_sum / ptr_learning->error_count;
+            ptr_learning->mean_error[bin] = constrain(mean * 10, -32767.0f, 32767.0f);
+        }
+        ptr_learning->error_sum = 0;
+        ptr_learning->error_count = 0;
+    }
+}
+
+float finishLearning(RunLearning *ptr_learning)
+{
+    if (!ptr_learning->active)
+    {
+        return 0;
+    }
+    ptr_learning->active = false;
+
+    // the bin the run ended in counts too
+    uint8_t last = currentBin(ptr_learning);
+    if (last < LEARNING_NUM_BINS && ptr_learning->error_count > 0)
+    {
+        ptr_learning->mean_error[last] = constrain(ptr_learning->error_sum / ptr_learning->error_count * 10, -32767.0f, 32767.0f);
+    }
+
+    float abs_error_sum = 0;
+    uint8_t num_errors = 0;
+    for (uint8_t j = 0; j < LEARNING_NUM_BINS; j++)
+    {
+        if (ptr_learning->mean_error[j] != NO_ERROR)
+        {
+            abs_error_sum += abs(ptr_learning->mean_error[j]) / 10.0f;
+            num_errors++;
+        }
+
+        // heat added now shows up LEARNING_LEAD_BINS later
+        uint8_t k = min(j + LEARNING_LEAD_BINS, LEARNING_NUM_BINS - 1);
+        if (ptr_learning->mean_error[k] == NO_ERROR)
+        {
+            continue;
+        }
+        float step = constrain(LEARNING_GAIN * ptr_learning->mean_error[k] / 10.0f, -LEARNING_MAX_STEP, LEARNING_MAX_STEP);
+        int16_t correction = ptr_learning->record.correction[j] + (int16_t)(step / LEARNING_UNIT + (step < 0 ? -0.5f : 0.5f));
+        ptr_learning->record.correction[j] = constrain(correction, INT8_MIN, INT8_MAX);
+    }
+
+    if (ptr_learning->record.runs < 0xFF)
+    {
+        ptr_learning->record.runs++;
+    }
+    writeRecordAt(slotAddress(ptr_learning->slot), RECORD_LEARNING(ptr_learning->slot), &ptr_learning->record, sizeof(LearningRecord));
+
+    return num_errors > 0 ? abs_error_sum / num_errors : 0;
+}
+
+void clearLearning(void)
+{
+    // a record no profile matches, with no runs: first to be taken
+    LearningRecord record;
+    memset(&record, 0, sizeof(record));
+    record.profile_index = LEARNING_NO_PROFILE;
+    for (uint8_t slot = 0; slot < LEARNING_NUM_SLOTS; slot++)
+    {
+        writeRecordAt(slotAddress(slot), RECORD_LEARNING(slot), &record, sizeof(LearningRecord));
+    }
+}
@@ -2,7 +2,6 @@
 #include "config.h"
 #include <SPI.h>
 #include <Wire.h>
-#include <EEPROM.h>
 #include "reflow.h"
 #include "PID.h"
 #include "temperature.h"
@@ -10,13 +9,31 @@
 #include "buttons.h"
 #include "menu.h"
 #include "screens.h"
+#include "graph.h"
+#include "editor.h"
+#include "storage.h"
+#include "eeprom_cache.h"
+#include "trace.h"
+#include "serial_commands.h"
+#include "journal.h"
+#include "settings.h"
+#include "run_log.h"
+#include "run_plan.h"
+#include "recovery.h"
+#include "batch.h"
+#include "paste_library.h"
+#include "oven_model.h"
+#include "learning.h"
 
 // global variables
 
 /**
- * @brief Array to hold all the reflow profiles acquired from EEPROM
+ * @brief profile highlighted in the run/edit lists. Profiles live in EEPROM and are only loaded
+ * when highlighted, since all NUM_REFLOW_PROFILES of them don't fit in RAM.
  */
-ReflowProfile reflow_profiles[NUM_REFLOW_PROFILES];
+ReflowProfile listed_profile;
+int listed_profile_index = -1; // slot held in listed_profile. -1: none
+uint8_t listed_profile_write_count;
 
 /**
  * @brief object to hold all the PID settings and constants
@@ -25,7 +42,7 @@ PID pid;
 
 /**
  * @brief Buffer to hold temporary string values. Mostly just for the ScreenItem
- * and MenuItem initialization functions. Use sprintf(reusableBuffer, "string %d", data) to fill this.
+ * and MenuItem initialization functions. Use formatFixed(value, decimals, suffix, reusableBuffer) to fill this.
  */
 char reusableBuffer[10];
 
@@ -49,12 +66,231 @@ ReflowProfile currentlySelectedProfile;
  */
 ReflowProfile editingProfile;
 
-uint32_t hold_reflow_time;
-bool hold_reflow_time_started = false;
-double incrementor = 1.0f;
+/**
+ * @brief temperature and target shown on the status and home screens. Re-formatted only when they change.
+ */
+BoundScreenItem status_temp_item = {&status_screen, 1, &current_temp, BOUND_DOUBLE, 1, 'C'};
+BoundScreenItem status_target_item = {&status_screen, 3, &pid.target, BOUND_DOUBLE, 1, 'C'};
+BoundScreenItem home_temp_item = {&home_screen, 1, &current_temp, BOUND_DOUBLE, 1, 'C'};
+BoundScreenItem home_target_item = {&home_screen, 3, &pid.target, BOUND_DOUBLE, 1, 'C'};
+
+/**
+ * @brief heater on-time not yet added to JOURNAL_HEATER_ON_S
+ */
+unsigned long heater_on_ms = 0;
+
+/**
+ * @brief wait before the next PID tick; picked by getPIDPeriod() after every tick
+ */
+unsigned long pid_period_ms = MS_BETWEEN_PID;
+
+/**
+ * @brief millis() when the current run started; run log timestamps count from here
+ */
+unsigned long run_start_ms = 0;
+
+/**
+ * @brief the profile being run, compiled when Run is pressed, and where the run is up to
+ */
+RunPlan run_plan;
+PlanRun plan_run;
 uint8_t profile_index = 0;
 
+/**
+ * @brief a library profile was converted into currentlySelectedProfile; the next slot picked to edit gets it
+ */
+bool copying_library_profile = false;
+
+/**
+ * @brief runs of the selected profile still queued, see batch.h
+ */
+BatchQueue batch;
+
+/**
+ * @brief checkpoint found at boot, offered on the MODE_RESUME_RUN screen
+ */
+RunCheckpoint resume_checkpoint;
+
+/**
+ * @brief Segments of the selected profile: a library profile straight from flash, otherwise currentlySelectedProfile
+ */
+static void loadSelectedSegments(SegmentProfile *ptr_segments)
+{
+  if (isLibraryProfile(profile_index))
+  {
+    loadLibraryProfile(profile_index - LIBRARY_PROFILE_INDEX, ptr_segments);
+  }
+  else
+  {
+    profileToSegments(&currentlySelectedProfile, ptr_segments);
+  }
+}
+
+/**
+ * @brief Select a library profile or EEPROM slot to run, and fill in the MODE_PROFILE_SELECTED_TO_RUN screen
+ */
+static void selectProfile(uint8_t index)
+{
+  profile_index = index;
+  if (isLibraryProfile(profile_index))
+  {
+    SegmentProfile segments;
+    loadSelectedSegments(&segments);
+    populateSelectedToRunSegments(&segments);
+  }
+  else
+  {
+    loadProfile(profile_index, &currentlySelectedProfile);
+    populateSelectedToRunScreen(&currentlySelectedProfile);
+  }
+}
+
+/**
+ * @brief stage names of a profile, in profileToSegments() order
+ */
+static const char *const stage_names[] = {"Pre", "Soak", "Refl", "Hold"};
+
+/**
+ * @brief profile the edit screen's prediction was worked out for; only redone when the profile changes
+ */
+static ReflowProfile checked_profile;
+
+/**
+ * @brief Show the edited profile's predicted runtime, and the first stage the oven can't keep up with
+ */
+static void checkEditedProfile(void)
+{
+  if (memcmp(&checked_profile, &currentlySelectedProfile, sizeof(ReflowProfile)) == 0)
+  {
+    return;
+  }
+  checked_profile = currentlySelectedProfile;
+
+  SegmentProfile segments;
+  OvenPrediction prediction;
+  profileToSegments(&currentlySelectedProfile, &segments);
+  predictSegments(&segments, PROFILE_GRAPH_AMBIENT_C, &prediction);
+
+  snprintf(reusableBuffer, STR_LEN, "~%lus", (unsigned long)prediction.total_s);
+  setScreenItemText(&edit_reflow_screen, 1, reusableBuffer);
+
+  strcpy(reusableBuffer, " ");
+  if (prediction.first_flagged < segments.num_segments)
+  {
+    uint8_t flags = prediction.flags[prediction.first_flagged];
+    snprintf(reusableBuffer, STR_LEN, "%s %s", stage_names[prediction.first_flagged], flags & OVEN_TIMES_OUT ? "T/O" : "lag");
+  }
+  setScreenItemText(&edit_reflow_screen, 2, reusableBuffer);
+}
+
+/**
+ * @brief Compile the selected profile and start running it
+ *
+ * @param ptr_checkpoint NULL for a new run. Otherwise the run carries on from this checkpoint, and isn't counted again
+ * @return true: running
+ */
+static bool startRun(const RunCheckpoint *ptr_checkpoint)
+{
+  // validate and compile once; the running branch only steps the plan
+  SegmentProfile segments;
+  loadSelectedSegments(&segments);
+  uint8_t plan_error = compileRunPlan(&segments, current_temp, MIN_TEMP_C, MAX_TEMP_C, &run_plan);
+  if (plan_error != PLAN_OK)
+  {
+    Serial.print(F("Profile can't run: error "));
+    Serial.print(plan_error);
+    Serial.print(F(" in segment "));
+    Serial.println(run_plan.error_step + 1);
+    return false;
+  }
+
+  if (ptr_checkpoint == NULL)
+  {
+    // the run goes ahead either way; the oven model is only a prediction
+    OvenPrediction prediction;
+    predictSegments(&segments, current_temp, &prediction);
+    if (prediction.first_flagged < segments.num_segments)
+    {
+      Serial.print(F("Oven may not keep up with segment "));
+      Serial.println(prediction.first_flagged + 1);
+    }
+  }
+
+  setPreviousTime();
+  beginRunPlan(&plan_run, &run_plan, previous_time, current_temp);
+  if (ptr_checkpoint != NULL && !seekRunPlan(&plan_run, &run_plan, &ptr_checkpoint->position, previous_time))
+  {
+    // the profile was changed over serial since the checkpoint; it can never be resumed
+    Serial.println(F("Checkpoint doesn't fit the profile"));
+    clearRunCheckpoint();
+    commitJournal();
+    return false;
+  }
+  beginTrace(previous_time, profile_index);
+
+  if (ptr_checkpoint == NULL)
+  {
+    addJournalValue(JOURNAL_RUN_COUNT, 1);
+    setJournalValue(JOURNAL_LAST_PROFILE, profile_index);
+    beginLearning(&learning, profile_index, &segments);
+  }
+  else
+  {
+    // the run's clock starts over, so learned corrections wouldn't line up
+    cancelLearning(&learning);
+  }
+  // commits the journal
+  saveRunCheckpoint(profile_index, &plan_run, previous_time, current_temp);
+
+  run_start_ms = millis();
+  beginRunLog(getJournalValue(JOURNAL_RUN_COUNT), ptr_checkpoint == NULL ? 0 : ptr_checkpoint->log_part + 1);
+  return true;
+}
+
+/**
+ * @brief Heater and fan off, and close out the run. The caller commits the journal.
+ */
+static void stopRun(void)
+{
+  pid.target = 0.0f;
+  flag_PID_running = false;
+  digitalWrite(FAN_RELAY_PIN, LOW);
+  digitalWrite(HEAT_RELAY_PIN, LOW);
+  endTrace();
+  endRunLog();
+  clearRunCheckpoint();
+  cancelLearning(&learning);
+}
+
+/**
+ * @brief whether left/right on the highlighted item steps a number. only those auto-repeat; back, toggles
+ * and gate cycling act once per push
+ */
+static bool isNumberHighlighted(void)
+{
+  switch (current_mode)
+  {
+  case MODE_EDIT_SELECTED_PROFILE:
+    // temperatures and times
+    return index_to_highlight >= 1 && index_to_highlight <= 6;
+  case MODE_EDIT_PID_PRAMS:
+    return index_to_highlight >= 1 && index_to_highlight <= 4;
+  case MODE_EDIT_SETTINGS:
+    if (index_to_highlight >= 1 && index_to_highlight <= NUM_SETTINGS)
+    {
+      SettingDef def;
+      getSettingDef(index_to_highlight - 1, &def);
+      return def.type != SETTING_TYPE_THERMOCOUPLE && def.type != SETTING_TYPE_ON_OFF;
+    }
+    return false;
+  default:
+    return false;
+  }
+}
+
 // Main code----------------------------------------------------------------------------------------------
+// unit tests under test/ bring their own setup() and loop()
+#ifndef PIO_UNIT_TESTING
 void setup()
 {
   Serial.begin(9600);
@@ -62,12 +298,8 @@ void setup()
   // Set pin direcitons
   pinMode(FAN_RELAY_PIN, OUTPUT);
   pinMode(HEAT_RELAY_PIN, OUTPUT);
-  // buttons Normally open. when pressed, they will read LOW
-  pinMode(LB, INPUT_PULLUP);
-  pinMode(UB, INPUT_PULLUP);
-  pinMode(DB, INPUT_PULLUP);
-  pinMode(RB, INPUT_PULLUP);
-  pinMode(SB, INPUT_PULLUP);
+  // buttons are sampled and debounced from a timer interrupt from here on
+  initializeButtons();
 
   // try to initialize the RTC.
   if (!initializeRTC())
@@ -79,22 +311,24 @@ void setup()
     }
   }
 
-  // check eeprom for PID constants
-  get_PID_constants_from_EEPROM(DEFAULT_CONSTANTS_ADDRESS, &(pid.constants));
-  // verify PID constants
-  if (is_PID_constants_valid(&(pid.constants)))
-  {
-    // assign result to pid variable (already done by using get above)
-  }
-  else
+  // check the EEPROM record store; migrates older layouts
+  beginStore();
+  beginJournal();
+  // runtime settings; config.h only holds their defaults now
+  loadSettings();
+  // how fast this oven heats and cools, for the profile checks
+  loadOvenModel();
+
+  // get PID constants. only a failed CRC means they need replacing
+  if (!readPIDConstantsRecord(&(pid.constants)))
   {
-    // if the PID constants are invalid, write the default constants to memory and set current volatile variables to defaults
+    // if the PID constants are missing or corrupt, write the default constants to memory and set current volatile variables to defaults
     pid.constants.PID_d = DEFAULT_PID_D;
     pid.constants.PID_i = DEFAULT_PID_I;
     pid.constants.PID_k = DEFAULT_PID_K;
     pid.constants.threshold = DEFAULT_PID_THRESHOLD;
 
-    save_PID_constants_to_EEPROM(DEFAULT_CONSTANTS_ADDRESS, &(pid.constants));
+    writePIDConstantsRecord(&(pid.constants));
   }
 
   pid.target = 0.0f;
@@ -112,23 +346,12 @@ void setup()
   // get current temperature
   getTemperature(&current_temp);
 
-  // get the currnet reflow profiles from EEPROM
-  getProfilesFromEEPROM(reflow_profiles, NUM_REFLOW_PROFILES, DEFAULT_PROFILES_ADDRESS);
-
-  // verify the current reflow profiles
-  bool invalidProfilePresent = false;
-  for (int i = 0; i < NUM_REFLOW_PROFILES; i++)
+  // runs are still controlled without a card, just not logged
+  if (!beginSdRunLog(SD_CS_PIN))
   {
-    if (!isProfileValid(&(reflow_profiles[i])))
-    {
-      invalidProfilePresent = true;
-      reflow_profiles[i] = default_reflow_profile;
-    }
-  }
-  if (invalidProfilePresent)
-  {
-    saveProfilesToEEPROM(reflow_profiles, NUM_REFLOW_PROFILES, DEFAULT_PROFILES_ADDRESS);
+    Serial.println(F("No SD card, run logging off"));
   }
+
   if (!initializeScreen())
   {
     Serial.println(F("Failed to start program: couldn't allocate SSD1306 Buffer. Not enough memory."));
@@ -138,28 +361,48 @@ void setup()
     }
   }
 
-  initializeAllScreens();
-
   getTimeNow(&time_s);
 
   setPreviousTime();
   setPreviousMillis();
 
-  // initialize PID object temperature history
-  pid.historyIndex = 0;
-  for (int i = 0; i < 5; i++)
-  {
-    pid.temperatureHistory[i] = current_temp;
-  }
+  // initialize PID object derivative history
+  resetPIDHistory(&pid);
 
   // display status screen
   current_mode = MODE_STATUS;
+
+  // a checkpoint still there means the power went, or the board reset, in the middle of a run
+  if (findRunCheckpoint(&resume_checkpoint))
+  {
+    bool known_profile = resume_checkpoint.profile_index < NUM_REFLOW_PROFILES ||
+                         (isLibraryProfile(resume_checkpoint.profile_index) && resume_checkpoint.profile_index < LIBRARY_PROFILE_INDEX + NUM_LIBRARY_PROFILES);
+    if (known_profile && isCheckpointResumable(&resume_checkpoint, current_temp))
+    {
+      populateResumeRunScreen(resume_checkpoint.profile_index, resume_checkpoint.position.index, resume_checkpoint.temp_c);
+      current_mode = MODE_RESUME_RUN;
+      index_to_highlight = 0;
+    }
+    else
+    {
+      // the oven has cooled off (or heated up) too far for the board to carry on where it was
+      Serial.println(F("Run was cut off; oven too far from where it was to resume"));
+      clearRunCheckpoint();
+      commitJournal();
+    }
+  }
 }
 
 void loop()
 {
   // check buttons, assign states
   checkButtonStates(&left_button_pressed, &right_button_pressed, &down_button_pressed, &up_button_pressed, &select_button_pressed);
+  // up/down repeat to scroll; left/right only while stepping a number
+  if (button_repeat && !isNumberHighlighted())
+  {
+    left_button_pressed = false;
+    right_button_pressed = false;
+  }
 
   // check what mode we're in. run the case for that mode.
   switch (current_mode)
@@ -178,12 +421,9 @@ void loop()
     }
 
     // draw status screen
-    dtostrf(current_temp, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");                 // Append the "C" for Celsius
-    initializeScreenItem(&(status_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer));
-    dtostrf(pid.target, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");               // Append the "C" for Celsius
-    initializeScreenItem(&(status_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+    // only re-formatted when the value changes at 0.1C
+    updateBoundScreenItem(&status_temp_item);
+    updateBoundScreenItem(&status_target_item);
 
     drawMenuScreen(&status_screen);
 
@@ -197,7 +437,7 @@ void loop()
     // check what mode is highlighted. if select is pressed, change current_mode to that
     if (select_button_pressed)
     {
-      current_mode = home_screen.menuItems[index_to_highlight].mode;
+      current_mode = getMenuItemMode(&home_screen, index_to_highlight);
       index_to_highlight = 0;
       break;
     }
@@ -211,12 +451,9 @@ void loop()
     }
 
     // draw status screen
-    dtostrf(current_temp, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");                 // Append the "C" for Celsius
-    initializeScreenItem(&(home_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer));
-    dtostrf(pid.target, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");               // Append the "C" for Celsius
-    initializeScreenItem(&(home_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+    // only re-formatted when the value changes at 0.1C
+    updateBoundScreenItem(&home_temp_item);
+    updateBoundScreenItem(&home_target_item);
 
     drawMenuScreen(&home_screen);
 
@@ -229,12 +466,10 @@ void loop()
 
     if (select_button_pressed)
     {
-      current_mode = run_reflow_screen.menuItems[index_to_highlight].mode;
+      current_mode = getMenuItemMode(&run_reflow_screen, index_to_highlight);
       if (index_to_highlight > 0)
       {
-        // put selected profile into selected profile variable
-        currentlySelectedProfile = reflow_profiles[index_to_highlight - 1];
-        profile_index = index_to_highlight - 1;
+        selectProfile(runListProfileIndex(index_to_highlight));
       }
 
       index_to_highlight = 0;
@@ -250,59 +485,76 @@ void loop()
       decrement_highlight(&run_reflow_screen);
     }
 
-    if (index_to_highlight > 0)
+    if (index_to_highlight > 0 && !isLibraryProfile(runListProfileIndex(index_to_highlight)) && (listed_profile_index != runListProfileIndex(index_to_highlight) || listed_profile_write_count != profile_write_count))
+    {
+      // only read the EEPROM when the highlight moves to another profile, or a profile was saved
+      listed_profile_index = runListProfileIndex(index_to_highlight);
+      listed_profile_write_count = profile_write_count;
+      loadProfile(listed_profile_index, &listed_profile);
+    }
+
+    if (index_to_highlight > 0 && isLibraryProfile(runListProfileIndex(index_to_highlight)))
+    {
+      // library profiles list their segments straight from flash
+      for (int i = 0; i < run_reflow_screen.numScreenItems; i++)
+      {
+        describeLibrarySegment(runListProfileIndex(index_to_highlight) - LIBRARY_PROFILE_INDEX, i, reusableBuffer);
+        setScreenItemText(&run_reflow_screen, i, reusableBuffer);
+      }
+    }
+    else if (index_to_highlight > 0)
     {
-      // populate the respective profile data into screen items. get from reflow_profiles[].
+      // populate the respective profile data into screen items. get from listed_profile.
 
       // only room for 8 screen items, but there's 14 items to show, so just kinda shimmy that thang back and forth
-      if ((millis() / SHIMMY_PERIOD) % 2 == 0)
+      if ((millis() / getSetting(SETTING_SHIMMY_PERIOD_MS)) % 2 == 0)
       {
         // first 8 items
-        initializeScreenItem(&(run_reflow_screen.screenItems[0]), "Pre Temp", 8);
+        setScreenItemText(&run_reflow_screen, 0, "Pre Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].preheat_temp_c);
-        initializeScreenItem(&(run_reflow_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer)); // from reflow_profiles[index_to_highlight-1].preheat_temp_c
+        formatFixed(listed_profile.preheat_temp_c, 0, 'C', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 1, reusableBuffer); // from listed_profile.preheat_temp_c
 
-        initializeScreenItem(&(run_reflow_screen.screenItems[2]), "Pre Time", 8);
+        setScreenItemText(&run_reflow_screen, 2, "Pre Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].preheat_time_s);
-        initializeScreenItem(&(run_reflow_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.preheat_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 3, reusableBuffer);
 
-        initializeScreenItem(&(run_reflow_screen.screenItems[4]), "Soak Temp", 9);
+        setScreenItemText(&run_reflow_screen, 4, "Soak Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].soak_temp_c);
-        initializeScreenItem(&(run_reflow_screen.screenItems[5]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.soak_temp_c, 0, 'C', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 5, reusableBuffer);
 
-        initializeScreenItem(&(run_reflow_screen.screenItems[6]), "Soak Time", 9);
+        setScreenItemText(&run_reflow_screen, 6, "Soak Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].soak_time_s);
-        initializeScreenItem(&(run_reflow_screen.screenItems[7]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.soak_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 7, reusableBuffer);
       }
       else
       {
         // last 5 items
-        initializeScreenItem(&(run_reflow_screen.screenItems[0]), "Rfl Temp", 8);
+        setScreenItemText(&run_reflow_screen, 0, "Rfl Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].reflow_temp);
-        initializeScreenItem(&(run_reflow_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.reflow_temp, 0, 'C', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 1, reusableBuffer);
 
-        initializeScreenItem(&(run_reflow_screen.screenItems[2]), "Rfl Time", 8);
+        setScreenItemText(&run_reflow_screen, 2, "Rfl Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].reflow_hold_time_s);
-        initializeScreenItem(&(run_reflow_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.reflow_hold_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&run_reflow_screen, 3, reusableBuffer);
 
-        if (reflow_profiles[index_to_highlight - 1].fan_on)
+        if (listed_profile.fan_on)
         {
-          initializeScreenItem(&(run_reflow_screen.screenItems[4]), "Fan: On", 7);
+          setScreenItemText(&run_reflow_screen, 4, "Fan: On");
         }
         else
         {
-          initializeScreenItem(&(run_reflow_screen.screenItems[4]), "Fan: Off", 8);
+          setScreenItemText(&run_reflow_screen, 4, "Fan: Off");
         }
 
-        initializeScreenItem(&(run_reflow_screen.screenItems[5]), " ", 1);
-        initializeScreenItem(&(run_reflow_screen.screenItems[6]), " ", 1);
-        initializeScreenItem(&(run_reflow_screen.screenItems[7]), " ", 1);
+        setScreenItemText(&run_reflow_screen, 5, " ");
+        setScreenItemText(&run_reflow_screen, 6, " ");
+        setScreenItemText(&run_reflow_screen, 7, " ");
       }
     }
     else
@@ -310,7 +562,7 @@ void loop()
       // all screen items are blank
       for (int i = 0; i < run_reflow_screen.numScreenItems; i++)
       {
-        initializeScreenItem(&(run_reflow_screen.screenItems[i]), " ", 1);
+        setScreenItemText(&run_reflow_screen, i, " ");
       }
     }
 
@@ -325,10 +577,30 @@ void loop()
 
     if (select_button_pressed)
     {
-      current_mode = selected_to_run_screen.menuItems[index_to_highlight].mode;
-      if (current_mode == MODE_PROFILE_SELECTED_RUNNING)
+      current_mode = getMenuItemMode(&selected_to_run_screen, index_to_highlight);
+      if (current_mode == MODE_PROFILE_SELECTED_RUNNING && !startRun(NULL))
+      {
+        current_mode = MODE_PROFILE_SELECTED_TO_RUN;
+        break;
+      }
+      else if (current_mode == MODE_BATCH_STANDBY)
       {
-        setPreviousTime();
+        beginBatch(&batch, getSetting(SETTING_BATCH_RUNS));
+      }
+      else if (current_mode == MODE_EDIT_SELECTED_PROFILE && isLibraryProfile(profile_index))
+      {
+        // the library is read-only; edit a copy in a slot picked next
+        if (libraryToReflowProfile(profile_index - LIBRARY_PROFILE_INDEX, &currentlySelectedProfile))
+        {
+          copying_library_profile = true;
+          current_mode = MODE_SELECT_PROFILE_TO_EDIT;
+        }
+        else
+        {
+          Serial.println(F("Profile isn't preheat/soak/reflow; can't be edited"));
+          current_mode = MODE_PROFILE_SELECTED_TO_RUN;
+          break;
+        }
       }
 
       index_to_highlight = 0;
@@ -343,75 +615,161 @@ void loop()
       decrement_highlight(&selected_to_run_screen);
     }
 
-    if ((millis() / SHIMMY_PERIOD) % 2 == 0)
-    {
-      // first 8 items
-      initializeScreenItem(&(selected_to_run_screen.screenItems[0]), "Pre Temp", 8);
-
-      sprintf(reusableBuffer, "%dC", currentlySelectedProfile.preheat_temp_c);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer)); // from reflow_profiles[index_to_highlight-1].preheat_temp_c
-
-      initializeScreenItem(&(selected_to_run_screen.screenItems[2]), "Pre Time", 8);
-
-      sprintf(reusableBuffer, "%ds", currentlySelectedProfile.preheat_time_s);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
-
-      initializeScreenItem(&(selected_to_run_screen.screenItems[4]), "Soak Temp", 9);
+    // labels and graph were cached when the profile was selected; just draw them
+    renderMenuScreen(&selected_to_run_screen);
+    drawProfileGraph(&selected_profile_graph);
+    requestDisplayFlush();
+    break;
+  case MODE_RESUME_RUN:
+    flag_PID_running = false;
+    pid.target = 0.0f;
 
-      sprintf(reusableBuffer, "%dC", currentlySelectedProfile.soak_temp_c);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[5]), reusableBuffer, strlen(reusableBuffer));
+    set_item_to_highlight(&resume_run_screen, index_to_highlight);
 
-      initializeScreenItem(&(selected_to_run_screen.screenItems[6]), "Soak Time", 9);
+    if (select_button_pressed)
+    {
+      current_mode = getMenuItemMode(&resume_run_screen, index_to_highlight);
+      if (current_mode == MODE_PROFILE_SELECTED_RUNNING)
+      {
+        selectProfile(resume_checkpoint.profile_index);
+        if (!startRun(&resume_checkpoint))
+        {
+          current_mode = MODE_PROFILE_SELECTED_TO_RUN;
+        }
+      }
+      else
+      {
+        clearRunCheckpoint();
+        commitJournal();
+      }
 
-      sprintf(reusableBuffer, "%ds", currentlySelectedProfile.soak_time_s);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[7]), reusableBuffer, strlen(reusableBuffer));
+      index_to_highlight = 0;
+      break;
     }
-    else
+    else if (down_button_pressed)
     {
-      // last 5 items
-      initializeScreenItem(&(selected_to_run_screen.screenItems[0]), "Rfl Temp", 8);
-
-      sprintf(reusableBuffer, "%dC", currentlySelectedProfile.reflow_temp);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer));
+      increment_highlight(&resume_run_screen);
+    }
+    else if (up_button_pressed)
+    {
+      decrement_highlight(&resume_run_screen);
+    }
 
-      initializeScreenItem(&(selected_to_run_screen.screenItems[2]), "Rfl Time", 8);
+    drawMenuScreen(&resume_run_screen);
+    break;
+  case MODE_BATCH_STANDBY:
+    flag_PID_running = true;
+    pid.target = getSetting(SETTING_STANDBY_C);
+    getTimeNow(&time_s);
 
-      sprintf(reusableBuffer, "%ds", currentlySelectedProfile.reflow_hold_time_s);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+    if (left_button_pressed || !batch.active)
+    {
+      current_mode = MODE_PROFILE_SELECTED_TO_RUN;
+      index_to_highlight = 0;
+      flag_PID_running = false;
+      pid.target = 0.0f;
+      digitalWrite(FAN_RELAY_PIN, LOW);
+      digitalWrite(HEAT_RELAY_PIN, LOW);
+      endBatch(&batch);
+      break;
+    }
+    else if (select_button_pressed)
+    {
+      // confirms the next board is in; press again to take it back
+      batch.loaded = !batch.loaded;
+    }
 
-      if (currentlySelectedProfile.fan_on)
-      {
-        initializeScreenItem(&(selected_to_run_screen.screenItems[4]), "Fan: On", 7);
-      }
-      else
+    if (current_temp >= 5 && isBatchReady(&batch, current_temp, getSetting(SETTING_STANDBY_C), getSetting(SETTING_START_WINDOW_C)))
+    {
+      if (!startRun(NULL))
       {
-        initializeScreenItem(&(selected_to_run_screen.screenItems[4]), "Fan: Off", 8);
+        endBatch(&batch);
+        current_mode = MODE_PROFILE_SELECTED_TO_RUN;
+        break;
       }
+      startBatchRun(&batch, previous_time);
+      current_mode = MODE_PROFILE_SELECTED_RUNNING;
+      break;
+    }
 
-      initializeScreenItem(&(selected_to_run_screen.screenItems[5]), " ", 1);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[6]), " ", 1);
-      initializeScreenItem(&(selected_to_run_screen.screenItems[7]), " ", 1);
+    // fan on to get down from the last run's peak sooner
+    if (current_temp > getSetting(SETTING_STANDBY_C) + getSetting(SETTING_START_WINDOW_C))
+    {
+      digitalWrite(FAN_RELAY_PIN, HIGH);
+    }
+    else
+    {
+      digitalWrite(FAN_RELAY_PIN, LOW);
     }
-    drawMenuScreen(&selected_to_run_screen);
+
+    display.clearDisplay();
+    display.setTextSize(1);              // Normal 1:1 pixel scale
+    display.setTextColor(SSD1306_WHITE); // Draw white text
+    display.setFont(NULL);               // Default font
+    display.setCursor(0, 0);
+    display.print(F("Batch "));
+    display.print(batch.done + 1);
+    display.print('/');
+    display.println(batch.total);
+    display.setCursor(64, 0);
+    formatFixed(getBatchRate(&batch, time_s), 1, 0, reusableBuffer);
+    display.print(reusableBuffer);
+    display.println(F("/h"));
+    display.setCursor(0, 16);
+    display.println(F("Temp:"));
+    display.setCursor(64, 16);
+    display.println(F("Standby:"));
+    display.setCursor(0, 24);
+    formatFixed(toFixed(current_temp, 1), 1, 'C', reusableBuffer);
+    display.println(reusableBuffer);
+    display.setCursor(64, 24);
+    formatFixed(pid.target, 0, 'C', reusableBuffer);
+    display.println(reusableBuffer);
+    display.setCursor(0, 40);
+    if (batch.loaded)
+    {
+      display.println(F("Loaded, waiting"));
+    }
+    else
+    {
+      display.println(F("Load board, sel=go"));
+    }
+    display.setCursor(0, 56);
+    display.println(F("< to stop batch"));
+    requestDisplayFlush();
+
     break;
   case MODE_PROFILE_SELECTED_RUNNING:
 
+    getTimeNow(&time_s);
+
     if (select_button_pressed)
     {
       current_mode = MODE_PROFILE_SELECTED_TO_RUN;
       index_to_highlight = 0;
-      flag_PID_running = false;
-      pid.target = 0;
-      digitalWrite(FAN_RELAY_PIN, LOW);
-      digitalWrite(HEAT_RELAY_PIN, LOW);
-      hold_reflow_time_started = false;
+      stopRun();
+      endBatch(&batch);
+      commitJournal();
       break;
     }
+    else if (right_button_pressed && !button_repeat)
+    {
+      // pause holds the setpoint where it is and stops the step clock. one toggle per push: holding Right
+      // must not flip it back and forth, committing the journal on every pause
+      if (plan_run.paused)
+      {
+        resumeRunPlan(&plan_run, time_s);
+      }
+      else
+      {
+        pauseRunPlan(&plan_run, time_s);
+        saveRunCheckpoint(profile_index, &plan_run, time_s, current_temp);
+      }
+    }
 
     flag_PID_running = true;
 
     // profile logic
-    getTimeNow(&time_s);
     // fail or refuse to run this if the get temperature method returns false.
     if (current_temp < 5)
     {
@@ -428,57 +786,71 @@ void loop()
       flag_PID_running = false;
       digitalWrite(FAN_RELAY_PIN, LOW);
       digitalWrite(HEAT_RELAY_PIN, LOW);
-      display.display();
+      requestDisplayFlush();
 
       break;
     }
 
-    if (time_s - previous_time <= currentlySelectedProfile.preheat_time_s)
-    {
-      // preheat logic
-
-      pid.target = currentlySelectedProfile.preheat_temp_c;
-    }
-    else if (time_s - previous_time > currentlySelectedProfile.preheat_time_s && time_s - previous_time <= currentlySelectedProfile.soak_time_s + currentlySelectedProfile.preheat_time_s)
-    {
-      // soak logic
-
-      pid.target = currentlySelectedProfile.soak_temp_c;
-    }
-    else if (time_s - previous_time > currentlySelectedProfile.soak_time_s + currentlySelectedProfile.preheat_time_s)
+    // the run plan moves the setpoint and decides when each step, and the run, is finished
+    if (!stepRunPlan(&plan_run, &run_plan, time_s, current_temp))
     {
+      // only runs that got all the way through teach the next one
+      if (!plan_run.timed_out && learning.active)
+      {
+        float mean_error = finishLearning(&learning);
+        Serial.print(F("Learning: run "));
+        Serial.print(learning.record.runs);
+        Serial.print(F(", mean error "));
+        Serial.print(mean_error, 1);
+        Serial.println('C');
+      }
 
-      pid.target = currentlySelectedProfile.reflow_temp;
-      // reflow logic (+ hold time)
-      // wait for current temp to reach reflow. then start counting reflow hold time
-      if (current_temp < currentlySelectedProfile.reflow_temp)
+      // break, go to select profile
+      stopRun();
+      if (plan_run.timed_out)
       {
-        // do nothing; wait when temp reaches goal
+        // a stage never got within its gate band; the board didn't get the profile it asked for
+        Serial.print(F("Run aborted: segment "));
+        Serial.print(plan_run.index + 1);
+        Serial.println(F(" timed out waiting for temperature"));
+        endBatch(&batch);
       }
       else
       {
-        // once temp reaches goal. start counting hold time
+        addJournalValue(JOURNAL_COMPLETED_RUNS, 1);
+      }
+      commitJournal();
+      current_mode = MODE_SELECT_PROFILE_TO_RUN;
+      index_to_highlight = 0;
 
-        if (!hold_reflow_time_started)
+      if (batch.active)
+      {
+        // straight back to standby for the next board
+        bool more = finishBatchRun(&batch);
+        Serial.print(F("Batch: "));
+        Serial.print(batch.done);
+        Serial.print('/');
+        Serial.print(batch.total);
+        Serial.print(F(" done, "));
+        formatFixed(getBatchRate(&batch, time_s), 1, 0, reusableBuffer);
+        Serial.print(reusableBuffer);
+        Serial.println(F(" boards/h"));
+        if (more)
         {
-          hold_reflow_time = time_s + currentlySelectedProfile.reflow_hold_time_s;
-          hold_reflow_time_started = true;
-        }
-
-        if (time_s > hold_reflow_time)
-        {
-          pid.target = 0.0f;
-          flag_PID_running = false;
-
-          // break, go to select profile
-          current_mode = MODE_SELECT_PROFILE_TO_RUN;
-          index_to_highlight = 0;
-          break;
+          current_mode = MODE_BATCH_STANDBY;
         }
       }
+      break;
+    }
+    pid.target = plan_run.setpoint_c;
+
+    // every RUN_CHECKPOINT_INTERVAL_S and every step change, so a reset can pick the run back up
+    if (!plan_run.paused)
+    {
+      serviceRunCheckpoint(profile_index, &plan_run, time_s, current_temp);
     }
 
-    if (currentlySelectedProfile.fan_on && flag_PID_running == true)
+    if (isRunPlanFanOn(&plan_run, &run_plan) && flag_PID_running == true)
     {
       digitalWrite(FAN_RELAY_PIN, HIGH);
     }
@@ -486,6 +858,10 @@ void loop()
     {
       digitalWrite(FAN_RELAY_PIN, LOW);
     }
+
+    // one sample per second into the EEPROM trace ring
+    recordTraceSample(time_s, current_temp, pid.target, digitalRead(HEAT_RELAY_PIN) == HIGH);
+
     // drawing/screen stuff
     display.clearDisplay();
     display.setTextSize(1);              // Normal 1:1 pixel scale
@@ -499,19 +875,22 @@ void loop()
       display.setCursor(64, 0);
       display.println(F("Target:"));
       display.setCursor(0, 8);
-      dtostrf(current_temp, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-      strcat(reusableBuffer, "C");                 // Append the "C" for Celsius
+      formatFixed(toFixed(current_temp, 1), 1, 'C', reusableBuffer);
       display.println(reusableBuffer);
       display.setCursor(64, 8);
-      dtostrf(pid.target, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-      strcat(reusableBuffer, "C");               // Append the "C" for Celsius
+      formatFixed(toFixed(pid.target, 1), 1, 'C', reusableBuffer);
       display.println(reusableBuffer);
       display.setCursor(28, 24);
       display.println("Time Passed:");
       display.setCursor(62, 32);
-      sprintf(reusableBuffer, "%ds", (int)(time_s - previous_time));
+      formatFixed((int)(time_s - previous_time), 0, 's', reusableBuffer);
       display.println(reusableBuffer);
-      display.display();
+      if (plan_run.paused)
+      {
+        display.setCursor(0, 48);
+        display.println(F("PAUSED  > to go on"));
+      }
+      requestDisplayFlush();
     }
     else
     {
@@ -522,7 +901,7 @@ void loop()
       display.fillRect(0, 0, 128, 64, SSD1306_WHITE);
       display.setCursor(34, 24);
       display.println("Done!");
-      display.display();
+      requestDisplayFlush();
     }
 
     break;
@@ -534,13 +913,17 @@ void loop()
 
     if (select_button_pressed)
     {
-      current_mode = select_profile_to_edit_screen.menuItems[index_to_highlight].mode;
+      current_mode = getMenuItemMode(&select_profile_to_edit_screen, index_to_highlight);
       if (index_to_highlight > 0)
       {
-        // put selected profile into selected profile variable
-        currentlySelectedProfile = reflow_profiles[index_to_highlight - 1];
+        // put selected profile into selected profile variable. a library copy replaces the slot once saved
         profile_index = index_to_highlight - 1;
+        if (!copying_library_profile)
+        {
+          loadProfile(profile_index, &currentlySelectedProfile);
+        }
       }
+      copying_library_profile = false;
 
       index_to_highlight = 0;
 
@@ -555,59 +938,67 @@ void loop()
       decrement_highlight(&select_profile_to_edit_screen);
     }
 
+    if (index_to_highlight > 0 && (listed_profile_index != index_to_highlight - 1 || listed_profile_write_count != profile_write_count))
+    {
+      // only read the EEPROM when the highlight moves to another profile, or a profile was saved
+      listed_profile_index = index_to_highlight - 1;
+      listed_profile_write_count = profile_write_count;
+      loadProfile(listed_profile_index, &listed_profile);
+    }
+
     if (index_to_highlight > 0)
     {
-      // populate the respective profile data into screen items. get from reflow_profiles[].
+      // populate the respective profile data into screen items. get from listed_profile.
 
       // only room for 8 screen items, but there's 14 items to show, so just kinda shimmy that thang back and forth
-      if ((millis() / SHIMMY_PERIOD) % 2 == 0)
+      if ((millis() / getSetting(SETTING_SHIMMY_PERIOD_MS)) % 2 == 0)
       {
         // first 8 items
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[0]), "Pre Temp", 8);
+        setScreenItemText(&select_profile_to_edit_screen, 0, "Pre Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].preheat_temp_c);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer)); // from reflow_profiles[index_to_highlight-1].preheat_temp_c
+        formatFixed(listed_profile.preheat_temp_c, 0, 'C', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 1, reusableBuffer); // from listed_profile.preheat_temp_c
 
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[2]), "Pre Time", 8);
+        setScreenItemText(&select_profile_to_edit_screen, 2, "Pre Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].preheat_time_s);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.preheat_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 3, reusableBuffer);
 
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[4]), "Soak Temp", 9);
+        setScreenItemText(&select_profile_to_edit_screen, 4, "Soak Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].soak_temp_c);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[5]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.soak_temp_c, 0, 'C', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 5, reusableBuffer);
 
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[6]), "Soak Time", 9);
+        setScreenItemText(&select_profile_to_edit_screen, 6, "Soak Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].soak_time_s);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[7]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.soak_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 7, reusableBuffer);
       }
       else
       {
         // last 5 items
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[0]), "Rfl Temp", 8);
+        setScreenItemText(&select_profile_to_edit_screen, 0, "Rfl Temp");
 
-        sprintf(reusableBuffer, "%dC", reflow_profiles[index_to_highlight - 1].reflow_temp);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[1]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.reflow_temp, 0, 'C', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 1, reusableBuffer);
 
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[2]), "Rfl Time", 8);
+        setScreenItemText(&select_profile_to_edit_screen, 2, "Rfl Time");
 
-        sprintf(reusableBuffer, "%ds", reflow_profiles[index_to_highlight - 1].reflow_hold_time_s);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[3]), reusableBuffer, strlen(reusableBuffer));
+        formatFixed(listed_profile.reflow_hold_time_s, 0, 's', reusableBuffer);
+        setScreenItemText(&select_profile_to_edit_screen, 3, reusableBuffer);
 
-        if (reflow_profiles[index_to_highlight - 1].fan_on)
+        if (listed_profile.fan_on)
         {
-          initializeScreenItem(&(select_profile_to_edit_screen.screenItems[4]), "Fan: On", 7);
+          setScreenItemText(&select_profile_to_edit_screen, 4, "Fan: On");
         }
         else
         {
-          initializeScreenItem(&(select_profile_to_edit_screen.screenItems[4]), "Fan: Off", 8);
+          setScreenItemText(&select_profile_to_edit_screen, 4, "Fan: Off");
         }
 
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[5]), " ", 1);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[6]), " ", 1);
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[7]), " ", 1);
+        setScreenItemText(&select_profile_to_edit_screen, 5, " ");
+        setScreenItemText(&select_profile_to_edit_screen, 6, " ");
+        setScreenItemText(&select_profile_to_edit_screen, 7, " ");
       }
     }
     else
@@ -615,7 +1006,7 @@ void loop()
       // all screen items are blank
       for (int i = 0; i < select_profile_to_edit_screen.numScreenItems; i++)
       {
-        initializeScreenItem(&(select_profile_to_edit_screen.screenItems[i]), " ", 1);
+        setScreenItemText(&select_profile_to_edit_screen, i, " ");
       }
     }
 
@@ -626,69 +1017,58 @@ void loop()
     set_item_to_highlight(&edit_reflow_screen, index_to_highlight);
     if (select_button_pressed && index_to_highlight == 0)
     {
-      current_mode = edit_reflow_screen.menuItems[index_to_highlight].mode;
-      getProfilesFromEEPROM(reflow_profiles, NUM_REFLOW_PROFILES, DEFAULT_PROFILES_ADDRESS);
-      currentlySelectedProfile = reflow_profiles[profile_index];
+      current_mode = getMenuItemMode(&edit_reflow_screen, index_to_highlight);
+      loadProfile(profile_index, &currentlySelectedProfile);
+      populateSelectedToRunScreen(&currentlySelectedProfile);
       index_to_highlight = 0;
       break;
     }
-    else if (select_button_pressed && index_to_highlight == 8)
+    else if (select_button_pressed && index_to_highlight == 11)
+    {
+      // stretch the stages the oven can't get through in time
+      fitProfileToOven(&currentlySelectedProfile);
+    }
+    else if (select_button_pressed && index_to_highlight == 12)
     {
       // save currently selected profile to EEPROM (keep track of which index it's in since EEPROM has X profiles)
-      reflow_profiles[profile_index] = currentlySelectedProfile;
-      saveProfilesToEEPROM(reflow_profiles, NUM_REFLOW_PROFILES, DEFAULT_PROFILES_ADDRESS);
+      writeProfileRecord(profile_index, &currentlySelectedProfile);
+      populateSelectedToRunScreen(&currentlySelectedProfile);
     }
-    else if (right_button_pressed)
+    else if (right_button_pressed || left_button_pressed)
     {
+      // held buttons repeat and accelerate; see editor.h
+      int direction = right_button_pressed ? 1 : -1;
       switch (index_to_highlight)
       {
       case 1:
-        currentlySelectedProfile.preheat_temp_c = currentlySelectedProfile.preheat_temp_c + 1;
+        editIntValue(&currentlySelectedProfile.preheat_temp_c, direction, MIN_TEMP_C, MAX_TEMP_C);
         break;
       case 2:
-        currentlySelectedProfile.preheat_time_s = currentlySelectedProfile.preheat_time_s + 1;
+        editIntValue(&currentlySelectedProfile.preheat_time_s, direction, MIN_TIME_S, MAX_TIME_S);
         break;
       case 3:
-        currentlySelectedProfile.soak_temp_c = currentlySelectedProfile.soak_temp_c + 1;
+        editIntValue(&currentlySelectedProfile.soak_temp_c, direction, MIN_TEMP_C, MAX_TEMP_C);
         break;
       case 4:
-        currentlySelectedProfile.soak_time_s = currentlySelectedProfile.soak_time_s + 1;
+        editIntValue(&currentlySelectedProfile.soak_time_s, direction, MIN_TIME_S, MAX_TIME_S);
         break;
       case 5:
-        currentlySelectedProfile.reflow_temp = currentlySelectedProfile.reflow_temp + 1;
+        editIntValue(&currentlySelectedProfile.reflow_temp, direction, MIN_TEMP_C, MAX_TEMP_C);
         break;
       case 6:
-        currentlySelectedProfile.reflow_hold_time_s = currentlySelectedProfile.reflow_hold_time_s + 1;
+        editIntValue(&currentlySelectedProfile.reflow_hold_time_s, direction, MIN_TIME_S, MAX_TIME_S);
         break;
       case 7:
         currentlySelectedProfile.fan_on = !currentlySelectedProfile.fan_on;
         break;
-      }
-    }
-    else if (left_button_pressed)
-    {
-      switch (index_to_highlight)
-      {
-      case 1:
-        currentlySelectedProfile.preheat_temp_c = currentlySelectedProfile.preheat_temp_c - 1;
-        break;
-      case 2:
-        currentlySelectedProfile.preheat_time_s = currentlySelectedProfile.preheat_time_s - 1;
-        break;
-      case 3:
-        currentlySelectedProfile.soak_temp_c = currentlySelectedProfile.soak_temp_c - 1;
-        break;
-      case 4:
-        currentlySelectedProfile.soak_time_s = currentlySelectedProfile.soak_time_s - 1;
+      case 8:
+        editGate(&currentlySelectedProfile.preheat_gate, direction);
         break;
-      case 5:
-        currentlySelectedProfile.reflow_temp = currentlySelectedProfile.reflow_temp - 1;
+      case 9:
+        editGate(&currentlySelectedProfile.soak_gate, direction);
         break;
-      case 6:
-        currentlySelectedProfile.reflow_hold_time_s = currentlySelectedProfile.reflow_hold_time_s - 1;
-        break;
-      case 7:
-        currentlySelectedProfile.fan_on = !currentlySelectedProfile.fan_on;
+      case 10:
+        editGate(&currentlySelectedProfile.reflow_gate, direction);
         break;
       }
     }
@@ -705,31 +1085,31 @@ void loop()
     {
     case 0:
       // cancel / back
-      initializeScreenItem(&(edit_reflow_screen.screenItems[0]), " ", 1);
+      strcpy(reusableBuffer, " ");
       break;
     case 1:
       // preheat temp
-      dtostrf(currentlySelectedProfile.preheat_temp_c, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.preheat_temp_c, 0, 0, reusableBuffer);
       break;
     case 2:
       // preheat time
-      dtostrf(currentlySelectedProfile.preheat_time_s, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.preheat_time_s, 0, 0, reusableBuffer);
       break;
     case 3:
       // soak temp
-      dtostrf(currentlySelectedProfile.soak_temp_c, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.soak_temp_c, 0, 0, reusableBuffer);
       break;
     case 4:
       // soak time
-      dtostrf(currentlySelectedProfile.soak_time_s, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.soak_time_s, 0, 0, reusableBuffer);
       break;
     case 5:
       // reflow temp
-      dtostrf(currentlySelectedProfile.reflow_temp, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.reflow_temp, 0, 0, reusableBuffer);
       break;
     case 6:
       // reflow hold time
-      dtostrf(currentlySelectedProfile.reflow_hold_time_s, 1, 1, reusableBuffer);
+      formatFixed(currentlySelectedProfile.reflow_hold_time_s, 0, 0, reusableBuffer);
       break;
     case 7:
       // fan on/off
@@ -743,12 +1123,27 @@ void loop()
       }
       break;
     case 8:
+      // preheat gate
+      formatGate(currentlySelectedProfile.preheat_gate, reusableBuffer);
+      break;
+    case 9:
+      // soak gate
+      formatGate(currentlySelectedProfile.soak_gate, reusableBuffer);
+      break;
+    case 10:
+      // reflow hold gate
+      formatGate(currentlySelectedProfile.reflow_gate, reusableBuffer);
+      break;
+    case 11:
+      // fit to oven
+    case 12:
       // save to eeprom
-      initializeScreenItem(&(edit_reflow_screen.screenItems[0]), " ", 1);
+      strcpy(reusableBuffer, " ");
       break;
     }
 
-    initializeScreenItem(&(edit_reflow_screen.screenItems[0]), reusableBuffer, strlen(reusableBuffer));
+    setScreenItemText(&edit_reflow_screen, 0, reusableBuffer);
+    checkEditedProfile();
     drawMenuScreen(&edit_reflow_screen);
 
     break;
@@ -760,15 +1155,15 @@ void loop()
 
     if (select_button_pressed)
     {
-      current_mode = edit_pid_screen.menuItems[index_to_highlight].mode;
-      if (current_mode == MODE_EDIT_PID_PRAMS && index_to_highlight < 6)
+      current_mode = getMenuItemMode(&edit_pid_screen, index_to_highlight);
+      if (current_mode == MODE_EDIT_PID_PRAMS && index_to_highlight < 5)
       {
         // nothing
       }
-      else if (current_mode == MODE_EDIT_PID_PRAMS && index_to_highlight == 6)
+      else if (current_mode == MODE_EDIT_PID_PRAMS && index_to_highlight == 5)
       {
         // save current constants to EEPROM
-        save_PID_constants_to_EEPROM(DEFAULT_CONSTANTS_ADDRESS, &(pid.constants));
+        writePIDConstantsRecord(&(pid.constants));
       }
       else
       {
@@ -784,47 +1179,23 @@ void loop()
     {
       decrement_highlight(&edit_pid_screen);
     }
-    else if (right_button_pressed)
+    else if (right_button_pressed || left_button_pressed)
     {
-      // increment currently highlighted PID constant if a PID constant is highlighted.
+      // change currently highlighted PID constant if a PID constant is highlighted. held buttons repeat and accelerate
+      int direction = right_button_pressed ? 1 : -1;
       switch (index_to_highlight)
       {
       case 1:
-        pid.constants.PID_k += incrementor;
+        editDoubleValue(&pid.constants.PID_k, direction, PID_EDIT_RESOLUTION, MIN_CONSTANTS_VALUE, MAX_CONSTANTS_VALUE);
         break;
       case 2:
-        pid.constants.PID_i += incrementor;
+        editDoubleValue(&pid.constants.PID_i, direction, PID_EDIT_RESOLUTION, MIN_CONSTANTS_VALUE, MAX_CONSTANTS_VALUE);
         break;
       case 3:
-        pid.constants.PID_d += incrementor;
+        editDoubleValue(&pid.constants.PID_d, direction, PID_EDIT_RESOLUTION, MIN_CONSTANTS_VALUE, MAX_CONSTANTS_VALUE);
         break;
       case 4:
-        pid.constants.threshold += incrementor;
-        break;
-      case 5:
-        incrementor += 1.0f;
-        break;
-      }
-    }
-    else if (left_button_pressed)
-    {
-      // decrement currently highlighted PID constant if a PID constant is highlighted.
-      switch (index_to_highlight)
-      {
-      case 1:
-        pid.constants.PID_k -= incrementor;
-        break;
-      case 2:
-        pid.constants.PID_i -= incrementor;
-        break;
-      case 3:
-        pid.constants.PID_d -= incrementor;
-        break;
-      case 4:
-        pid.constants.threshold -= incrementor;
-        break;
-      case 5:
-        incrementor -= 0.1f;
+        editDoubleValue(&pid.constants.threshold, direction, PID_EDIT_RESOLUTION, MIN_THRESHOLD_VALUE, MAX_THRESHOLD_VALUE);
         break;
       }
     }
@@ -833,29 +1204,79 @@ void loop()
     switch (index_to_highlight)
     {
     case 1:
-      dtostrf(pid.constants.PID_k, 1, 1, reusableBuffer);
+      formatFixed(toFixed(pid.constants.PID_k, 1), 1, 0, reusableBuffer);
       break;
     case 2:
-      dtostrf(pid.constants.PID_i, 1, 1, reusableBuffer);
+      formatFixed(toFixed(pid.constants.PID_i, 1), 1, 0, reusableBuffer);
       break;
     case 3:
-      dtostrf(pid.constants.PID_d, 1, 1, reusableBuffer);
+      formatFixed(toFixed(pid.constants.PID_d, 1), 1, 0, reusableBuffer);
       break;
     case 4:
-      dtostrf(pid.constants.threshold, 1, 1, reusableBuffer);
-      break;
-    case 5:
-      dtostrf(incrementor, 1, 1, reusableBuffer);
+      formatFixed(toFixed(pid.constants.threshold, 1), 1, 0, reusableBuffer);
       break;
     default:
       strcpy(reusableBuffer, " ");
       break;
     }
 
-    initializeScreenItem(&(edit_pid_screen.screenItems[0]), reusableBuffer, strlen(reusableBuffer));
+    setScreenItemText(&edit_pid_screen, 0, reusableBuffer);
 
     drawMenuScreen(&edit_pid_screen);
 
+    break;
+  case MODE_EDIT_SETTINGS:
+    flag_PID_running = false;
+    pid.target = 0.0f;
+
+    set_item_to_highlight(&edit_settings_screen, index_to_highlight);
+
+    if (select_button_pressed)
+    {
+      current_mode = getMenuItemMode(&edit_settings_screen, index_to_highlight);
+      if (index_to_highlight == 0)
+      {
+        // cancel; changes were applied live, so put the saved ones back
+        loadSettings();
+      }
+      else if (index_to_highlight == NUM_SETTINGS + 1)
+      {
+        saveSettings();
+      }
+
+      if (current_mode != MODE_EDIT_SETTINGS)
+      {
+        index_to_highlight = 0;
+        break;
+      }
+    }
+    else if (down_button_pressed)
+    {
+      increment_highlight(&edit_settings_screen);
+    }
+    else if (up_button_pressed)
+    {
+      decrement_highlight(&edit_settings_screen);
+    }
+    else if ((right_button_pressed || left_button_pressed) && index_to_highlight >= 1 && index_to_highlight <= NUM_SETTINGS)
+    {
+      // held buttons repeat and accelerate
+      editSetting(index_to_highlight - 1, right_button_pressed ? 1 : -1);
+    }
+
+    // show the highlighted setting's value
+    if (index_to_highlight >= 1 && index_to_highlight <= NUM_SETTINGS)
+    {
+      formatSetting(index_to_highlight - 1, reusableBuffer);
+    }
+    else
+    {
+      strcpy(reusableBuffer, " ");
+    }
+
+    setScreenItemText(&edit_settings_screen, 0, reusableBuffer);
+    drawMenuScreen(&edit_settings_screen);
+
     break;
   case MODE_HEAT_TO_TARGET:
     flag_PID_running = true;
@@ -911,7 +1332,7 @@ void loop()
       flag_PID_running = false;
       digitalWrite(FAN_RELAY_PIN, LOW);
       digitalWrite(HEAT_RELAY_PIN, LOW);
-      display.display();
+      requestDisplayFlush();
 
       break;
     }
@@ -926,30 +1347,38 @@ void loop()
     display.setCursor(64, 0);
     display.println(F("Target:"));
     display.setCursor(0, 8);
-    dtostrf(current_temp, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");                 // Append the "C" for Celsius
+    formatFixed(toFixed(current_temp, 1), 1, 'C', reusableBuffer);
     display.println(reusableBuffer);
     display.setCursor(64, 8);
-    dtostrf(pid.target, 1, 1, reusableBuffer); // 1 is min width, 1 is precision
-    strcat(reusableBuffer, "C");               // Append the "C" for Celsius
+    formatFixed(toFixed(pid.target, 1), 1, 'C', reusableBuffer);
     display.println(reusableBuffer);
-    display.display();
+    requestDisplayFlush();
 
     break;
   }
 
-  // if PID is running, check if MS_BETWEEN_PIDms has passed since last check. if no, then just skip the PID calc
-  // if  it has been MS_BETWEEN_PID, then evaluate the PID loop and set previous millis to now
+  // if PID is running, check if pid_period_ms has passed since last check. if no, then just skip the PID calc
+  // if  it has been pid_period_ms, then evaluate the PID loop and set previous millis to now
   getTimeNow(&time_s);
 
   if (current_temp >= 5)
   {
     pid.input = current_temp;
 
-    if (flag_PID_running && ((millis() - previousMillis) >= MS_BETWEEN_PID))
+    if (flag_PID_running && ((millis() - previousMillis) >= pid_period_ms))
     {
 
+      // heater on-time total, whole seconds at a time
+      if (digitalRead(HEAT_RELAY_PIN) == HIGH)
+      {
+        heater_on_ms += millis() - previousMillis;
+        addJournalValue(JOURNAL_HEATER_ON_S, heater_on_ms / 1000);
+        heater_on_ms %= 1000;
+      }
+
       pid.dt = (double)((double)millis() - (double)previousMillis) / 1000.0f;
+      // corrections learned from earlier runs of the profile; 0 outside a run
+      pid.feedforward = getLearningCorrection(&learning);
       if (calculatePID(&pid))
       {
         // turn heater on
@@ -960,11 +1389,43 @@ void loop()
         // turn heater off
         digitalWrite(HEAT_RELAY_PIN, LOW);
       }
+      if (!plan_run.paused)
+      {
+        stepLearning(&learning, pid.dt, pid.target, pid.error);
+      }
+
+      if (isRunLogActive())
+      {
+        RunLogSample sample;
+        sample.ms = millis() - run_start_ms;
+        sample.temp_c = pid.input;
+        sample.target_c = pid.target;
+        sample.p_term = pid.constants.PID_k * pid.error;
+        sample.i_term = pid.constants.PID_i * pid.integral;
+        sample.d_term = pid.constants.PID_d * pid.derivative;
+        sample.output = pid.output;
+        sample.heater_on = digitalRead(HEAT_RELAY_PIN) == HIGH;
+        sample.fan_on = digitalRead(FAN_RELAY_PIN) == HIGH;
+        logRunSample(&sample);
+      }
       setPreviousMillis();
+
+      // short on ramps and coming up to the setpoint, long on steady holds. a tick faster than the
+      // thermocouple is read would only see the same reading again
+      unsigned long fast_ms = max((unsigned long)FAST_MS_BETWEEN_PID, (unsigned long)getSetting(SETTING_THERMO_READ_MS));
+      unsigned long normal_ms = getSetting(SETTING_PID_PERIOD_MS);
+      pid_period_ms = getPIDPeriod(&pid, min(fast_ms, normal_ms), normal_ms, max((unsigned long)SLOW_MS_BETWEEN_PID, normal_ms));
+      // a conversion finishing just before the next tick; a slow period means fewer of them
+      scheduleTemperature(previousMillis + pid_period_ms);
     }
     else if (!flag_PID_running)
     {
       digitalWrite(HEAT_RELAY_PIN, LOW);
+
+      // so the first tick once it starts has a real dt, and no derivative across the gap
+      setPreviousMillis();
+      resetPIDHistory(&pid);
+      pid_period_ms = getSetting(SETTING_PID_PERIOD_MS);
     }
   }
   else if (((time_s / 5) % 2 == 0) && flag_PID_running)
@@ -977,5 +1438,22 @@ void loop()
     digitalWrite(HEAT_RELAY_PIN, LOW);
   }
 
-  getTemperature(&current_temp);
+  // never waits for a conversion; current_temp changes once one finishes
+  serviceTemperature(&current_temp);
+
+  // send the next chunk of the frame to the screen; a whole frame is spread over several passes
+  stepDisplayFlush();
+
+  // journal commits are rate limited; at most one per JOURNAL_COMMIT_INTERVAL_MS
+  serviceJournal();
+
+  // write at most one pending EEPROM byte, so saving never blocks the loop
+  serviceEepromCache();
+
+  // run log blocks go to the SD card a chunk at a time
+  serviceRunLog();
+
+  // "trace" etc. from the serial port
+  serviceSerialCommands();
 }
+#endif
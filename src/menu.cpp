@@ -10,6 +10,21 @@
  */
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
 
+// incremental flush state
+#define DISPLAY_WIRE_MAX BUFFER_LENGTH // Wire's transmit buffer, including the control byte
+
+#define DISPLAY_NUM_PAGES (SCREEN_HEIGHT / 8)
+#define DISPLAY_ALL_PAGES ((uint8_t)((1 << DISPLAY_NUM_PAGES) - 1))
+
+uint8_t display_flush_pending_pages = 0; // requested, not started yet
+uint8_t display_flush_pages = 0;         // left to send in the frame in flight
+uint8_t display_flush_page = 0;
+uint8_t display_flush_column = SCREEN_WIDTH; // SCREEN_WIDTH means the next page still needs addressing
+
+// last screen drawn by drawMenuScreen. cleared by any full flush request so a screen drawn by hand is never mistaken for it
+MenuScreen *last_drawn_screen = NULL;
+int last_drawn_selection = -1;
+
 /**
  * @brief initialize and allocate the SSD1306 screen buffer.
  *
@@ -22,7 +37,7 @@ bool initializeScreen(void)
 {
     int tries = 0;
     // SSD1306_SWITCHCAPVCC = generate display voltage from 3.3V internally
-    while (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C) && tries < MAX_TRIES)
+    while (!display.begin(SSD1306_SWITCHCAPVCC, DISPLAY_I2C_ADDRESS) && tries < MAX_TRIES)
     {
         delay(500); // Wait for 500 ms before retrying
         tries++;
@@ -37,17 +52,36 @@ bool initializeScreen(void)
     return true;
 }
 
+void getMenuItem(MenuScreen *ptr_menu_screen, int index, MenuItem *ptr_menu_item)
+{
+    if (ptr_menu_screen->menuItemAt != NULL)
+    {
+        ptr_menu_screen->menuItemAt(index, ptr_menu_item);
+        return;
+    }
+
+    memcpy_P(ptr_menu_item, &(ptr_menu_screen->menuItems[index]), sizeof(MenuItem));
+}
+
+int getMenuItemMode(MenuScreen *ptr_menu_screen, int index)
+{
+    MenuItem item;
+    getMenuItem(ptr_menu_screen, index, &item);
+    return item.mode;
+}
+
 /**
  * @brief Draw an individual MenuItem object at a specified location.
  * Has logic for drawing the object with a border if it is highlighted.
  *
- * @param ptr_menu_item Pointer to the menu item object.
+ * @param ptr_menu_item Pointer to the menu item object (RAM copy).
+ * @param highlighted whether to draw it highlighted
  * @param pos_x X pixel position that the object will be drawn at
  * @param pos_y Y pixel position that the object will be drawn at
  */
-void drawMenuItem(MenuItem *ptr_menu_item, uint8_t pos_x, uint8_t pos_y)
+void drawMenuItem(MenuItem *ptr_menu_item, bool highlighted, uint8_t pos_x, uint8_t pos_y)
 {
-    if (ptr_menu_item->highlighted)
+    if (highlighted)
     {
         display.fillRect(pos_x, pos_y, 63, 8, SSD1306_WHITE);
         display.setTextColor(SSD1306_BLACK);
@@ -75,11 +109,12 @@ void drawScreenItem(ScreenItem *ptr_screen_item, uint8_t pos_x, uint8_t pos_y)
 }
 
 /**
- * @brief Draw a whole MenuScreen object, including its child ScreenItems and MenuItems
+ * @brief Render a whole MenuScreen object into the display buffer, including its child ScreenItems and MenuItems.
+ * Does not push the buffer to the screen, so callers can draw extra things on top.
  *
  * @param ptr_menu_screen pointer to the MenuScreen object
  */
-void drawMenuScreen(MenuScreen *ptr_menu_screen)
+void renderMenuScreen(MenuScreen *ptr_menu_screen)
 {
     display.clearDisplay();
     display.setTextSize(1);              // Normal 1:1 pixel scale
@@ -91,11 +126,13 @@ void drawMenuScreen(MenuScreen *ptr_menu_screen)
     startIndex = min(startIndex, max(0, ptr_menu_screen->numMenuItems - WINDOW_SIZE));
 
     // Draw menu items on left side. Shifts based on which item is highlighted.
+    MenuItem item;
     for (int i = 0; i < WINDOW_SIZE; i++)
     {
         if (startIndex + i < ptr_menu_screen->numMenuItems)
         {
-            drawMenuItem(&(ptr_menu_screen->menuItems[startIndex + i]), 0, i * 8);
+            getMenuItem(ptr_menu_screen, startIndex + i, &item);
+            drawMenuItem(&item, startIndex + i == ptr_menu_screen->selectedMenuItemIndex, 0, i * 8);
         }
     }
 
@@ -105,38 +142,108 @@ void drawMenuScreen(MenuScreen *ptr_menu_screen)
 
         drawScreenItem(&(ptr_menu_screen->screenItems[i]), 64, i * 8); // Assuming half the screen width for menu items
     }
-
-    display.display();
 }
 
 /**
- * @brief Changes or sets the data inside a MenuItem object.
+ * @brief Draw a whole MenuScreen object, including its child ScreenItems and MenuItems.
+ * Only sends what changed: nothing if the screen and selection are the same as last time
+ * and no screen item is dirty, just the dirty rows if only screen items changed.
  *
- * @param ptr_menu_item pointer to the menu item
- * @param text character array representing the label of the menu item
- * @param text_length length of the character array. Should not be longer than STR_LEN - 1 (leaving room for the end of string character)
- * @param mode When selected, the MenuItem should activate this mode (int)
- * @param highlighted boolean. True if highlighted. False if not.
+ * @param ptr_menu_screen pointer to the MenuScreen object
  */
-void initializeMenuItem(MenuItem *ptr_menu_item, char *text, int text_length, int mode, bool highlighted)
+void drawMenuScreen(MenuScreen *ptr_menu_screen)
 {
-    int length;
-    char err_str[70];
-    if (text_length < 0 || text_length > STR_LEN - 1)
+    if (ptr_menu_screen != last_drawn_screen || ptr_menu_screen->selectedMenuItemIndex != last_drawn_selection)
     {
-        sprintf(err_str, "Initialize Menu Item Error: text length %d is out of bounds.", text_length);
-        Serial.println(err_str);
-        length = STR_LEN - 1;
+        renderMenuScreen(ptr_menu_screen);
+        requestDisplayFlush();
     }
-    else
+    else if (ptr_menu_screen->dirtyRows)
     {
-        length = text_length;
+        renderMenuScreen(ptr_menu_screen);
+        requestDisplayPagesFlush(ptr_menu_screen->dirtyRows);
     }
 
-    strncpy(ptr_menu_item->text, text, length);
-    ptr_menu_item->text[length] = '\0'; // Ensure null termination
-    ptr_menu_item->mode = mode;
-    ptr_menu_item->highlighted = highlighted;
+    ptr_menu_screen->dirtyRows = 0;
+    last_drawn_screen = ptr_menu_screen;
+    last_drawn_selection = ptr_menu_screen->selectedMenuItemIndex;
+}
+
+void requestDisplayFlush(void)
+{
+    last_drawn_screen = NULL;
+    display_flush_pending_pages = DISPLAY_ALL_PAGES;
+}
+
+void requestDisplayPagesFlush(uint8_t page_mask)
+{
+    display_flush_pending_pages |= page_mask & DISPLAY_ALL_PAGES;
+}
+
+bool stepDisplayFlush(void)
+{
+    if (display_flush_pages == 0)
+    {
+        if (display_flush_pending_pages == 0)
+        {
+            return true;
+        }
+
+        display_flush_pages = display_flush_pending_pages;
+        display_flush_pending_pages = 0;
+        display_flush_column = SCREEN_WIDTH;
+    }
+
+    if (display_flush_column >= SCREEN_WIDTH)
+    {
+        // next page in the mask
+        display_flush_page = 0;
+        while (!(display_flush_pages & (1 << display_flush_page)))
+        {
+            display_flush_page++;
+        }
+
+        // window of one page. the controller keeps its address pointer between transactions,
+        // so later steps just continue streaming data where the last one stopped
+        display.ssd1306_command(SSD1306_PAGEADDR);
+        display.ssd1306_command(display_flush_page);
+        display.ssd1306_command(display_flush_page);
+        display.ssd1306_command(SSD1306_COLUMNADDR);
+        display.ssd1306_command(0);
+        display.ssd1306_command(SCREEN_WIDTH - 1);
+        display_flush_column = 0;
+    }
+
+    uint8_t *page = display.getBuffer() + (uint16_t)display_flush_page * SCREEN_WIDTH;
+    uint8_t end = min(display_flush_column + DISPLAY_FLUSH_BYTES_PER_STEP, SCREEN_WIDTH);
+
+    Wire.setClock(DISPLAY_I2C_CLOCK);
+    while (display_flush_column < end)
+    {
+        Wire.beginTransmission(DISPLAY_I2C_ADDRESS);
+        Wire.write((uint8_t)0x40); // control byte: data stream
+        uint8_t bytes_out = 1;
+        while (display_flush_column < end && bytes_out < DISPLAY_WIRE_MAX)
+        {
+            Wire.write(page[display_flush_column]);
+            display_flush_column++;
+            bytes_out++;
+        }
+        Wire.endTransmission();
+    }
+    Wire.setClock(DISPLAY_I2C_RESTORE_CLOCK);
+
+    if (display_flush_column >= SCREEN_WIDTH)
+    {
+        display_flush_pages &= ~(1 << display_flush_page);
+    }
+
+    return display_flush_pages == 0 && display_flush_pending_pages == 0;
+}
+
+bool isDisplayFlushDone(void)
+{
+    return display_flush_pages == 0 && display_flush_pending_pages == 0;
 }
 
 /**
@@ -146,7 +253,7 @@ void initializeMenuItem(MenuItem *ptr_menu_item, char *text, int text_length, in
  * @param text character array representing the label of the menu item
  * @param text_length length of the character array. Should not be longer than STR_LEN - 1 (leaving room for the end of string character)
  */
-void initializeScreenItem(ScreenItem *ptr_screen_item, char *text, int text_length)
+void initializeScreenItem(ScreenItem *ptr_screen_item, const char *text, int text_length)
 {
 
     int length;
@@ -166,46 +273,87 @@ void initializeScreenItem(ScreenItem *ptr_screen_item, char *text, int text_leng
     ptr_screen_item->text[length] = '\0'; // Ensure null termination
 }
 
-/**
- * @brief Changes or sets the data inside a MenuScreen object. Including its nested Menu and Screen Items.
- *
- * @param ptr_menu_screen pointer to the menu screen item
- * @param numMenuItems number of menu items
- * @param menuItems pointer to the list of MenuItems
- * @param selectedMenuItemIndex int representing the index for which menuItem is selected
- * @param numScreenItems number of screen items (maximum is WINDOW_SIZE)
- * @param screenItems pointer to the list of ScreenItems
- */
-void initializeMenuScreen(MenuScreen *ptr_menu_screen, int numMenuItems, MenuItem *menuItems, int selectedMenuItemIndex, int numScreenItems, ScreenItem screenItems[])
+void setScreenItemText(MenuScreen *ptr_menu_screen, int index, const char *text)
 {
-    // max size of screen items is WINDOW_SIZE
-    int number_of_screen_items = numScreenItems;
+    ScreenItem *ptr_screen_item = &(ptr_menu_screen->screenItems[index]);
 
-    if (numScreenItems > WINDOW_SIZE)
+    if (strncmp(ptr_screen_item->text, text, STR_LEN - 1) == 0)
     {
-        number_of_screen_items = WINDOW_SIZE;
+        return;
     }
 
-    ptr_menu_screen->numMenuItems = numMenuItems;
-    ptr_menu_screen->menuItems = menuItems;
-    ptr_menu_screen->selectedMenuItemIndex = selectedMenuItemIndex;
-    ptr_menu_screen->numScreenItems = number_of_screen_items;
+    initializeScreenItem(ptr_screen_item, text, min((int)strlen(text), STR_LEN - 1));
+    ptr_menu_screen->dirtyRows |= (1 << index);
+}
 
-    if (number_of_screen_items > 0)
+uint8_t formatFixed(long scaled, uint8_t decimals, char suffix, char *buffer)
+{
+    char digits[12];
+    uint8_t num_digits = 0;
+    uint8_t length = 0;
+    unsigned long magnitude = scaled < 0 ? -scaled : scaled;
+
+    // least significant digit first. always at least one digit in front of the point
+    do
     {
+        digits[num_digits++] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 || num_digits <= decimals);
 
-        for (int i = 0; i < number_of_screen_items && i < WINDOW_SIZE; i++)
+    if (scaled < 0)
+    {
+        buffer[length++] = '-';
+    }
+    while (num_digits > 0)
+    {
+        if (num_digits == decimals)
         {
-            ptr_menu_screen->screenItems[i] = screenItems[i];
+            buffer[length++] = '.';
         }
+        buffer[length++] = digits[--num_digits];
     }
+    if (suffix)
+    {
+        buffer[length++] = suffix;
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
 
-    if (numMenuItems > 0)
+long toFixed(double value, uint8_t decimals)
+{
+    long scale = 1;
+    for (uint8_t i = 0; i < decimals; i++)
     {
+        scale *= 10;
+    }
 
-        for (int i = 0; i < numMenuItems && i < WINDOW_SIZE; i++)
-        {
-            ptr_menu_screen->menuItems[i] = menuItems[i];
-        }
+    return value < 0 ? (long)(value * scale - 0.5) : (long)(value * scale + 0.5);
+}
+
+bool updateBoundScreenItem(BoundScreenItem *ptr_bound_item)
+{
+    long scaled;
+    if (ptr_bound_item->type == BOUND_DOUBLE)
+    {
+        scaled = toFixed(*(const double *)ptr_bound_item->ptr_value, ptr_bound_item->decimals);
+    }
+    else
+    {
+        scaled = *(const int *)ptr_bound_item->ptr_value;
     }
+
+    if (ptr_bound_item->formatted && scaled == ptr_bound_item->last_scaled)
+    {
+        return false;
+    }
+
+    char buffer[STR_LEN + 4]; // room for a value that's too wide; setScreenItemText truncates it
+    formatFixed(scaled, ptr_bound_item->decimals, ptr_bound_item->suffix, buffer);
+    setScreenItemText(ptr_bound_item->ptr_menu_screen, ptr_bound_item->screen_item_index, buffer);
+
+    ptr_bound_item->last_scaled = scaled;
+    ptr_bound_item->formatted = true;
+    return true;
 }
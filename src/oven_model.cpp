@@ -0,0 +1,205 @@
+#include "oven_model.h"
+#include "storage.h"
+#include "settings.h"
+
+static_assert(OVEN_MODEL_RECORD_ADDRESS >= SETTINGS_RECORD_ADDRESS + sizeof(uint16_t) + 1 + 2 * SETTINGS_MAX_STORED, "oven model record overlaps the settings record");
+static_assert(OVEN_MODEL_RECORD_ADDRESS + sizeof(uint16_t) + sizeof(OvenModel) <= EEPROM_SIZE, "oven model record doesn't fit in the EEPROM");
+static_assert(sizeof(OvenModel) <= RECORD_MAX_PAYLOAD, "oven model record too big");
+
+// long enough to mean "until the oven gets there"
+#define OVEN_FOREVER_S 1e9f
+
+OvenModel oven_model;
+
+static const uint8_t default_heat_rates[OVEN_MODEL_POINTS] = DEFAULT_OVEN_HEAT_RATES;
+
+void loadOvenModel(void)
+{
+    bool valid = readRecordAt(OVEN_MODEL_RECORD_ADDRESS, RECORD_OVEN_MODEL, &oven_model, sizeof(oven_model)) && oven_model.cool > 0;
+    for (uint8_t i = 0; i < OVEN_MODEL_POINTS && valid; i++)
+    {
+        valid = oven_model.heat[i] > 0;
+    }
+
+    if (!valid)
+    {
+        memcpy(oven_model.heat, default_heat_rates, sizeof(oven_model.heat));
+        oven_model.cool = DEFAULT_OVEN_COOL_RATE;
+    }
+}
+
+void saveOvenModel(void)
+{
+    writeRecordAt(OVEN_MODEL_RECORD_ADDRESS, RECORD_OVEN_MODEL, &oven_model, sizeof(oven_model));
+}
+
+float getOvenHeatRate(float temp_c)
+{
+    // point i is at (i + 1) * OVEN_MODEL_STEP_C
+    float position = temp_c / OVEN_MODEL_STEP_C - 1;
+    if (position <= 0)
+    {
+        return oven_model.heat[0] / 10.0f;
+    }
+    if (position >= OVEN_MODEL_POINTS - 1)
+    {
+        return oven_model.heat[OVEN_MODEL_POINTS - 1] / 10.0f;
+    }
+
+    uint8_t i = (uint8_t)position;
+    float fraction = position - i;
+    return (oven_model.heat[i] + (oven_model.heat[i + 1] - oven_model.heat[i]) * fraction) / 10.0f;
+}
+
+uint16_t getOvenMinHeatRate(int up_to_c)
+{
+    uint16_t slowest = oven_model.heat[0];
+    for (uint8_t i = 1; i < OVEN_MODEL_POINTS && i * OVEN_MODEL_STEP_C < up_to_c; i++)
+    {
+        slowest = min(slowest, (uint16_t)oven_model.heat[i]);
+    }
+    return slowest;
+}
+
+/**
+ * @brief move the oven toward to_c for at most max_s, heating flat out or cooling with the heater off
+ *
+ * @return float seconds it took; max_s if it didn't get there
+ */
+static float travel(float *ptr_oven_c, float to_c, float max_s)
+{
+    float seconds = 0;
+
+    if (*ptr_oven_c > to_c)
+    {
+        float rate = oven_model.cool / 10.0f;
+        seconds = min((*ptr_oven_c - to_c) / rate, max_s);
+        *ptr_oven_c -= seconds * rate;
+        return seconds;
+    }
+
+    // the heat rate changes with temperature; add it up a chunk at a time
+    while (*ptr_oven_c < to_c)
+    {
+        float chunk = min((float)OVEN_MODEL_CHUNK_C, to_c - *ptr_oven_c);
+        float rate = getOvenHeatRate(*ptr_oven_c + chunk / 2);
+        if (seconds + chunk / rate > max_s)
+        {
+            *ptr_oven_c += (max_s - seconds) * rate;
+            return max_s;
+        }
+        seconds += chunk / rate;
+        *ptr_oven_c += chunk;
+    }
+    return seconds;
+}
+
+void predictSegments(const SegmentProfile *ptr_segments, float start_c, OvenPrediction *ptr_prediction)
+{
+    float oven_c = start_c;
+    float setpoint_c = start_c;
+    float now_s = 0;
+
+    ptr_prediction->first_flagged = ptr_segments->num_segments;
+
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &ptr_segments->segments[i];
+        float target_c = ptr_segment->target_c;
+        uint8_t flags = 0;
+
+        // time for the oven to get within the band, from the side it's on. until-temp and cooldown go all the way
+        float band_c = ptr_segment->band_c;
+        if (ptr_segment->type == SEGMENT_HOLD_UNTIL_TEMP || ptr_segment->type == SEGMENT_COOLDOWN)
+        {
+            band_c = 0;
+        }
+        float reach_s = 0;
+        if (oven_c < target_c - band_c || oven_c > target_c + band_c)
+        {
+            float probe_c = oven_c;
+            reach_s = travel(&probe_c, oven_c < target_c ? target_c - band_c : target_c + band_c, OVEN_FOREVER_S);
+        }
+
+        // nominal time, from the segment alone
+        float nominal_s = 0;
+        if (ptr_segment->type == SEGMENT_RAMP && ptr_segment->value > 0)
+        {
+            float rate = ptr_segment->value / 10.0f;
+            nominal_s = ceil(abs(target_c - setpoint_c) / rate);
+            // the oven can't be in the band before the setpoint gets near it
+            reach_s = max(reach_s, nominal_s - band_c / rate);
+        }
+        else if (ptr_segment->type == SEGMENT_HOLD)
+        {
+            nominal_s = ptr_segment->value;
+        }
+
+        float end_s;
+        switch (ptr_segment->type)
+        {
+        case SEGMENT_RAMP:
+        case SEGMENT_HOLD:
+            if (ptr_segment->gate == GATE_TIME)
+            {
+                end_s = nominal_s;
+                flags |= reach_s > nominal_s ? OVEN_LAGS : 0;
+            }
+            else
+            {
+                // a temperature gated hold only starts counting in the band
+                end_s = ptr_segment->gate == GATE_TEMP && ptr_segment->type == SEGMENT_HOLD ? reach_s + nominal_s : max(nominal_s, reach_s);
+                flags |= reach_s > nominal_s ? OVEN_STRETCHES : 0;
+                flags |= ptr_segment->timeout_s > 0 && reach_s > ptr_segment->timeout_s ? OVEN_TIMES_OUT : 0;
+            }
+            break;
+        case SEGMENT_HOLD_UNTIL_TEMP:
+            end_s = reach_s;
+            flags |= ptr_segment->timeout_s > 0 && reach_s > ptr_segment->timeout_s ? OVEN_TIMES_OUT : 0;
+            break;
+        case SEGMENT_COOLDOWN:
+            end_s = oven_c > target_c ? reach_s : 0;
+            break;
+        default:
+            end_s = 0;
+            break;
+        }
+
+        travel(&oven_c, target_c, end_s);
+        setpoint_c = target_c;
+        now_s += end_s;
+
+        ptr_prediction->end_s[i] = now_s;
+        ptr_prediction->reach_s[i] = min(reach_s, 65535.0f);
+        ptr_prediction->flags[i] = flags;
+        if ((flags & (OVEN_LAGS | OVEN_TIMES_OUT)) && ptr_prediction->first_flagged == ptr_segments->num_segments)
+        {
+            ptr_prediction->first_flagged = i;
+        }
+    }
+
+    ptr_prediction->total_s = now_s;
+}
+
+bool fitProfileToOven(ReflowProfile *ptr_profile)
+{
+    // profileToSegments() order: preheat, soak, up to reflow, reflow hold
+    int *stage_times[2] = {&ptr_profile->preheat_time_s, &ptr_profile->soak_time_s};
+    bool changed = false;
+
+    // one stage at a time; a longer preheat gives the soak a hotter start
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        SegmentProfile segments;
+        OvenPrediction prediction;
+        profileToSegments(ptr_profile, &segments);
+        predictSegments(&segments, PROFILE_GRAPH_AMBIENT_C, &prediction);
+
+        if (prediction.flags[i] & OVEN_LAGS)
+        {
+            *stage_times[i] = min((int)prediction.reach_s[i] + 1, MAX_TIME_S);
+            changed = true;
+        }
+    }
+    return changed;
+}
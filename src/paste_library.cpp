@@ -0,0 +1,121 @@
+#include "paste_library.h"
+#include "settings.h"
+
+/**
+ * @brief A segment as stored in flash; band/timeout/abort come from the settings when loaded
+ */
+struct LibrarySegment
+{
+    uint8_t type; // SegmentType
+    uint8_t gate; // SegmentGate
+    int16_t target_c;
+    uint16_t value; // see ProfileSegment
+};
+
+struct LibraryProfile
+{
+    char name[STR_LEN];
+    bool fan_on;
+    uint8_t num_segments;
+    LibrarySegment segments[MAX_PROFILE_SEGMENTS];
+};
+
+// ramp rates are in 0.1 C/s. each reflow waits at the end of its ramp to peak for the oven to catch up.
+// every target, cooldowns included, has to be within MIN_TEMP_C - MAX_TEMP_C to compile
+static const LibraryProfile library_profiles[NUM_LIBRARY_PROFILES] PROGMEM = {
+    // SAC305: liquidus 217C, soak 150-180C, peak 245C
+    {"SAC305", true, 5, {
+        {SEGMENT_RAMP, GATE_TIME, 150, 10},
+        {SEGMENT_RAMP, GATE_TIME, 180, 3},
+        {SEGMENT_RAMP, GATE_TIME_AND_TEMP, 245, 15},
+        {SEGMENT_HOLD, GATE_TIME, 245, 10},
+        {SEGMENT_COOLDOWN, GATE_TIME, 100, 0},
+    }},
+    // Sn63/Pb37: liquidus 183C, soak 150-170C, peak 220C
+    {"Sn63Pb37", true, 5, {
+        {SEGMENT_RAMP, GATE_TIME, 150, 10},
+        {SEGMENT_RAMP, GATE_TIME, 170, 2},
+        {SEGMENT_RAMP, GATE_TIME_AND_TEMP, 220, 15},
+        {SEGMENT_HOLD, GATE_TIME, 220, 10},
+        {SEGMENT_COOLDOWN, GATE_TIME, 100, 0},
+    }},
+    // Sn42/Bi58 low temperature: liquidus 138C, soak 100-130C, peak 175C
+    {"SnBi LT", true, 5, {
+        {SEGMENT_RAMP, GATE_TIME, 100, 10},
+        {SEGMENT_RAMP, GATE_TIME, 130, 3},
+        {SEGMENT_RAMP, GATE_TIME_AND_TEMP, 175, 15},
+        {SEGMENT_HOLD, GATE_TIME, 175, 10},
+        {SEGMENT_COOLDOWN, GATE_TIME, 80, 0},
+    }},
+    // moisture bake of boards and parts, 4h counted once the oven is at temperature
+    {"Bake 125C", true, 3, {
+        {SEGMENT_RAMP, GATE_TIME, 125, 10},
+        {SEGMENT_HOLD, GATE_TEMP, 125, 4 * 3600U},
+        {SEGMENT_COOLDOWN, GATE_TIME, 80, 0},
+    }},
+    // low temperature dry for parts in trays or reels that can't take 125C
+    {"Bake 90C", true, 3, {
+        {SEGMENT_RAMP, GATE_TIME, 90, 10},
+        {SEGMENT_HOLD, GATE_TEMP, 90, 8 * 3600U},
+        {SEGMENT_COOLDOWN, GATE_TIME, 80, 0},
+    }},
+};
+
+void getLibraryProfileName(uint8_t library_index, char *buffer)
+{
+    strcpy_P(buffer, library_profiles[library_index].name);
+}
+
+void describeLibrarySegment(uint8_t library_index, uint8_t segment, char *buffer)
+{
+    const LibraryProfile *ptr_library = &library_profiles[library_index];
+    if (segment >= pgm_read_byte(&ptr_library->num_segments))
+    {
+        strcpy_P(buffer, PSTR(" "));
+        return;
+    }
+
+    LibrarySegment library_segment;
+    memcpy_P(&library_segment, &ptr_library->segments[segment], sizeof(library_segment));
+
+    // indexed by SegmentType
+    static const char type_names[NUM_SEGMENT_TYPES][5] PROGMEM = {"Ramp", "Hold", "Wait", "Cool"};
+    strcpy_P(buffer, type_names[library_segment.type]);
+    buffer[4] = ' ';
+    formatFixed(library_segment.target_c, 0, 'C', buffer + 5);
+}
+
+bool loadLibraryProfile(uint8_t library_index, SegmentProfile *ptr_segments)
+{
+    if (library_index >= NUM_LIBRARY_PROFILES)
+    {
+        return false;
+    }
+
+    const LibraryProfile *ptr_library = &library_profiles[library_index];
+    bool fan_on = pgm_read_byte(&ptr_library->fan_on);
+
+    ptr_segments->num_segments = pgm_read_byte(&ptr_library->num_segments);
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        LibrarySegment segment;
+        memcpy_P(&segment, &ptr_library->segments[i], sizeof(segment));
+
+        ProfileSegment *ptr_segment = &ptr_segments->segments[i];
+        ptr_segment->type = segment.type;
+        ptr_segment->fan_on = fan_on;
+        ptr_segment->target_c = segment.target_c;
+        ptr_segment->value = segment.value;
+        ptr_segment->gate = segment.gate;
+        ptr_segment->band_c = getSetting(SETTING_GATE_BAND_C);
+        ptr_segment->timeout_s = getSetting(SETTING_GATE_TIMEOUT_S);
+        ptr_segment->abort_on_timeout = getSetting(SETTING_GATE_ABORT) != 0;
+    }
+    return true;
+}
+
+bool libraryToReflowProfile(uint8_t library_index, ReflowProfile *ptr_profile)
+{
+    SegmentProfile segments;
+    return loadLibraryProfile(library_index, &segments) && segmentsToProfile(&segments, ptr_profile);
+}
@@ -0,0 +1,96 @@
+#include "recovery.h"
+#include "journal.h"
+#include "run_log.h"
+
+#define CHECKPOINT_END_KNOWN (1UL << 8)
+#define CHECKPOINT_GATE_MET (1UL << 9)
+#define CHECKPOINT_RISING (1UL << 10)
+#define CHECKPOINT_LOG_PART_SHIFT 11
+#define CHECKPOINT_LOG_PART_MAX 31
+
+// when the last checkpoint was taken and which step it was in
+static uint32_t last_checkpoint_s = 0;
+static uint8_t last_checkpoint_step = 0xFF;
+
+/**
+ * @brief Set the checkpoint's journal values. They reach the EEPROM with the journal's next commit.
+ */
+static void stageRunCheckpoint(uint8_t profile_index, const PlanRun *ptr_run, uint32_t now_s, float temp_c)
+{
+    PlanPosition position;
+    getRunPlanPosition(ptr_run, now_s, &position);
+
+    uint8_t log_part = min(getRunLogPart(), (uint8_t)CHECKPOINT_LOG_PART_MAX);
+    uint32_t step = position.index | ((uint32_t)log_part << CHECKPOINT_LOG_PART_SHIFT) | ((uint32_t)position.end_offset_s << 16);
+    if (position.end_known)
+    {
+        step |= CHECKPOINT_END_KNOWN;
+    }
+    if (position.gate_met)
+    {
+        step |= CHECKPOINT_GATE_MET;
+    }
+    if (position.rising)
+    {
+        step |= CHECKPOINT_RISING;
+    }
+
+    setJournalValue(JOURNAL_CHECKPOINT_PROFILE, profile_index + 1);
+    setJournalValue(JOURNAL_CHECKPOINT_STEP, step);
+    setJournalValue(JOURNAL_CHECKPOINT_ELAPSED_S, position.elapsed_s);
+    setJournalValue(JOURNAL_CHECKPOINT_TEMP, (int32_t)(temp_c * 10));
+
+    last_checkpoint_s = now_s;
+    last_checkpoint_step = position.index;
+}
+
+void saveRunCheckpoint(uint8_t profile_index, const PlanRun *ptr_run, uint32_t now_s, float temp_c)
+{
+    stageRunCheckpoint(profile_index, ptr_run, now_s, temp_c);
+    commitJournal();
+}
+
+void serviceRunCheckpoint(uint8_t profile_index, const PlanRun *ptr_run, uint32_t now_s, float temp_c)
+{
+    if (ptr_run->index != last_checkpoint_step)
+    {
+        saveRunCheckpoint(profile_index, ptr_run, now_s, temp_c);
+    }
+    else if ((int32_t)(now_s - last_checkpoint_s) >= RUN_CHECKPOINT_INTERVAL_S)
+    {
+        // progress within a step is left to serviceJournal()'s rate limit
+        stageRunCheckpoint(profile_index, ptr_run, now_s, temp_c);
+    }
+}
+
+void clearRunCheckpoint(void)
+{
+    setJournalValue(JOURNAL_CHECKPOINT_PROFILE, 0);
+    last_checkpoint_step = 0xFF;
+}
+
+bool findRunCheckpoint(RunCheckpoint *ptr_checkpoint)
+{
+    uint32_t profile = getJournalValue(JOURNAL_CHECKPOINT_PROFILE);
+    if (profile == 0)
+    {
+        return false;
+    }
+
+    uint32_t step = getJournalValue(JOURNAL_CHECKPOINT_STEP);
+    ptr_checkpoint->profile_index = profile - 1;
+    ptr_checkpoint->position.index = step & 0xFF;
+    ptr_checkpoint->position.end_known = (step & CHECKPOINT_END_KNOWN) != 0;
+    ptr_checkpoint->position.gate_met = (step & CHECKPOINT_GATE_MET) != 0;
+    ptr_checkpoint->position.rising = (step & CHECKPOINT_RISING) != 0;
+    ptr_checkpoint->position.end_offset_s = step >> 16;
+    ptr_checkpoint->log_part = (step >> CHECKPOINT_LOG_PART_SHIFT) & CHECKPOINT_LOG_PART_MAX;
+    ptr_checkpoint->position.elapsed_s = getJournalValue(JOURNAL_CHECKPOINT_ELAPSED_S);
+    ptr_checkpoint->temp_c = (int32_t)getJournalValue(JOURNAL_CHECKPOINT_TEMP) / 10.0f;
+    return true;
+}
+
+bool isCheckpointResumable(const RunCheckpoint *ptr_checkpoint, float temp_c)
+{
+    return abs(temp_c - ptr_checkpoint->temp_c) <= RESUME_TOLERANCE_C;
+}
@@ -1,5 +1,6 @@
 #include "reflow.h"
-#include <EEPROM.h>
+#include "settings.h"
+#include "run_plan.h"
 
 ReflowProfile default_reflow_profile;
 
@@ -15,6 +16,89 @@ void initialize_default_profile(void)
     default_reflow_profile.soak_time_s = DEFAULT_SOAK_TIME_S;
     default_reflow_profile.reflow_hold_time_s = DEFAULT_REFLOW_HOLD_TIME_S;
     default_reflow_profile.reflow_temp = DEFAULT_REFLOW_TEMP;
+    default_reflow_profile.preheat_gate = DEFAULT_PREHEAT_GATE;
+    default_reflow_profile.soak_gate = DEFAULT_SOAK_GATE;
+    default_reflow_profile.reflow_gate = DEFAULT_REFLOW_GATE;
+}
+
+/**
+ * @brief append a segment to a segment profile
+ */
+static void addSegment(SegmentProfile *ptr_segments, uint8_t type, int target_c, uint16_t value, bool fan_on, uint8_t gate)
+{
+    ProfileSegment *ptr_segment = &ptr_segments->segments[ptr_segments->num_segments++];
+    ptr_segment->type = type;
+    ptr_segment->fan_on = fan_on;
+    ptr_segment->target_c = target_c;
+    ptr_segment->value = value;
+    ptr_segment->gate = gate;
+    ptr_segment->band_c = getSetting(SETTING_GATE_BAND_C);
+    ptr_segment->timeout_s = getSetting(SETTING_GATE_TIMEOUT_S);
+    ptr_segment->abort_on_timeout = getSetting(SETTING_GATE_ABORT) != 0;
+}
+
+void profileToSegments(ReflowProfile *ptr_profile, SegmentProfile *ptr_segments)
+{
+    ptr_segments->num_segments = 0;
+
+    addSegment(ptr_segments, SEGMENT_HOLD, ptr_profile->preheat_temp_c, ptr_profile->preheat_time_s, ptr_profile->fan_on, ptr_profile->preheat_gate);
+    addSegment(ptr_segments, SEGMENT_HOLD, ptr_profile->soak_temp_c, ptr_profile->soak_time_s, ptr_profile->fan_on, ptr_profile->soak_gate);
+    // the hold time only starts counting once the oven actually gets to reflow temp
+    addSegment(ptr_segments, SEGMENT_HOLD_UNTIL_TEMP, ptr_profile->reflow_temp, 0, ptr_profile->fan_on, GATE_TIME);
+    addSegment(ptr_segments, SEGMENT_HOLD, ptr_profile->reflow_temp, ptr_profile->reflow_hold_time_s, ptr_profile->fan_on, ptr_profile->reflow_gate);
+}
+
+/**
+ * @brief whether a segment only heats toward its target, i.e. can stand in for a preheat or soak stage
+ */
+static bool isHeatingSegment(const ProfileSegment *ptr_segment)
+{
+    return ptr_segment->type == SEGMENT_RAMP || ptr_segment->type == SEGMENT_HOLD;
+}
+
+bool segmentsToProfile(const SegmentProfile *ptr_segments, ReflowProfile *ptr_profile)
+{
+    if (ptr_segments->num_segments < 4 || ptr_segments->num_segments > MAX_PROFILE_SEGMENTS)
+    {
+        return false;
+    }
+
+    const ProfileSegment *ptr_peak = &ptr_segments->segments[2];
+    const ProfileSegment *ptr_hold = &ptr_segments->segments[3];
+    if (!isHeatingSegment(&ptr_segments->segments[0]) || !isHeatingSegment(&ptr_segments->segments[1]) ||
+        (ptr_peak->type != SEGMENT_RAMP && ptr_peak->type != SEGMENT_HOLD_UNTIL_TEMP) ||
+        ptr_hold->type != SEGMENT_HOLD || ptr_hold->target_c != ptr_peak->target_c)
+    {
+        return false;
+    }
+    for (uint8_t i = 4; i < ptr_segments->num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &ptr_segments->segments[i];
+        if ((ptr_segment->type != SEGMENT_COOLDOWN && ptr_segment->type != SEGMENT_RAMP) || ptr_segment->target_c >= ptr_peak->target_c)
+        {
+            return false;
+        }
+    }
+
+    // the stage times are how long the segments take
+    RunPlan plan;
+    if (compileRunPlan(ptr_segments, PROFILE_GRAPH_AMBIENT_C, MIN_TEMP_C, MAX_TEMP_C, &plan) != PLAN_OK)
+    {
+        return false;
+    }
+
+    ptr_profile->fan_on = ptr_segments->segments[0].fan_on;
+    ptr_profile->preheat_temp_c = ptr_segments->segments[0].target_c;
+    ptr_profile->preheat_time_s = min(plan.steps[0].duration_s, (uint32_t)MAX_TIME_S);
+    ptr_profile->preheat_gate = ptr_segments->segments[0].gate;
+    ptr_profile->soak_temp_c = ptr_segments->segments[1].target_c;
+    ptr_profile->soak_time_s = min(plan.steps[1].duration_s, (uint32_t)MAX_TIME_S);
+    ptr_profile->soak_gate = ptr_segments->segments[1].gate;
+    ptr_profile->reflow_temp = ptr_peak->target_c;
+    ptr_profile->reflow_hold_time_s = min(plan.steps[3].duration_s, (uint32_t)MAX_TIME_S);
+    ptr_profile->reflow_gate = ptr_hold->gate;
+
+    return isProfileValid(ptr_profile);
 }
 
 bool isProfileValid(ReflowProfile *ptr_profile_to_check)
@@ -70,6 +154,11 @@ bool isProfileValid(ReflowProfile *ptr_profile_to_check)
         return false;
     }
 
+    if (ptr_profile_to_check->preheat_gate >= NUM_GATES || ptr_profile_to_check->soak_gate >= NUM_GATES || ptr_profile_to_check->reflow_gate >= NUM_GATES)
+    {
+        return false;
+    }
+
     if ((ptr_profile_to_check->soak_time_s + ptr_profile_to_check->preheat_time_s + ptr_profile_to_check->reflow_hold_time_s) < MIN_TOTAL_RUNTIME_S)
     {
         return false;
@@ -78,34 +167,73 @@ bool isProfileValid(ReflowProfile *ptr_profile_to_check)
     return true;
 }
 
-bool getProfilesFromEEPROM(ReflowProfile profiles_array[], int num_of_profiles, int address)
+/**
+ * @brief append width bits of value to a packed buffer, least significant bit first
+ */
+static void putBits(uint8_t *buffer, uint8_t *ptr_bit, uint16_t value, uint8_t width)
 {
-    int size = num_of_profiles * sizeof(ReflowProfile);
-    int eepromSize = EEPROM.length();
-
-    // Check if the read operation goes beyond the EEPROM size
-    if ((address + size) > eepromSize)
+    for (uint8_t i = 0; i < width; i++, (*ptr_bit)++)
     {
-        return false; // Read operation exceeds EEPROM size
+        if (value & (1 << i))
+        {
+            buffer[*ptr_bit >> 3] |= 1 << (*ptr_bit & 7);
+        }
     }
-
-    EEPROM.get(address, profiles_array);
-
-    return true;
 }
 
-bool saveProfilesToEEPROM(ReflowProfile profiles_array[], int num_of_profiles, int address)
+/**
+ * @brief read width bits from a packed buffer, least significant bit first
+ */
+static uint16_t getBits(const uint8_t *buffer, uint8_t *ptr_bit, uint8_t width)
 {
-    int size = num_of_profiles * sizeof(ReflowProfile);
-    int eepromSize = EEPROM.length();
-
-    // Check if the write operation goes beyond the EEPROM size
-    if ((address + size) > eepromSize)
+    uint16_t value = 0;
+    for (uint8_t i = 0; i < width; i++, (*ptr_bit)++)
     {
-        return false; // Write operation exceeds EEPROM size
+        if (buffer[*ptr_bit >> 3] & (1 << (*ptr_bit & 7)))
+        {
+            value |= 1 << i;
+        }
     }
+    return value;
+}
 
-    EEPROM.put(address, profiles_array);
+/**
+ * @brief clamp a field to what fits in width bits
+ */
+static uint16_t fitBits(int value, uint8_t width)
+{
+    return constrain(value, 0, (1 << width) - 1);
+}
 
-    return true;
+void packProfile(ReflowProfile *ptr_profile, uint8_t packed[PACKED_PROFILE_SIZE])
+{
+    uint8_t bit = 0;
+    memset(packed, 0, PACKED_PROFILE_SIZE);
+
+    putBits(packed, &bit, ptr_profile->fan_on ? 1 : 0, 1);
+    putBits(packed, &bit, fitBits(ptr_profile->preheat_temp_c, PACKED_TEMP_BITS), PACKED_TEMP_BITS);
+    putBits(packed, &bit, fitBits(ptr_profile->preheat_time_s, PACKED_TIME_BITS), PACKED_TIME_BITS);
+    putBits(packed, &bit, fitBits(ptr_profile->soak_temp_c, PACKED_TEMP_BITS), PACKED_TEMP_BITS);
+    putBits(packed, &bit, fitBits(ptr_profile->soak_time_s, PACKED_TIME_BITS), PACKED_TIME_BITS);
+    putBits(packed, &bit, fitBits(ptr_profile->reflow_temp, PACKED_TEMP_BITS), PACKED_TEMP_BITS);
+    putBits(packed, &bit, fitBits(ptr_profile->reflow_hold_time_s, PACKED_TIME_BITS), PACKED_TIME_BITS);
+    putBits(packed, &bit, min(ptr_profile->preheat_gate, GATE_TIME_AND_TEMP), PACKED_GATE_BITS);
+    putBits(packed, &bit, min(ptr_profile->soak_gate, GATE_TIME_AND_TEMP), PACKED_GATE_BITS);
+    putBits(packed, &bit, min(ptr_profile->reflow_gate, GATE_TIME_AND_TEMP), PACKED_GATE_BITS);
+}
+
+void unpackProfile(const uint8_t packed[PACKED_PROFILE_SIZE], ReflowProfile *ptr_profile)
+{
+    uint8_t bit = 0;
+
+    ptr_profile->fan_on = getBits(packed, &bit, 1);
+    ptr_profile->preheat_temp_c = getBits(packed, &bit, PACKED_TEMP_BITS);
+    ptr_profile->preheat_time_s = getBits(packed, &bit, PACKED_TIME_BITS);
+    ptr_profile->soak_temp_c = getBits(packed, &bit, PACKED_TEMP_BITS);
+    ptr_profile->soak_time_s = getBits(packed, &bit, PACKED_TIME_BITS);
+    ptr_profile->reflow_temp = getBits(packed, &bit, PACKED_TEMP_BITS);
+    ptr_profile->reflow_hold_time_s = getBits(packed, &bit, PACKED_TIME_BITS);
+    ptr_profile->preheat_gate = getBits(packed, &bit, PACKED_GATE_BITS);
+    ptr_profile->soak_gate = getBits(packed, &bit, PACKED_GATE_BITS);
+    ptr_profile->reflow_gate = getBits(packed, &bit, PACKED_GATE_BITS);
 }
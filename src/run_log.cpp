@@ -0,0 +1,249 @@
+#include "run_log.h"
+#include <string.h>
+#include <stdio.h>
+
+static const RunLogBackend *ptr_log_backend = NULL;
+
+// one block fills while the other drains to the backend
+static uint8_t log_blocks[2][RUN_LOG_BLOCK_SIZE];
+static uint8_t filling_block = 0;
+static uint8_t filling_records = 0;
+static bool block_pending = false; // the other block is full and not written yet
+static uint16_t pending_offset = 0;
+
+static bool log_active = false;
+static uint16_t log_run_number;
+static uint16_t block_sequence;
+static uint16_t file_blocks;
+static uint8_t file_part;
+static RunLogStats log_stats;
+
+static void putU16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+}
+
+static void putU32(uint8_t *buffer, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        buffer[i] = value >> (8 * i);
+    }
+}
+
+static void putFloat(uint8_t *buffer, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(buffer, bits);
+}
+
+static void startBlock(uint8_t block)
+{
+    memset(log_blocks[block], 0, RUN_LOG_BLOCK_SIZE);
+    putU16(log_blocks[block], RUN_LOG_MAGIC);
+    putU16(log_blocks[block] + 2, log_run_number);
+    putU16(log_blocks[block] + 4, block_sequence++);
+    log_blocks[block][7] = RUN_LOG_RECORD_SIZE;
+    filling_records = 0;
+}
+
+/**
+ * @brief hand the filling block over to be written and start filling the other one
+ */
+static void swapBlocks(void)
+{
+    log_blocks[filling_block][6] = filling_records;
+    block_pending = true;
+    pending_offset = 0;
+
+    filling_block ^= 1;
+    startBlock(filling_block);
+}
+
+static void failRunLog(void)
+{
+    log_stats.failed = true;
+    log_active = false;
+    block_pending = false;
+    ptr_log_backend->close();
+}
+
+static bool openLogFile(void)
+{
+    char name[RUN_LOG_NAME_LEN];
+    runLogFileName(log_run_number, file_part, name);
+
+    file_blocks = 0;
+    log_stats.files++;
+    return ptr_log_backend->open(name);
+}
+
+void setRunLogBackend(const RunLogBackend *ptr_backend)
+{
+    endRunLog();
+    ptr_log_backend = ptr_backend;
+}
+
+bool beginRunLog(uint16_t run_number, uint8_t first_part)
+{
+    endRunLog();
+
+    memset(&log_stats, 0, sizeof(log_stats));
+    if (ptr_log_backend == NULL)
+    {
+        return false;
+    }
+
+    log_run_number = run_number;
+    block_sequence = 0;
+    file_part = first_part;
+    block_pending = false;
+    filling_block = 0;
+    startBlock(filling_block);
+
+    if (!openLogFile())
+    {
+        log_stats.failed = true;
+        return false;
+    }
+
+    log_active = true;
+    return true;
+}
+
+void logRunSample(const RunLogSample *ptr_sample)
+{
+    if (!log_active)
+    {
+        return;
+    }
+
+    if (filling_records == RUN_LOG_RECORDS_PER_BLOCK)
+    {
+        // the backend is behind; both blocks are full
+        log_stats.dropped_records++;
+        return;
+    }
+
+    uint8_t *record = log_blocks[filling_block] + RUN_LOG_HEADER_SIZE + filling_records * RUN_LOG_RECORD_SIZE;
+    putU32(record, ptr_sample->ms);
+    putFloat(record + 4, ptr_sample->temp_c);
+    putFloat(record + 8, ptr_sample->target_c);
+    putFloat(record + 12, ptr_sample->p_term);
+    putFloat(record + 16, ptr_sample->i_term);
+    putFloat(record + 20, ptr_sample->d_term);
+    putFloat(record + 24, ptr_sample->output);
+    record[28] = ptr_sample->heater_on ? 1 : 0;
+    record[29] = ptr_sample->fan_on ? 1 : 0;
+
+    filling_records++;
+    log_stats.records++;
+
+    if (filling_records == RUN_LOG_RECORDS_PER_BLOCK && !block_pending)
+    {
+        swapBlocks();
+    }
+}
+
+void serviceRunLog(void)
+{
+    if (!log_active || !block_pending)
+    {
+        return;
+    }
+
+    if (pending_offset == 0 && file_blocks == RUN_LOG_MAX_FILE_BLOCKS)
+    {
+        // rotate at a block boundary
+        file_part++;
+        if (!ptr_log_backend->close() || !openLogFile())
+        {
+            failRunLog();
+            return;
+        }
+    }
+
+    uint16_t length = RUN_LOG_BLOCK_SIZE - pending_offset;
+    if (length > RUN_LOG_WRITE_CHUNK)
+    {
+        length = RUN_LOG_WRITE_CHUNK;
+    }
+
+    if (!ptr_log_backend->write(log_blocks[filling_block ^ 1] + pending_offset, length))
+    {
+        failRunLog();
+        return;
+    }
+
+    pending_offset += length;
+    if (pending_offset == RUN_LOG_BLOCK_SIZE)
+    {
+        block_pending = false;
+        file_blocks++;
+        log_stats.blocks++;
+
+        if (file_blocks % RUN_LOG_FLUSH_BLOCKS == 0 && !ptr_log_backend->flush())
+        {
+            failRunLog();
+            return;
+        }
+
+        // filling block may have filled up while this one was written
+        if (filling_records == RUN_LOG_RECORDS_PER_BLOCK)
+        {
+            swapBlocks();
+        }
+    }
+}
+
+void endRunLog(void)
+{
+    if (!log_active)
+    {
+        return;
+    }
+
+    while (log_active && block_pending)
+    {
+        serviceRunLog();
+    }
+    if (log_active && filling_records > 0)
+    {
+        swapBlocks();
+        while (log_active && block_pending)
+        {
+            serviceRunLog();
+        }
+    }
+
+    if (log_active)
+    {
+        log_active = false;
+        if (!ptr_log_backend->close())
+        {
+            log_stats.failed = true;
+        }
+    }
+}
+
+bool isRunLogActive(void)
+{
+    return log_active;
+}
+
+uint8_t getRunLogPart(void)
+{
+    return file_part;
+}
+
+const RunLogStats *getRunLogStats(void)
+{
+    return &log_stats;
+}
+
+void runLogFileName(uint16_t run_number, uint8_t part, char *name)
+{
+    snprintf(name, RUN_LOG_NAME_LEN, "RUN%05u.L%02u", (unsigned int)run_number, (unsigned int)(part % 100));
+}
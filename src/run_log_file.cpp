@@ -0,0 +1,47 @@
+#ifndef ARDUINO
+
+// host stand-in for the SD card: each log file is a plain file. see tools/run_log_bench.cpp
+#include <stdio.h>
+#include "run_log.h"
+
+static FILE *log_file = NULL;
+static const char *log_directory = ".";
+
+void setRunLogDirectory(const char *path)
+{
+    log_directory = path;
+}
+
+static bool fileOpen(const char *name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", log_directory, name);
+    log_file = fopen(path, "wb");
+    return log_file != NULL;
+}
+
+static bool fileWrite(const uint8_t *data, uint16_t length)
+{
+    return log_file != NULL && fwrite(data, 1, length, log_file) == length;
+}
+
+static bool fileFlush(void)
+{
+    return log_file != NULL && fflush(log_file) == 0;
+}
+
+static bool fileClose(void)
+{
+    if (log_file == NULL)
+    {
+        return true;
+    }
+
+    bool ok = fclose(log_file) == 0;
+    log_file = NULL;
+    return ok;
+}
+
+const RunLogBackend run_log_file_backend = {fileOpen, fileWrite, fileFlush, fileClose};
+
+#endif
@@ -0,0 +1,56 @@
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <SD.h>
+#include "run_log.h"
+
+static File log_file;
+
+static bool sdOpen(const char *name)
+{
+    // FILE_WRITE appends; a run number seen before (journal reset) starts over
+    if (SD.exists(name))
+    {
+        SD.remove(name);
+    }
+    log_file = SD.open(name, FILE_WRITE);
+    return (bool)log_file;
+}
+
+static bool sdWrite(const uint8_t *data, uint16_t length)
+{
+    // the SD library caches one sector; only the chunk that completes it actually hits the card
+    return log_file.write(data, length) == length;
+}
+
+static bool sdFlush(void)
+{
+    // writes the cached sector, then the file's size into its directory entry
+    log_file.flush();
+    return true;
+}
+
+static bool sdClose(void)
+{
+    if (log_file)
+    {
+        log_file.close();
+    }
+    return true;
+}
+
+const RunLogBackend run_log_sd_backend = {sdOpen, sdWrite, sdFlush, sdClose};
+
+bool beginSdRunLog(uint8_t cs_pin)
+{
+    if (!SD.begin(cs_pin))
+    {
+        setRunLogBackend(NULL);
+        return false;
+    }
+
+    setRunLogBackend(&run_log_sd_backend);
+    return true;
+}
+
+#endif
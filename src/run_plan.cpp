@@ -0,0 +1,305 @@
+#include "run_plan.h"
+
+/**
+ * @brief stop compiling at a bad segment
+ */
+static uint8_t failPlan(RunPlan *ptr_plan, uint8_t index, uint8_t error)
+{
+    ptr_plan->num_steps = 0;
+    ptr_plan->error_step = index;
+    return error;
+}
+
+uint8_t compileRunPlan(const SegmentProfile *ptr_profile, float start_c, int min_c, int max_c, RunPlan *ptr_plan)
+{
+    ptr_plan->timed_s = 0;
+    if (ptr_profile->num_segments == 0 || ptr_profile->num_segments > MAX_PROFILE_SEGMENTS)
+    {
+        return failPlan(ptr_plan, 0, PLAN_EMPTY);
+    }
+
+    float setpoint_c = start_c;
+    for (uint8_t i = 0; i < ptr_profile->num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &ptr_profile->segments[i];
+        PlanStep *ptr_step = &ptr_plan->steps[i];
+
+        if (ptr_segment->type >= NUM_SEGMENT_TYPES)
+        {
+            return failPlan(ptr_plan, i, PLAN_BAD_TYPE);
+        }
+        if (ptr_segment->gate >= NUM_GATES)
+        {
+            return failPlan(ptr_plan, i, PLAN_BAD_GATE);
+        }
+        if (ptr_segment->target_c < min_c || ptr_segment->target_c > max_c)
+        {
+            return failPlan(ptr_plan, i, PLAN_BAD_TARGET);
+        }
+
+        ptr_step->type = ptr_segment->type;
+        ptr_step->fan_on = ptr_segment->fan_on;
+        ptr_step->gate = ptr_segment->gate;
+        ptr_step->abort_on_timeout = ptr_segment->abort_on_timeout;
+        ptr_step->band_c = ptr_segment->band_c;
+        ptr_step->timeout_s = ptr_segment->timeout_s;
+        ptr_step->target_c = ptr_segment->target_c;
+        ptr_step->start_c = setpoint_c;
+        ptr_step->slope_c_per_s = 0;
+        ptr_step->duration_s = 0;
+
+        switch (ptr_segment->type)
+        {
+        case SEGMENT_RAMP:
+            if (ptr_segment->value > 0)
+            {
+                float rate = ptr_segment->value / 10.0f;
+                float span = ptr_segment->target_c - setpoint_c;
+
+                // round up, so the setpoint always gets all the way to the target before the next step
+                ptr_step->duration_s = (uint32_t)((span < 0 ? -span : span) / rate + 0.999f);
+                ptr_step->slope_c_per_s = span < 0 ? -rate : rate;
+            }
+            break;
+        case SEGMENT_HOLD:
+            ptr_step->duration_s = ptr_segment->value;
+            break;
+        default:
+            break;
+        }
+
+        ptr_plan->timed_s += ptr_step->duration_s;
+        if (ptr_plan->timed_s > PLAN_MAX_DURATION_S)
+        {
+            return failPlan(ptr_plan, i, PLAN_TOO_LONG);
+        }
+
+        // every kind of segment leaves the setpoint at its target
+        setpoint_c = ptr_segment->target_c;
+    }
+
+    ptr_plan->num_steps = ptr_profile->num_segments;
+    ptr_plan->error_step = 0;
+    return PLAN_OK;
+}
+
+/**
+ * @brief make the current step start at start_s
+ */
+static void enterStep(PlanRun *ptr_run, const RunPlan *ptr_plan, uint32_t start_s, float temp_c)
+{
+    ptr_run->step_start_s = start_s;
+    ptr_run->gate_met = false;
+
+    if (ptr_run->index < ptr_plan->num_steps)
+    {
+        const PlanStep *ptr_step = &ptr_plan->steps[ptr_run->index];
+        ptr_run->rising = temp_c < ptr_step->target_c;
+
+        // time gated steps know when they end right away
+        ptr_run->end_known = ptr_step->gate == GATE_TIME;
+        ptr_run->step_end_s = start_s + ptr_step->duration_s;
+    }
+}
+
+void beginRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, uint32_t now_s, float temp_c)
+{
+    ptr_run->index = 0;
+    ptr_run->setpoint_c = temp_c;
+    ptr_run->timed_out = false;
+    ptr_run->paused = false;
+    enterStep(ptr_run, ptr_plan, now_s, temp_c);
+}
+
+/**
+ * @brief true once a step has waited its whole timeout for temperature
+ */
+static bool isTimeoutUp(const PlanStep *ptr_step, int32_t elapsed)
+{
+    return ptr_step->timeout_s > 0 && elapsed >= (int32_t)ptr_step->timeout_s;
+}
+
+/**
+ * @brief stop the run on a timeout
+ */
+static bool abortRunPlan(PlanRun *ptr_run)
+{
+    ptr_run->timed_out = true;
+    return false;
+}
+
+bool stepRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, uint32_t now_s, float temp_c)
+{
+    if (ptr_run->paused)
+    {
+        return ptr_run->index < ptr_plan->num_steps;
+    }
+
+    while (ptr_run->index < ptr_plan->num_steps)
+    {
+        const PlanStep *ptr_step = &ptr_plan->steps[ptr_run->index];
+
+        // the clock can be set back while running; treat that as no time passed
+        int32_t elapsed = (int32_t)(now_s - ptr_run->step_start_s);
+        if (elapsed < 0)
+        {
+            elapsed = 0;
+        }
+
+        // time based steps end on schedule, so a late tick doesn't stretch the profile
+        uint32_t next_start_s = now_s;
+
+        switch (ptr_step->type)
+        {
+        case SEGMENT_RAMP:
+        case SEGMENT_HOLD:
+            ptr_run->setpoint_c = ptr_step->target_c;
+            if ((uint32_t)elapsed < ptr_step->duration_s && ptr_step->type == SEGMENT_RAMP)
+            {
+                ptr_run->setpoint_c = ptr_step->start_c + ptr_step->slope_c_per_s * elapsed;
+            }
+
+            if (!ptr_run->end_known)
+            {
+                float error = temp_c - ptr_step->target_c;
+                bool in_band = error <= ptr_step->band_c && error >= -(float)ptr_step->band_c;
+                if (!in_band && !isTimeoutUp(ptr_step, elapsed))
+                {
+                    return true;
+                }
+                if (!in_band && ptr_step->abort_on_timeout)
+                {
+                    return abortRunPlan(ptr_run);
+                }
+
+                // in the band, or carrying on as if the oven got there. a temperature gated hold
+                // only starts counting now; otherwise the step can't end before now
+                ptr_run->gate_met = true;
+                ptr_run->end_known = true;
+                if (ptr_step->gate == GATE_TEMP && ptr_step->type == SEGMENT_HOLD)
+                {
+                    ptr_run->step_end_s = now_s + ptr_step->duration_s;
+                }
+                else if ((int32_t)(now_s - ptr_run->step_end_s) > 0)
+                {
+                    ptr_run->step_end_s = now_s;
+                }
+            }
+
+            if ((int32_t)(now_s - ptr_run->step_end_s) < 0)
+            {
+                return true;
+            }
+            next_start_s = ptr_run->step_end_s;
+            break;
+        case SEGMENT_HOLD_UNTIL_TEMP:
+            ptr_run->setpoint_c = ptr_step->target_c;
+            if (ptr_run->rising ? temp_c < ptr_step->target_c : temp_c > ptr_step->target_c)
+            {
+                if (!isTimeoutUp(ptr_step, elapsed))
+                {
+                    return true;
+                }
+                if (ptr_step->abort_on_timeout)
+                {
+                    return abortRunPlan(ptr_run);
+                }
+            }
+            break;
+        case SEGMENT_COOLDOWN:
+            if (temp_c > ptr_step->target_c)
+            {
+                ptr_run->setpoint_c = COOLDOWN_SETPOINT_C;
+                return true;
+            }
+            ptr_run->setpoint_c = ptr_step->target_c;
+            break;
+        default:
+            break;
+        }
+
+        ptr_run->index++;
+        enterStep(ptr_run, ptr_plan, next_start_s, temp_c);
+    }
+
+    return false;
+}
+
+void pauseRunPlan(PlanRun *ptr_run, uint32_t now_s)
+{
+    if (!ptr_run->paused)
+    {
+        ptr_run->paused = true;
+        ptr_run->paused_s = now_s;
+    }
+}
+
+void resumeRunPlan(PlanRun *ptr_run, uint32_t now_s)
+{
+    if (!ptr_run->paused)
+    {
+        return;
+    }
+
+    // move the step's start and end later by the time spent paused
+    int32_t paused_for = (int32_t)(now_s - ptr_run->paused_s);
+    if (paused_for > 0)
+    {
+        ptr_run->step_start_s += paused_for;
+        ptr_run->step_end_s += paused_for;
+    }
+    ptr_run->paused = false;
+}
+
+void getRunPlanPosition(const PlanRun *ptr_run, uint32_t now_s, PlanPosition *ptr_position)
+{
+    // a paused run is where it was when it paused
+    uint32_t at_s = ptr_run->paused ? ptr_run->paused_s : now_s;
+    int32_t elapsed = (int32_t)(at_s - ptr_run->step_start_s);
+
+    ptr_position->index = ptr_run->index;
+    ptr_position->end_known = ptr_run->end_known;
+    ptr_position->gate_met = ptr_run->gate_met;
+    ptr_position->rising = ptr_run->rising;
+    ptr_position->elapsed_s = elapsed > 0 ? elapsed : 0;
+
+    // a temperature gated hold can end more than a uint16 after it started. what matters on resume is the
+    // time left, so count the step as starting later, keeping step_end_s where it is
+    uint32_t end_offset_s = ptr_run->step_end_s - ptr_run->step_start_s;
+    if (ptr_run->end_known && end_offset_s > UINT16_MAX)
+    {
+        uint32_t later_s = end_offset_s - UINT16_MAX;
+        ptr_position->elapsed_s = ptr_position->elapsed_s > later_s ? ptr_position->elapsed_s - later_s : 0;
+        end_offset_s = UINT16_MAX;
+    }
+    ptr_position->end_offset_s = end_offset_s;
+}
+
+bool seekRunPlan(PlanRun *ptr_run, const RunPlan *ptr_plan, const PlanPosition *ptr_position, uint32_t now_s)
+{
+    if (ptr_position->index >= ptr_plan->num_steps)
+    {
+        return false;
+    }
+
+    const PlanStep *ptr_step = &ptr_plan->steps[ptr_position->index];
+    ptr_run->index = ptr_position->index;
+    ptr_run->end_known = ptr_position->end_known;
+    ptr_run->gate_met = ptr_position->gate_met;
+    ptr_run->rising = ptr_position->rising;
+    ptr_run->step_start_s = now_s - ptr_position->elapsed_s;
+    ptr_run->step_end_s = ptr_run->step_start_s + (ptr_position->end_known ? ptr_position->end_offset_s : ptr_step->duration_s);
+    ptr_run->setpoint_c = ptr_step->start_c;
+    ptr_run->paused = false;
+    return true;
+}
+
+bool isRunPlanFanOn(const PlanRun *ptr_run, const RunPlan *ptr_plan)
+{
+    if (ptr_run->index >= ptr_plan->num_steps)
+    {
+        return false;
+    }
+
+    return ptr_plan->steps[ptr_run->index].fan_on;
+}
@@ -1,188 +1,236 @@
 #include "screens.h"
 #include <Arduino.h>
 #include "config.h"
+#include "graph.h"
+#include "settings.h"
+#include "paste_library.h"
 
 // currently selected index for the menu item
 int index_to_highlight = 0;
 
+/**
+ * @brief generate item index of a profile list: "Cancel" back home, then the profile numbers
+ */
+static void profileListMenuItemAt(int index, int mode, MenuItem *ptr_menu_item)
+{
+    if (index == 0)
+    {
+        strcpy_P(ptr_menu_item->text, PSTR("Cancel"));
+        ptr_menu_item->mode = MODE_HOME;
+    }
+    else
+    {
+        formatFixed(index, 0, 0, ptr_menu_item->text);
+        ptr_menu_item->mode = mode;
+    }
+}
+
+void runReflowMenuItemAt(int index, MenuItem *ptr_menu_item)
+{
+    uint8_t profile_index = runListProfileIndex(index);
+    if (index > 0 && isLibraryProfile(profile_index))
+    {
+        getLibraryProfileName(profile_index - LIBRARY_PROFILE_INDEX, ptr_menu_item->text);
+        ptr_menu_item->mode = MODE_PROFILE_SELECTED_TO_RUN;
+    }
+    else
+    {
+        profileListMenuItemAt(index - (index > 0 ? NUM_LIBRARY_PROFILES : 0), MODE_PROFILE_SELECTED_TO_RUN, ptr_menu_item);
+    }
+}
+
+uint8_t runListProfileIndex(int index)
+{
+    // library profiles come first, so they don't need scrolling past every slot
+    if (index <= NUM_LIBRARY_PROFILES)
+    {
+        return LIBRARY_PROFILE_INDEX + index - 1;
+    }
+    return index - NUM_LIBRARY_PROFILES - 1;
+}
+
+void selectProfileToEditMenuItemAt(int index, MenuItem *ptr_menu_item)
+{
+    profileListMenuItemAt(index, MODE_EDIT_SELECTED_PROFILE, ptr_menu_item);
+}
+
+void editSettingsMenuItemAt(int index, MenuItem *ptr_menu_item)
+{
+    if (index == 0)
+    {
+        strcpy_P(ptr_menu_item->text, PSTR("Cancel"));
+        ptr_menu_item->mode = MODE_HOME;
+    }
+    else if (index <= NUM_SETTINGS)
+    {
+        // labels come straight from the settings registry
+        strcpy_P(ptr_menu_item->text, setting_defs[index - 1].name);
+        ptr_menu_item->mode = MODE_EDIT_SETTINGS;
+    }
+    else
+    {
+        strcpy_P(ptr_menu_item->text, PSTR("Save"));
+        ptr_menu_item->mode = MODE_HOME;
+    }
+}
+
+// Menu tables live in flash (PROGMEM) and are read with getMenuItem(). Only the ScreenItem
+// text fields, which get rewritten while the program runs, are kept in RAM.
+
 // status screen
-ScreenItem *status_screen_items = new ScreenItem[4];
-MenuScreen status_screen;
+ScreenItem status_screen_items[] = {{"TEMP"}, {"0"}, {"TARGET"}, {"0"}};
+MenuScreen status_screen = {0, NULL, -1, NUM_ITEMS(status_screen_items), status_screen_items};
 
 // home screen
-MenuItem *home_screen_menu_items = new MenuItem[5];
-ScreenItem *home_screen_items = new ScreenItem[4];
-MenuScreen home_screen;
+const MenuItem home_screen_menu_items[] PROGMEM = {
+    {"Cancel", MODE_STATUS},
+    {"Run", MODE_SELECT_PROFILE_TO_RUN},
+    {"Edit Prof", MODE_SELECT_PROFILE_TO_EDIT},
+    {"Edit PID", MODE_EDIT_PID_PRAMS},
+    {"Just Heat", MODE_HEAT_TO_TARGET},
+    {"Settings", MODE_EDIT_SETTINGS},
+};
+ScreenItem home_screen_items[] = {{"TEMP"}, {"0"}, {"TARGET"}, {"0"}};
+MenuScreen home_screen = {NUM_ITEMS(home_screen_menu_items), home_screen_menu_items, 0, NUM_ITEMS(home_screen_items), home_screen_items};
 
 // run reflow screen
-MenuItem *run_reflow_screen_menu_items = new MenuItem[11];
-MenuScreen run_reflow_screen;
-ScreenItem *run_reflow_screen_items = new ScreenItem[8];
+// this is MODE_SELECT_PROFILE_TO_RUN; back returns you to MODE_HOME
+// virtual list: "Cancel", the built-in library profiles by name, then one item per EEPROM slot, generated by
+// runReflowMenuItemAt() as they scroll into view
+// blank screen items; populated with the reflow params as user scrolls
+ScreenItem run_reflow_screen_items[] = {{" "}, {" "}, {" "}, {" "}, {" "}, {" "}, {" "}, {" "}};
+MenuScreen run_reflow_screen = {NUM_LIBRARY_PROFILES + NUM_REFLOW_PROFILES + 1, NULL, 0, NUM_ITEMS(run_reflow_screen_items), run_reflow_screen_items, 0, runReflowMenuItemAt};
 
 // profile selected to run Screen
-MenuItem *selected_to_run_menu_items = new MenuItem[3];
-MenuScreen selected_to_run_screen;
-ScreenItem *selected_to_run_screen_items = new ScreenItem[8];
+// this is MODE_PROFILE_SELECTED_TO_RUN; run brings you to MODE_PROFILE_SELECTED_RUNNING; back brings you to MODE_SELECT_PROFILE_TO_RUN;
+// edit brings you to MODE_EDIT_SELECTED_PROFILE; batch queues SETTING_BATCH_RUNS runs and waits in MODE_BATCH_STANDBY
+const MenuItem selected_to_run_menu_items[] PROGMEM = {
+    {"Cancel", MODE_SELECT_PROFILE_TO_RUN},
+    {"Run", MODE_PROFILE_SELECTED_RUNNING},
+    {"Edit", MODE_EDIT_SELECTED_PROFILE},
+    {"Batch", MODE_BATCH_STANDBY},
+};
+// populated with peak, runtime and fan once a profile is selected. the graph takes up the bottom of the screen
+ScreenItem selected_to_run_screen_items[] = {{" "}, {" "}, {" "}};
+MenuScreen selected_to_run_screen = {NUM_ITEMS(selected_to_run_menu_items), selected_to_run_menu_items, 0, NUM_ITEMS(selected_to_run_screen_items), selected_to_run_screen_items};
 
 // edit PID screen
-MenuItem *edit_pid_menu_items = new MenuItem[7];
-MenuScreen edit_pid_screen;
-ScreenItem *edit_pid_screen_items = new ScreenItem[1];
+const MenuItem edit_pid_menu_items[] PROGMEM = {
+    {"Cancel", MODE_HOME},
+    {"K", MODE_EDIT_PID_PRAMS},
+    {"I", MODE_EDIT_PID_PRAMS},
+    {"D", MODE_EDIT_PID_PRAMS},
+    {"Thresh.", MODE_EDIT_PID_PRAMS},
+    {"Save", MODE_EDIT_PID_PRAMS},
+};
+ScreenItem edit_pid_screen_items[] = {{" "}};
+MenuScreen edit_pid_screen = {NUM_ITEMS(edit_pid_menu_items), edit_pid_menu_items, 0, NUM_ITEMS(edit_pid_screen_items), edit_pid_screen_items};
 
 // edit reflow profile screen
-MenuItem *edit_reflow_menu_items = new MenuItem[9];
-MenuScreen edit_reflow_screen;
-ScreenItem *edit_reflow_screen_items = new ScreenItem[1];
+const MenuItem edit_reflow_menu_items[] PROGMEM = {
+    {"Cancel", MODE_HOME},
+    {"Pre Temp", MODE_EDIT_SELECTED_PROFILE},
+    {"Pre Time", MODE_EDIT_SELECTED_PROFILE},
+    {"Soak Temp", MODE_EDIT_SELECTED_PROFILE},
+    {"Soak Time", MODE_EDIT_SELECTED_PROFILE},
+    {"Refl Temp", MODE_EDIT_SELECTED_PROFILE},
+    {"Hold Time", MODE_EDIT_SELECTED_PROFILE},
+    {"Fan", MODE_EDIT_SELECTED_PROFILE},
+    {"Pre Gate", MODE_EDIT_SELECTED_PROFILE},
+    {"Soak Gate", MODE_EDIT_SELECTED_PROFILE},
+    {"Refl Gate", MODE_EDIT_SELECTED_PROFILE},
+    {"Fit Oven", MODE_EDIT_SELECTED_PROFILE},
+    {"Save", MODE_EDIT_SELECTED_PROFILE},
+};
+// currently-hovered reflow parameter, then the predicted runtime and the first stage the oven can't keep up with
+ScreenItem edit_reflow_screen_items[] = {{" "}, {" "}, {" "}};
+MenuScreen edit_reflow_screen = {NUM_ITEMS(edit_reflow_menu_items), edit_reflow_menu_items, 0, NUM_ITEMS(edit_reflow_screen_items), edit_reflow_screen_items};
 
 // select profile to edit screen
-MenuItem *select_profile_to_edit_menu_items = new MenuItem[11];
-MenuScreen select_profile_to_edit_screen;
-ScreenItem *select_profile_to_edit_screen_items = new ScreenItem[8];
-
-void initializeStatusScreen()
-{
-    initializeScreenItem(&(status_screen_items[0]), "TEMP", 4);
-    initializeScreenItem(&(status_screen_items[1]), "0", 1);
-    initializeScreenItem(&(status_screen_items[2]), "TARGET", 6);
-    initializeScreenItem(&(status_screen_items[3]), "0", 1);
-
-    initializeMenuScreen(&status_screen, 0, NULL, -1, 4, status_screen_items);
-}
-
-void initializeHomeScreen()
+// virtual list, same as the run reflow screen
+// all blank screen items
+ScreenItem select_profile_to_edit_screen_items[] = {{" "}, {" "}, {" "}, {" "}, {" "}, {" "}, {" "}, {" "}};
+MenuScreen select_profile_to_edit_screen = {NUM_REFLOW_PROFILES + 1, NULL, 0, NUM_ITEMS(select_profile_to_edit_screen_items), select_profile_to_edit_screen_items, 0, selectProfileToEditMenuItemAt};
+
+// edit settings screen
+// virtual list: "Cancel", one item per setting, "Save". one screen item shows the highlighted value
+ScreenItem edit_settings_screen_items[] = {{" "}};
+MenuScreen edit_settings_screen = {NUM_SETTINGS + 2, NULL, 0, NUM_ITEMS(edit_settings_screen_items), edit_settings_screen_items, 0, editSettingsMenuItemAt};
+
+// resume run screen
+// this is MODE_RESUME_RUN; resume carries on the cut off run in MODE_PROFILE_SELECTED_RUNNING, discard goes to MODE_STATUS
+const MenuItem resume_run_menu_items[] PROGMEM = {
+    {"Discard", MODE_STATUS},
+    {"Resume", MODE_PROFILE_SELECTED_RUNNING},
+};
+// populated with the profile, step and temperature of the checkpoint
+ScreenItem resume_run_screen_items[] = {{"Resume?"}, {" "}, {" "}, {" "}};
+MenuScreen resume_run_screen = {NUM_ITEMS(resume_run_menu_items), resume_run_menu_items, 0, NUM_ITEMS(resume_run_screen_items), resume_run_screen_items};
+
+void populateResumeRunScreen(uint8_t profile_index, uint8_t step_index, float temp_c)
 {
-    initializeScreenItem(&(home_screen_items[0]), "TEMP", 4);
-    initializeScreenItem(&(home_screen_items[1]), "0", 1);
-    initializeScreenItem(&(home_screen_items[2]), "TARGET", 6);
-    initializeScreenItem(&(home_screen_items[3]), "0", 1);
-
-    initializeMenuItem(&(home_screen_menu_items[0]), "Cancel", 6, MODE_STATUS, false);
-    initializeMenuItem(&(home_screen_menu_items[1]), "Run", 3, MODE_SELECT_PROFILE_TO_RUN, false);
-    initializeMenuItem(&(home_screen_menu_items[2]), "Edit Prof", 9, MODE_SELECT_PROFILE_TO_EDIT, false);
-    initializeMenuItem(&(home_screen_menu_items[3]), "Edit PID", 8, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(home_screen_menu_items[4]), "Just Heat", 9, MODE_HEAT_TO_TARGET, false);
-
-    initializeMenuScreen(&home_screen, 5, home_screen_menu_items, 0, 4, home_screen_items);
-}
+    char buffer[STR_LEN];
 
-void initializeRunReflowScreen()
-{
-    // this is MODE_SELECT_PROFILE_TO_RUN; back returns you to MODE_HOME
-
-    // initialize blank screen items; to be populated with the reflow params as user scrolls
-    for (int i = 0; i < 8; i++)
+    if (isLibraryProfile(profile_index))
+    {
+        getLibraryProfileName(profile_index - LIBRARY_PROFILE_INDEX, buffer);
+    }
+    else
     {
-        initializeScreenItem(&(run_reflow_screen_items[i]), " ", 1);
+        sprintf(buffer, "Prof %u", profile_index + 1);
     }
+    setScreenItemText(&resume_run_screen, 1, buffer);
 
-    initializeMenuItem(&(run_reflow_screen_menu_items[0]), "Cancel", 6, MODE_HOME, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[1]), "1", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[2]), "2", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[3]), "3", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[4]), "4", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[5]), "5", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[6]), "6", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[7]), "7", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[8]), "8", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[9]), "9", 1, MODE_PROFILE_SELECTED_TO_RUN, false);
-    initializeMenuItem(&(run_reflow_screen_menu_items[10]), "10", 2, MODE_PROFILE_SELECTED_TO_RUN, false);
+    sprintf(buffer, "Step %u", step_index + 1);
+    setScreenItemText(&resume_run_screen, 2, buffer);
 
-    initializeMenuScreen(&run_reflow_screen, 11, run_reflow_screen_menu_items, 0, 8, run_reflow_screen_items);
+    formatFixed(toFixed(temp_c, 1), 1, 'C', buffer);
+    setScreenItemText(&resume_run_screen, 3, buffer);
 }
 
-void initializeSelectedToRunScreen()
+void populateSelectedToRunScreen(ReflowProfile *ptr_profile)
 {
-    // this is MODE_PROFILE_SELECTED_TO_RUN; run brings you to MODE_PROFILE_SELECTED_RUNNING; back brings you to MODE_SELECT_PROFILE_TO_RUN;
-    // edit brings you to MODE_EDIT_SELECTED_PROFILE
-    // initialize blank screen items; to be populated with the reflow params as user scrolls
-    for (int i = 0; i < 8; i++)
-    {
-        initializeScreenItem(&(selected_to_run_screen_items[8]), " ", 1);
-    }
-
-    initializeMenuItem(&(selected_to_run_menu_items[0]), "Cancel", 6, MODE_SELECT_PROFILE_TO_RUN, false);
-    initializeMenuItem(&(selected_to_run_menu_items[1]), "Run", 3, MODE_PROFILE_SELECTED_RUNNING, false);
-    initializeMenuItem(&(selected_to_run_menu_items[2]), "Edit", 4, MODE_EDIT_SELECTED_PROFILE, false);
+    SegmentProfile segments;
+    profileToSegments(ptr_profile, &segments);
 
-    initializeMenuScreen(&selected_to_run_screen, 3, selected_to_run_menu_items, 0, 8, selected_to_run_screen_items);
+    populateSelectedToRunSegments(&segments);
 }
 
-void initializeEditPIDScreen()
+void populateSelectedToRunSegments(const SegmentProfile *ptr_segments)
 {
+    char buffer[STR_LEN];
 
-    initializeScreenItem(&(edit_pid_screen_items[0]), " ", 1);
+    buildSegmentGraph(ptr_segments, &selected_profile_graph);
 
-    initializeMenuItem(&(edit_pid_menu_items[0]), "Cancel", 6, MODE_HOME, false);
-    initializeMenuItem(&(edit_pid_menu_items[1]), "K", 6, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(edit_pid_menu_items[2]), "I", 6, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(edit_pid_menu_items[3]), "D", 6, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(edit_pid_menu_items[4]), "Thresh.", 7, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(edit_pid_menu_items[5]), "Inc.", 4, MODE_EDIT_PID_PRAMS, false);
-    initializeMenuItem(&(edit_pid_menu_items[6]), "Save", 4, MODE_EDIT_PID_PRAMS, false);
+    sprintf(buffer, "Pk %dC", selected_profile_graph.peak_temp_c);
+    setScreenItemText(&selected_to_run_screen, 0, buffer);
 
-    initializeMenuScreen(&edit_pid_screen, 7, edit_pid_menu_items, 0, 1, edit_pid_screen_items);
-}
-
-void initializeEditReflowScreen()
-{
-    // just one screen item to display currently-hovered reflow parameter
-    initializeScreenItem(&(edit_reflow_screen_items[0]), " ", 1);
-
-    initializeMenuItem(&(edit_reflow_menu_items[0]), "Cancel", 6, MODE_HOME, false);
-    initializeMenuItem(&(edit_reflow_menu_items[1]), "Pre Temp", 8, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[2]), "Pre Time", 8, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[3]), "Soak Temp", 9, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[4]), "Soak Time", 9, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[5]), "Refl Temp", 6, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[6]), "Hold Temp", 9, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[7]), "Fan", 3, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(edit_reflow_menu_items[8]), "Save", 4, MODE_EDIT_SELECTED_PROFILE, false);
-
-    initializeMenuScreen(&edit_reflow_screen, 9, edit_reflow_menu_items, 0, 1, edit_reflow_screen_items);
-}
+    sprintf(buffer, "~%us", selected_profile_graph.total_time_s);
+    setScreenItemText(&selected_to_run_screen, 1, buffer);
 
-void initializeSelectProfileToEditScreen()
-{
-    // all blank screen items
-    for (int i = 0; i < 8; i++)
-    {
-        initializeScreenItem(&(select_profile_to_edit_screen_items[i]), " ", 1);
-    }
-    initializeMenuItem(&(select_profile_to_edit_menu_items[0]), "Cancel", 6, MODE_HOME, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[1]), "1", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[2]), "2", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[3]), "3", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[4]), "4", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[5]), "5", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[6]), "6", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[7]), "7", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[8]), "8", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[9]), "9", 1, MODE_EDIT_SELECTED_PROFILE, false);
-    initializeMenuItem(&(select_profile_to_edit_menu_items[10]), "10", 2, MODE_EDIT_SELECTED_PROFILE, false);
-
-    initializeMenuScreen(&select_profile_to_edit_screen, 11, select_profile_to_edit_menu_items, 0, 8, select_profile_to_edit_screen_items);
-}
+    bool fan_on = false;
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        fan_on |= ptr_segments->segments[i].fan_on;
+    }
 
-void initializeAllScreens()
-{
-    initializeStatusScreen();
-    initializeHomeScreen();
-    initializeRunReflowScreen();
-    initializeSelectedToRunScreen();
-    initializeEditPIDScreen();
-    initializeEditReflowScreen();
-    initializeSelectProfileToEditScreen();
+    if (fan_on)
+    {
+        setScreenItemText(&selected_to_run_screen, 2, "Fan On");
+    }
+    else
+    {
+        setScreenItemText(&selected_to_run_screen, 2, "Fan Off");
+    }
 }
 
 void set_item_to_highlight(MenuScreen *screen, int index)
 {
-    int num_items = screen->numMenuItems;
-    for (int i = 0; i < num_items; i++)
+    if (index < 0 || index >= screen->numMenuItems)
     {
-        screen->menuItems[i].highlighted = false;
+        return;
     }
 
-    screen->menuItems[index].highlighted = true;
     screen->selectedMenuItemIndex = index;
     index_to_highlight = index;
 }
@@ -0,0 +1,503 @@
+#include "serial_commands.h"
+#include "serial_protocol.h"
+#include "trace.h"
+#include "journal.h"
+#include "settings.h"
+#include "run_log.h"
+#include "PID.h"
+#include "synth.h"
+#include "oven_model.h"
+#include "learning.h"
+#include "storage.h"
+#include <stddef.h>
+
+struct SerialCommand
+{
+    char name[8];
+    void (*handler)(char *args);
+};
+
+static void helpCommand(char *args);
+static void traceCommand(char *args);
+static void journalCommand(char *args);
+static void runLogCommand(char *args);
+static void getCommand(char *args);
+static void setCommand(char *args);
+static void synthCommand(char *args);
+static void ovenCommand(char *args);
+static void learnCommand(char *args);
+
+static const SerialCommand commands[] PROGMEM = {
+    {"help", helpCommand},
+    {"trace", traceCommand},
+    {"journal", journalCommand},
+    {"runlog", runLogCommand},
+    {"get", getCommand},
+    {"set", setCommand},
+    {"synth", synthCommand},
+    {"oven", ovenCommand},
+    {"learn", learnCommand},
+};
+
+#define NUM_SERIAL_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static char line[SERIAL_COMMAND_MAX_LENGTH + 1];
+static uint8_t line_length = 0;
+static bool line_overflow = false;
+
+static void helpCommand(char *args)
+{
+    for (uint8_t i = 0; i < NUM_SERIAL_COMMANDS; i++)
+    {
+        Serial.println((const __FlashStringHelper *)commands[i].name);
+    }
+}
+
+static void traceCommand(char *args)
+{
+    // dumping takes a while at 9600 baud and blocks the loop; never do it with the heater under control
+    if (flag_PID_running || isTraceRecording())
+    {
+        Serial.println(F("busy: oven is running"));
+        return;
+    }
+
+    long run_number = *args ? atol(args) : -1;
+    if (dumpTraces(run_number) == 0)
+    {
+        Serial.println(F("no traces"));
+    }
+}
+
+static void journalCommand(char *args)
+{
+    printJournal();
+}
+
+static void runLogCommand(char *args)
+{
+    const RunLogStats *ptr_stats = getRunLogStats();
+
+    Serial.print(isRunLogActive() ? F("logging") : F("idle"));
+    Serial.print(F(" records="));
+    Serial.print(ptr_stats->records);
+    Serial.print(F(" dropped="));
+    Serial.print(ptr_stats->dropped_records);
+    Serial.print(F(" blocks="));
+    Serial.print(ptr_stats->blocks);
+    Serial.print(F(" files="));
+    Serial.print(ptr_stats->files);
+    if (ptr_stats->failed)
+    {
+        Serial.print(F(" FAILED"));
+    }
+    Serial.println();
+}
+
+static void printSetting(uint8_t id)
+{
+    char buffer[STR_LEN];
+    SettingDef def;
+    getSettingDef(id, &def);
+    formatSetting(id, buffer);
+
+    Serial.print(def.key);
+    Serial.print(F(" = "));
+    Serial.print(buffer);
+    Serial.print(F(" ("));
+    Serial.print(def.min);
+    Serial.print(F(" - "));
+    Serial.print(def.max);
+    Serial.print(F(", default "));
+    Serial.print(def.default_value);
+    Serial.println(')');
+}
+
+static void getCommand(char *args)
+{
+    if (!*args)
+    {
+        for (uint8_t id = 0; id < NUM_SETTINGS; id++)
+        {
+            printSetting(id);
+        }
+        return;
+    }
+
+    int id = findSetting(args);
+    if (id < 0)
+    {
+        Serial.println(F("unknown setting"));
+        return;
+    }
+    printSetting(id);
+}
+
+static void setCommand(char *args)
+{
+    // "<key> <value>"
+    char *value = strchr(args, ' ');
+    if (value == NULL)
+    {
+        Serial.println(F("usage: set <key> <value>"));
+        return;
+    }
+    *value++ = '\0';
+
+    int id = findSetting(args);
+    if (id < 0)
+    {
+        Serial.println(F("unknown setting"));
+        return;
+    }
+    if (!parseSetting(id, value))
+    {
+        Serial.println(F("bad value"));
+        return;
+    }
+
+    saveSettings();
+    printSetting(id);
+}
+
+/**
+ * @brief paste windows the "synth" command works from; changed one at a time, since a line is only SERIAL_COMMAND_MAX_LENGTH
+ */
+static PasteWindow synth_window;
+static bool synth_window_set = false;
+
+struct SynthField
+{
+    char key[11];
+    uint8_t offset; // into PasteWindow
+    bool rate;      // typed in C/s, stored in 0.1 C/s
+};
+
+static const SynthField synth_fields[] PROGMEM = {
+    {"ramp", offsetof(PasteWindow, max_ramp), true},
+    {"cool", offsetof(PasteWindow, max_cool), true},
+    {"soak_lo", offsetof(PasteWindow, soak_min_c), false},
+    {"soak_hi", offsetof(PasteWindow, soak_max_c), false},
+    {"soak_min_s", offsetof(PasteWindow, soak_min_s), false},
+    {"soak_max_s", offsetof(PasteWindow, soak_max_s), false},
+    {"liquidus", offsetof(PasteWindow, liquidus_c), false},
+    {"tal_min_s", offsetof(PasteWindow, tal_min_s), false},
+    {"tal_max_s", offsetof(PasteWindow, tal_max_s), false},
+    {"peak_lo", offsetof(PasteWindow, peak_min_c), false},
+    {"peak_hi", offsetof(PasteWindow, peak_max_c), false},
+};
+
+#define NUM_SYNTH_FIELDS (sizeof(synth_fields) / sizeof(synth_fields[0]))
+
+static void printSynthWindow(void)
+{
+    for (uint8_t i = 0; i < NUM_SYNTH_FIELDS; i++)
+    {
+        SynthField field;
+        memcpy_P(&field, &synth_fields[i], sizeof(field));
+        int16_t value = *(int16_t *)((uint8_t *)&synth_window + field.offset);
+
+        Serial.print(field.key);
+        Serial.print(F(" = "));
+        if (field.rate)
+        {
+            Serial.print(value / 10.0f, 1);
+        }
+        else
+        {
+            Serial.print(value);
+        }
+        Serial.println();
+    }
+}
+
+static void printSynthProfile(const SegmentProfile *ptr_segments, const SynthReport *ptr_report)
+{
+    // indexed by SegmentType
+    static const char type_names[NUM_SEGMENT_TYPES][9] PROGMEM = {"ramp", "hold", "until", "cooldown"};
+
+    for (uint8_t i = 0; i < ptr_segments->num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &ptr_segments->segments[i];
+        char name[9];
+        strcpy_P(name, type_names[ptr_segment->type]);
+
+        Serial.print(i + 1);
+        Serial.print(' ');
+        Serial.print(name);
+        Serial.print(' ');
+        Serial.print(ptr_segment->target_c);
+        Serial.print('C');
+        if (ptr_segment->type == SEGMENT_RAMP)
+        {
+            Serial.print(F(" at "));
+            Serial.print(ptr_segment->value / 10.0f, 1);
+            Serial.print(F("C/s"));
+        }
+        else if (ptr_segment->type == SEGMENT_HOLD)
+        {
+            Serial.print(F(" for "));
+            Serial.print(ptr_segment->value);
+            Serial.print('s');
+        }
+        Serial.println();
+    }
+
+    Serial.print(F("peak "));
+    Serial.print(ptr_report->peak_c);
+    Serial.print(F("C, soak "));
+    Serial.print(ptr_report->soak_s);
+    Serial.print(F("s, TAL "));
+    Serial.print(ptr_report->tal_s);
+    Serial.print(F("s, total "));
+    Serial.print(ptr_report->total_s);
+    Serial.println('s');
+}
+
+static void synthCommand(char *args)
+{
+    // "", "<field> <value>", "save <slot>" or "reset"
+    if (!synth_window_set || strcmp_P(args, PSTR("reset")) == 0)
+    {
+        defaultPasteWindow(&synth_window);
+        synth_window_set = true;
+    }
+
+    char *value = strchr(args, ' ');
+    if (value != NULL)
+    {
+        *value++ = '\0';
+    }
+
+    if (*args && strcmp_P(args, PSTR("save")) != 0 && strcmp_P(args, PSTR("reset")) != 0)
+    {
+        for (uint8_t i = 0; i < NUM_SYNTH_FIELDS; i++)
+        {
+            SynthField field;
+            memcpy_P(&field, &synth_fields[i], sizeof(field));
+            if (strcmp(args, field.key) == 0)
+            {
+                if (value == NULL)
+                {
+                    break;
+                }
+                *(int16_t *)((uint8_t *)&synth_window + field.offset) = field.rate ? (int16_t)(atof(value) * 10 + 0.5f) : atoi(value);
+                printSynthWindow();
+                return;
+            }
+        }
+
+        Serial.println(F("usage: synth [reset | save <slot> | <field> <value>]. fields:"));
+        printSynthWindow();
+        return;
+    }
+
+    SegmentProfile segments;
+    SynthReport report;
+    // the slowest the oven heats anywhere up to the peak, so every ramp is one it can follow
+    OvenRates oven = {getOvenMinHeatRate(synth_window.peak_max_c), oven_model.cool};
+    uint8_t error = synthesizeProfile(&synth_window, &oven, PROFILE_GRAPH_AMBIENT_C, SYNTH_DEFAULT_END_C, DEFAULT_FAN_ON, &segments, &report);
+    if (error != SYNTH_OK)
+    {
+        Serial.print(F("can't meet the windows: error "));
+        Serial.println(error);
+        return;
+    }
+    printSynthProfile(&segments, &report);
+
+    if (strcmp_P(args, PSTR("save")) == 0)
+    {
+        // slots only hold preheat/soak/reflow; the ramp rates and controlled cooling don't carry over
+        ReflowProfile profile;
+        long slot = value != NULL ? atol(value) : 0;
+        if (slot < 1 || slot > NUM_REFLOW_PROFILES || !segmentsToProfile(&segments, &profile))
+        {
+            Serial.println(F("can't save to that slot"));
+            return;
+        }
+        // the running profile may be the one in that slot
+        if (flag_PID_running || isTraceRecording())
+        {
+            Serial.println(F("busy: oven is running"));
+            return;
+        }
+        writeProfileRecord(slot - 1, &profile);
+        Serial.print(F("saved to slot "));
+        Serial.println(slot);
+    }
+}
+
+static void printOvenModel(void)
+{
+    for (uint8_t i = 0; i < OVEN_MODEL_POINTS; i++)
+    {
+        Serial.print(F("heat "));
+        Serial.print((i + 1) * OVEN_MODEL_STEP_C);
+        Serial.print(F("C = "));
+        Serial.print(oven_model.heat[i] / 10.0f, 1);
+        Serial.println(F("C/s"));
+    }
+    Serial.print(F("cool = "));
+    Serial.print(oven_model.cool / 10.0f, 1);
+    Serial.println(F("C/s"));
+}
+
+/**
+ * @brief parse a rate typed in C/s into 0.1 C/s. 0 if it's out of range
+ */
+static uint8_t parseOvenRate(const char *text)
+{
+    float rate = atof(text);
+    return rate >= 0.1f && rate <= 25.5f ? (uint8_t)(rate * 10 + 0.5f) : 0;
+}
+
+static void ovenCommand(char *args)
+{
+    // "", "heat <C> <C/s>", "cool <C/s>" or "reset"
+    char *value = strchr(args, ' ');
+    if (value != NULL)
+    {
+        *value++ = '\0';
+    }
+
+    if (!*args)
+    {
+        printOvenModel();
+        return;
+    }
+
+    if (strcmp_P(args, PSTR("reset")) == 0)
+    {
+        // a failed CRC is what brings the defaults back
+        oven_model.cool = 0;
+        saveOvenModel();
+        loadOvenModel();
+    }
+    else if (strcmp_P(args, PSTR("cool")) == 0 && value != NULL && parseOvenRate(value) > 0)
+    {
+        oven_model.cool = parseOvenRate(value);
+    }
+    else if (strcmp_P(args, PSTR("heat")) == 0 && value != NULL && strchr(value, ' ') != NULL && parseOvenRate(strchr(value, ' ') + 1) > 0)
+    {
+        // the point nearest the temperature
+        int point = (atoi(value) + OVEN_MODEL_STEP_C / 2) / OVEN_MODEL_STEP_C - 1;
+        oven_model.heat[constrain(point, 0, OVEN_MODEL_POINTS - 1)] = parseOvenRate(strchr(value, ' ') + 1);
+    }
+    else
+    {
+        Serial.println(F("usage: oven [reset | heat <C> <C/s> | cool <C/s>]"));
+        return;
+    }
+
+    saveOvenModel();
+    printOvenModel();
+}
+
+static void learnCommand(char *args)
+{
+    // "" lists what's been learned, "reset" forgets it
+    if (strcmp_P(args, PSTR("reset")) == 0)
+    {
+        clearLearning();
+    }
+    else if (*args)
+    {
+        Serial.println(F("usage: learn [reset]"));
+        return;
+    }
+
+    for (uint8_t slot = 0; slot < LEARNING_NUM_SLOTS; slot++)
+    {
+        LearningRecord record;
+        if (!readLearningSlot(slot, &record) || record.profile_index == LEARNING_NO_PROFILE)
+        {
+            continue;
+        }
+
+        // profile, runs, then the correction of every bin
+        Serial.print(F("profile "));
+        Serial.print(record.profile_index);
+        Serial.print(F(", "));
+        Serial.print(record.runs);
+        Serial.print(F(" runs:"));
+        for (uint8_t i = 0; i < LEARNING_NUM_BINS; i++)
+        {
+            Serial.print(' ');
+            Serial.print(record.correction[i] * LEARNING_UNIT, 1);
+        }
+        Serial.println();
+    }
+}
+
+static void runCommand(char *command)
+{
+    // split off the arguments
+    char *args = command;
+    while (*args && *args != ' ')
+    {
+        args++;
+    }
+    if (*args)
+    {
+        *args++ = '\0';
+    }
+    while (*args == ' ')
+    {
+        args++;
+    }
+
+    if (!*command)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < NUM_SERIAL_COMMANDS; i++)
+    {
+        if (strcmp_P(command, commands[i].name) == 0)
+        {
+            SerialCommand found;
+            memcpy_P(&found, &commands[i], sizeof(found));
+            found.handler(args);
+            return;
+        }
+    }
+
+    Serial.print(F("unknown command: "));
+    Serial.println(command);
+}
+
+void serviceSerialCommands(void)
+{
+    while (Serial.available() > 0)
+    {
+        char c = Serial.read();
+
+        // binary frames (serial_protocol.h) start where a text line could
+        if (isProtocolFrameActive() || (line_length == 0 && (uint8_t)c == PROTOCOL_SYNC))
+        {
+            feedProtocolByte(c);
+        }
+        else if (c == '\n' || c == '\r')
+        {
+            line[line_length] = '\0';
+            if (line_overflow)
+            {
+                Serial.println(F("command too long"));
+            }
+            else
+            {
+                runCommand(line);
+            }
+            line_length = 0;
+            line_overflow = false;
+        }
+        else if (line_length < SERIAL_COMMAND_MAX_LENGTH)
+        {
+            line[line_length++] = c;
+        }
+        else
+        {
+            line_overflow = true;
+        }
+    }
+}
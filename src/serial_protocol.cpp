@@ -0,0 +1,298 @@
+#include "serial_protocol.h"
+#include "storage.h"
+#include "PID.h"
+#include "reflow.h"
+
+// receive state
+#define FRAME_IDLE 0
+#define FRAME_LENGTH 1
+#define FRAME_COMMAND 2
+#define FRAME_PAYLOAD 3
+#define FRAME_CRC_LOW 4
+#define FRAME_CRC_HIGH 5
+
+static uint8_t frame_state = FRAME_IDLE;
+static uint8_t frame_length;
+static uint8_t frame_command;
+static uint8_t frame_payload[PROTOCOL_MAX_PAYLOAD];
+static uint8_t frame_received;
+static uint16_t frame_crc;
+static unsigned long last_byte_ms;
+
+static void putU16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+}
+
+static uint16_t getU16(const uint8_t *buffer)
+{
+    return buffer[0] | ((uint16_t)buffer[1] << 8);
+}
+
+static void putFloat(uint8_t *buffer, double value)
+{
+    float f = value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        buffer[i] = bits >> (8 * i);
+    }
+}
+
+static double getFloat(const uint8_t *buffer)
+{
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        bits |= (uint32_t)buffer[i] << (8 * i);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static void encodeProfile(ReflowProfile *ptr_profile, uint8_t *buffer)
+{
+    buffer[0] = ptr_profile->fan_on ? 1 : 0;
+    putU16(buffer + 1, ptr_profile->preheat_temp_c);
+    putU16(buffer + 3, ptr_profile->preheat_time_s);
+    putU16(buffer + 5, ptr_profile->soak_temp_c);
+    putU16(buffer + 7, ptr_profile->soak_time_s);
+    putU16(buffer + 9, ptr_profile->reflow_temp);
+    putU16(buffer + 11, ptr_profile->reflow_hold_time_s);
+    buffer[13] = ptr_profile->preheat_gate | (ptr_profile->soak_gate << 2) | (ptr_profile->reflow_gate << 4);
+}
+
+/**
+ * @param length PROTOCOL_PROFILE_SIZE, or PROTOCOL_V1_PROFILE_SIZE which leaves every stage time gated
+ */
+static void decodeProfile(const uint8_t *buffer, uint8_t length, ReflowProfile *ptr_profile)
+{
+    ptr_profile->fan_on = buffer[0] != 0;
+    ptr_profile->preheat_temp_c = (int16_t)getU16(buffer + 1);
+    ptr_profile->preheat_time_s = (int16_t)getU16(buffer + 3);
+    ptr_profile->soak_temp_c = (int16_t)getU16(buffer + 5);
+    ptr_profile->soak_time_s = (int16_t)getU16(buffer + 7);
+    ptr_profile->reflow_temp = (int16_t)getU16(buffer + 9);
+    ptr_profile->reflow_hold_time_s = (int16_t)getU16(buffer + 11);
+
+    uint8_t gates = length > PROTOCOL_V1_PROFILE_SIZE ? buffer[13] : 0;
+    ptr_profile->preheat_gate = gates & 3;
+    ptr_profile->soak_gate = (gates >> 2) & 3;
+    ptr_profile->reflow_gate = (gates >> 4) & 3;
+}
+
+static void encodePID(PID_Constants *ptr_constants, uint8_t *buffer)
+{
+    putFloat(buffer, ptr_constants->PID_k);
+    putFloat(buffer + 4, ptr_constants->PID_i);
+    putFloat(buffer + 8, ptr_constants->PID_d);
+    putFloat(buffer + 12, ptr_constants->threshold);
+}
+
+static void decodePID(const uint8_t *buffer, PID_Constants *ptr_constants)
+{
+    ptr_constants->PID_k = getFloat(buffer);
+    ptr_constants->PID_i = getFloat(buffer + 4);
+    ptr_constants->PID_d = getFloat(buffer + 8);
+    ptr_constants->threshold = getFloat(buffer + 12);
+}
+
+static void sendFrame(uint8_t command, const uint8_t *payload, uint8_t length)
+{
+    uint8_t head[3] = {PROTOCOL_SYNC, length, command};
+    uint16_t crc = crc16(0xFFFF, head + 1, 2);
+    crc = crc16(crc, payload, length);
+
+    uint8_t tail[2];
+    putU16(tail, crc);
+
+    Serial.write(head, sizeof(head));
+    Serial.write(payload, length);
+    Serial.write(tail, sizeof(tail));
+}
+
+/**
+ * @brief run a complete, CRC-checked request and fill in the reply payload after the status byte
+ *
+ * @return uint8_t reply length
+ */
+static uint8_t handleFrame(uint8_t *reply)
+{
+    uint8_t *status = reply;
+    *status = PROTOCOL_OK;
+
+    switch (frame_command)
+    {
+    case PROTOCOL_PING:
+        reply[1] = PROTOCOL_VERSION;
+        reply[2] = NUM_REFLOW_PROFILES;
+        return 3;
+
+    case PROTOCOL_READ_PROFILE:
+    {
+        if (frame_length != 1)
+        {
+            *status = PROTOCOL_BAD_LENGTH;
+            return 1;
+        }
+        uint8_t slot = frame_payload[0];
+        if (slot >= NUM_REFLOW_PROFILES)
+        {
+            *status = PROTOCOL_BAD_SLOT;
+            return 1;
+        }
+
+        ReflowProfile profile;
+        if (!loadProfile(slot, &profile))
+        {
+            *status = PROTOCOL_EMPTY_SLOT;
+        }
+        reply[1] = slot;
+        encodeProfile(&profile, reply + 2);
+        return 2 + PROTOCOL_PROFILE_SIZE;
+    }
+
+    case PROTOCOL_WRITE_PROFILE:
+    {
+        if (frame_length != 1 + PROTOCOL_PROFILE_SIZE && frame_length != 1 + PROTOCOL_V1_PROFILE_SIZE)
+        {
+            *status = PROTOCOL_BAD_LENGTH;
+            return 1;
+        }
+        uint8_t slot = frame_payload[0];
+        reply[1] = slot;
+        if (slot >= NUM_REFLOW_PROFILES)
+        {
+            *status = PROTOCOL_BAD_SLOT;
+            return 2;
+        }
+        if (flag_PID_running)
+        {
+            *status = PROTOCOL_BUSY;
+            return 2;
+        }
+
+        ReflowProfile profile;
+        decodeProfile(frame_payload + 1, frame_length - 1, &profile);
+        if (!isProfileValid(&profile))
+        {
+            *status = PROTOCOL_INVALID_VALUE;
+            return 2;
+        }
+
+        writeProfileRecord(slot, &profile);
+        return 2;
+    }
+
+    case PROTOCOL_READ_PID:
+        if (frame_length != 0)
+        {
+            *status = PROTOCOL_BAD_LENGTH;
+            return 1;
+        }
+        encodePID(&(pid.constants), reply + 1);
+        return 1 + PROTOCOL_PID_SIZE;
+
+    case PROTOCOL_WRITE_PID:
+    {
+        if (frame_length != PROTOCOL_PID_SIZE)
+        {
+            *status = PROTOCOL_BAD_LENGTH;
+            return 1;
+        }
+        if (flag_PID_running)
+        {
+            *status = PROTOCOL_BUSY;
+            return 1;
+        }
+
+        PID_Constants constants;
+        decodePID(frame_payload, &constants);
+        if (!is_PID_constants_valid(&constants))
+        {
+            *status = PROTOCOL_INVALID_VALUE;
+            return 1;
+        }
+
+        pid.constants = constants;
+        writePIDConstantsRecord(&(pid.constants));
+        return 1;
+    }
+
+    default:
+        *status = PROTOCOL_UNKNOWN_COMMAND;
+        return 1;
+    }
+}
+
+bool isProtocolFrameActive(void)
+{
+    if (frame_state != FRAME_IDLE && millis() - last_byte_ms > PROTOCOL_FRAME_TIMEOUT_MS)
+    {
+        // sender gave up mid-frame
+        frame_state = FRAME_IDLE;
+    }
+    return frame_state != FRAME_IDLE;
+}
+
+void feedProtocolByte(uint8_t data)
+{
+    last_byte_ms = millis();
+
+    switch (frame_state)
+    {
+    case FRAME_IDLE:
+        if (data == PROTOCOL_SYNC)
+        {
+            frame_state = FRAME_LENGTH;
+        }
+        break;
+    case FRAME_LENGTH:
+        frame_length = data;
+        frame_crc = crc16Update(0xFFFF, data);
+        // too long for the buffer: can't be a valid request. resync
+        frame_state = frame_length <= PROTOCOL_MAX_PAYLOAD ? FRAME_COMMAND : FRAME_IDLE;
+        break;
+    case FRAME_COMMAND:
+        frame_command = data;
+        frame_crc = crc16Update(frame_crc, data);
+        frame_received = 0;
+        frame_state = frame_length > 0 ? FRAME_PAYLOAD : FRAME_CRC_LOW;
+        break;
+    case FRAME_PAYLOAD:
+        frame_payload[frame_received++] = data;
+        frame_crc = crc16Update(frame_crc, data);
+        if (frame_received == frame_length)
+        {
+            frame_state = FRAME_CRC_LOW;
+        }
+        break;
+    case FRAME_CRC_LOW:
+        frame_crc ^= data;
+        frame_state = FRAME_CRC_HIGH;
+        break;
+    case FRAME_CRC_HIGH:
+    {
+        frame_crc ^= (uint16_t)data << 8;
+        frame_state = FRAME_IDLE;
+
+        uint8_t reply[1 + PROTOCOL_MAX_PAYLOAD];
+        uint8_t reply_length;
+        if (frame_crc != 0)
+        {
+            reply[0] = PROTOCOL_BAD_CRC;
+            reply_length = 1;
+        }
+        else
+        {
+            reply_length = handleFrame(reply);
+        }
+
+        sendFrame(frame_command | PROTOCOL_REPLY, reply, reply_length);
+        break;
+    }
+    }
+}
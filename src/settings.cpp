@@ -0,0 +1,186 @@
+#include "settings.h"
+#include "storage.h"
+#include "eeprom_cache.h"
+#include "journal.h"
+#include "temperature.h"
+#include "buttons.h"
+#include "reflow.h"
+#include "batch.h"
+
+#define SETTINGS_PAYLOAD_SIZE(count) (1 + 2 * (count))
+
+static_assert(SETTINGS_RECORD_ADDRESS >= JOURNAL_END_ADDRESS, "settings record overlaps the journal");
+static_assert(SETTINGS_RECORD_ADDRESS + sizeof(uint16_t) + SETTINGS_PAYLOAD_SIZE(SETTINGS_MAX_STORED) <= EEPROM_SIZE, "settings record doesn't fit in the EEPROM");
+static_assert(SETTINGS_PAYLOAD_SIZE(SETTINGS_MAX_STORED) <= RECORD_MAX_PAYLOAD, "settings record too big");
+static_assert(NUM_SETTINGS <= SETTINGS_MAX_STORED, "too many settings for the record");
+
+// index is the MAX31856_TCTYPE_ value
+static const char thermocouple_letters[] = "BEJKNRST";
+
+const SettingDef setting_defs[NUM_SETTINGS] PROGMEM = {
+    {"PID ms", "pid_ms", SETTING_TYPE_MS, 10, 100, 5000, MS_BETWEEN_PID},
+    {"Read ms", "read_ms", SETTING_TYPE_MS, 10, 100, 5000, MIN_TIME_BETWEEN_THERMO_READ},
+    {"Shimmy ms", "shimmy_ms", SETTING_TYPE_MS, 100, 500, 30000, SHIMMY_PERIOD},
+    {"TC Type", "tc_type", SETTING_TYPE_THERMOCOUPLE, 1, MAX31856_TCTYPE_B, MAX31856_TCTYPE_T, DEFAULT_THERMOCOUPLE_TYPE},
+    {"Debounce", "debounce_ms", SETTING_TYPE_MS, 1, 1, 200, BUTTON_DEBOUNCE_MS},
+    {"Gate Band", "gate_band_c", SETTING_TYPE_C, 1, 1, 50, DEFAULT_GATE_BAND_C},
+    {"Gate T/O", "gate_tmo_s", SETTING_TYPE_S, 10, 0, 1800, DEFAULT_GATE_TIMEOUT_S},
+    {"Gate Abrt", "gate_abort", SETTING_TYPE_ON_OFF, 1, 0, 1, DEFAULT_GATE_ABORT},
+    {"Batch Qty", "batch_runs", SETTING_TYPE_COUNT, 1, 1, MAX_BATCH_RUNS, DEFAULT_BATCH_RUNS},
+    {"Standby", "standby_c", SETTING_TYPE_C, 5, 0, 150, DEFAULT_STANDBY_C},
+    {"Start Win", "start_win_c", SETTING_TYPE_C, 1, 1, 50, DEFAULT_START_WINDOW_C},
+};
+
+uint16_t setting_values[NUM_SETTINGS];
+
+void getSettingDef(uint8_t id, SettingDef *ptr_def)
+{
+    memcpy_P(ptr_def, &setting_defs[id], sizeof(SettingDef));
+}
+
+static bool isSettingValid(uint8_t id, uint16_t value)
+{
+    SettingDef def;
+    getSettingDef(id, &def);
+    return value >= def.min && value <= def.max;
+}
+
+void loadSettings(void)
+{
+    uint8_t payload[SETTINGS_PAYLOAD_SIZE(SETTINGS_MAX_STORED)];
+
+    // the record's length depends on how many values it holds
+    uint8_t count;
+    eepromCacheRead(SETTINGS_RECORD_ADDRESS + sizeof(uint16_t), &count, 1);
+    if (count > SETTINGS_MAX_STORED || !readRecordAt(SETTINGS_RECORD_ADDRESS, RECORD_SETTINGS, payload, SETTINGS_PAYLOAD_SIZE(count)))
+    {
+        count = 0;
+    }
+
+    for (uint8_t id = 0; id < NUM_SETTINGS; id++)
+    {
+        SettingDef def;
+        getSettingDef(id, &def);
+
+        uint16_t value = def.default_value;
+        if (id < count)
+        {
+            uint16_t stored = payload[1 + 2 * id] | ((uint16_t)payload[2 + 2 * id] << 8);
+            if (isSettingValid(id, stored))
+            {
+                value = stored;
+            }
+        }
+        setting_values[id] = value;
+    }
+
+    applySettings();
+}
+
+void saveSettings(void)
+{
+    uint8_t payload[SETTINGS_PAYLOAD_SIZE(NUM_SETTINGS)];
+
+    payload[0] = NUM_SETTINGS;
+    for (uint8_t id = 0; id < NUM_SETTINGS; id++)
+    {
+        payload[1 + 2 * id] = setting_values[id] & 0xFF;
+        payload[2 + 2 * id] = setting_values[id] >> 8;
+    }
+
+    writeRecordAt(SETTINGS_RECORD_ADDRESS, RECORD_SETTINGS, payload, sizeof(payload));
+}
+
+bool setSetting(uint8_t id, uint16_t value)
+{
+    if (id >= NUM_SETTINGS || !isSettingValid(id, value))
+    {
+        return false;
+    }
+
+    if (setting_values[id] != value)
+    {
+        setting_values[id] = value;
+        applySettings();
+    }
+    return true;
+}
+
+void applySettings(void)
+{
+    applyThermocoupleType(getSetting(SETTING_THERMOCOUPLE_TYPE));
+    setButtonDebounce(getSetting(SETTING_BUTTON_DEBOUNCE_MS));
+}
+
+int findSetting(const char *key)
+{
+    for (uint8_t id = 0; id < NUM_SETTINGS; id++)
+    {
+        if (strcmp_P(key, setting_defs[id].key) == 0)
+        {
+            return id;
+        }
+    }
+    return -1;
+}
+
+void formatSetting(uint8_t id, char *buffer)
+{
+    SettingDef def;
+    getSettingDef(id, &def);
+
+    switch (def.type)
+    {
+    case SETTING_TYPE_THERMOCOUPLE:
+        buffer[0] = thermocouple_letters[setting_values[id]];
+        buffer[1] = '\0';
+        break;
+    case SETTING_TYPE_C:
+        formatFixed(setting_values[id], 0, 'C', buffer);
+        break;
+    case SETTING_TYPE_S:
+        formatFixed(setting_values[id], 0, 's', buffer);
+        break;
+    case SETTING_TYPE_ON_OFF:
+        strcpy_P(buffer, setting_values[id] ? PSTR("On") : PSTR("Off"));
+        break;
+    case SETTING_TYPE_COUNT:
+        formatFixed(setting_values[id], 0, 0, buffer);
+        break;
+    default:
+    {
+        // "ms" doesn't fit formatFixed's single suffix
+        uint8_t length = formatFixed(setting_values[id], 0, 0, buffer);
+        strcpy_P(buffer + length, PSTR("ms"));
+        break;
+    }
+    }
+}
+
+bool parseSetting(uint8_t id, const char *text)
+{
+    SettingDef def;
+    getSettingDef(id, &def);
+
+    if (def.type == SETTING_TYPE_THERMOCOUPLE && isalpha(text[0]))
+    {
+        const char *letter = strchr(thermocouple_letters, toupper(text[0]));
+        return letter != NULL && text[1] == '\0' && setSetting(id, letter - thermocouple_letters);
+    }
+    if (def.type == SETTING_TYPE_ON_OFF && isalpha(text[0]))
+    {
+        if (strcasecmp_P(text, PSTR("on")) == 0)
+        {
+            return setSetting(id, 1);
+        }
+        return strcasecmp_P(text, PSTR("off")) == 0 && setSetting(id, 0);
+    }
+
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0 || value > 0xFFFF)
+    {
+        return false;
+    }
+    return setSetting(id, value);
+}
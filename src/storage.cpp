@@ -0,0 +1,379 @@
+#include "storage.h"
+#include "eeprom_cache.h"
+
+static_assert(sizeof(PID_Constants) <= RECORD_MAX_PAYLOAD && PACKED_PROFILE_SIZE <= RECORD_MAX_PAYLOAD, "record payload too big");
+
+#define PID_RECORD_ADDRESS (STORE_BASE_ADDRESS + sizeof(StoreHeader))
+#define PROFILE_RECORD_SIZE (sizeof(uint16_t) + PACKED_PROFILE_SIZE)
+#define PROFILE_RECORD_ADDRESS(index) (PID_RECORD_ADDRESS + sizeof(uint16_t) + sizeof(PID_Constants) + (index) * PROFILE_RECORD_SIZE)
+
+uint8_t profile_write_count = 0;
+
+/**
+ * @brief ReflowProfile as layouts 0 and 1 stored it raw, before stage gates were added
+ */
+struct LegacyReflowProfile
+{
+    bool fan_on;
+    int preheat_temp_c;
+    int preheat_time_s;
+    int soak_temp_c;
+    int soak_time_s;
+    int reflow_temp;
+    int reflow_hold_time_s;
+};
+
+// layout 1: same as now, but profile records held a raw LegacyReflowProfile
+#define V1_PROFILE_RECORD_SIZE (sizeof(uint16_t) + sizeof(LegacyReflowProfile))
+#define V1_PROFILE_RECORD_ADDRESS(index) (PID_RECORD_ADDRESS + sizeof(uint16_t) + sizeof(PID_Constants) + (index) * V1_PROFILE_RECORD_SIZE)
+
+// layout 0 (before the store): raw PID_Constants followed by a raw LegacyReflowProfile array
+#define LEGACY_CONSTANTS_ADDRESS DEFAULT_CONSTANTS_ADDRESS
+#define LEGACY_PROFILES_ADDRESS DEFAULT_PROFILES_ADDRESS
+#define LEGACY_NUM_PROFILES 10
+
+uint16_t crc16Update(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+uint16_t crc16(uint16_t crc, const void *data, uint16_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        crc = crc16Update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+static void readBytes(int address, void *data, uint16_t length)
+{
+    eepromCacheRead(address, data, length);
+}
+
+static void writeBytes(int address, const void *data, uint16_t length)
+{
+    // write-behind; only bytes that differ ever reach the EEPROM
+    eepromCacheWrite(address, data, length);
+}
+
+static uint16_t recordCRC(uint8_t record_id, const void *payload, uint16_t length)
+{
+    return crc16(crc16Update(0xFFFF, record_id), payload, length);
+}
+
+static bool readRecord(int address, uint8_t record_id, void *payload, uint16_t length)
+{
+    uint16_t stored_crc;
+    readBytes(address, &stored_crc, sizeof(stored_crc));
+    readBytes(address + sizeof(stored_crc), payload, length);
+
+    return stored_crc == recordCRC(record_id, payload, length);
+}
+
+static void writeRecord(int address, uint8_t record_id, const void *payload, uint16_t length)
+{
+    uint8_t image[sizeof(uint16_t) + RECORD_MAX_PAYLOAD];
+    uint16_t crc = recordCRC(record_id, payload, length);
+
+    // one staged write for the whole record. the cache drains it back to front,
+    // so the CRC lands last and a write cut short leaves a record that fails its check
+    memcpy(image, &crc, sizeof(crc));
+    memcpy(image + sizeof(crc), payload, length);
+    writeBytes(address, image, sizeof(crc) + length);
+}
+
+/**
+ * @brief make sure a record fails its CRC check, whatever garbage its payload holds
+ */
+static void invalidateRecord(int address, uint8_t record_id, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+    crc = crc16Update(crc, record_id);
+    for (uint16_t i = 0; i < length; i++)
+    {
+        uint8_t data;
+        readBytes(address + sizeof(crc) + i, &data, 1);
+        crc = crc16Update(crc, data);
+    }
+
+    crc = ~crc;
+    writeBytes(address, &crc, sizeof(crc));
+}
+
+static void invalidateProfileRecords(int first, int last)
+{
+    for (int i = first; i < last; i++)
+    {
+        invalidateRecord(PROFILE_RECORD_ADDRESS(i), RECORD_PROFILE(i), PACKED_PROFILE_SIZE);
+    }
+}
+
+static void invalidateAllRecords(void)
+{
+    invalidateRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, sizeof(PID_Constants));
+    invalidateProfileRecords(0, NUM_REFLOW_PROFILES);
+}
+
+static void writePackedProfileRecord(uint8_t index, ReflowProfile *ptr_profile)
+{
+    uint8_t packed[PACKED_PROFILE_SIZE];
+    packProfile(ptr_profile, packed);
+    writeRecord(PROFILE_RECORD_ADDRESS(index), RECORD_PROFILE(index), packed, sizeof(packed));
+}
+
+/**
+ * @brief bring a raw legacy profile up to the current struct; stages are time gated like they were
+ */
+static void convertLegacyProfile(const LegacyReflowProfile *ptr_legacy, ReflowProfile *ptr_profile)
+{
+    ptr_profile->fan_on = ptr_legacy->fan_on;
+    ptr_profile->preheat_temp_c = ptr_legacy->preheat_temp_c;
+    ptr_profile->preheat_time_s = ptr_legacy->preheat_time_s;
+    ptr_profile->soak_temp_c = ptr_legacy->soak_temp_c;
+    ptr_profile->soak_time_s = ptr_legacy->soak_time_s;
+    ptr_profile->reflow_temp = ptr_legacy->reflow_temp;
+    ptr_profile->reflow_hold_time_s = ptr_legacy->reflow_hold_time_s;
+    ptr_profile->preheat_gate = GATE_TIME;
+    ptr_profile->soak_gate = GATE_TIME;
+    ptr_profile->reflow_gate = GATE_TIME;
+}
+
+static void writeHeader(void)
+{
+    StoreHeader header;
+    header.magic = STORE_MAGIC;
+    header.version = STORE_LAYOUT_VERSION;
+    header.num_profiles = NUM_REFLOW_PROFILES;
+    writeBytes(STORE_BASE_ADDRESS, &header, sizeof(header));
+}
+
+/**
+ * @brief convert the pre-store layout. only data that passes validation is kept.
+ *
+ * The new records overlap their legacy counterparts, so everything is read (and packed)
+ * before anything is written.
+ */
+static void migrateFromLegacy(void)
+{
+    PID_Constants constants;
+    readBytes(LEGACY_CONSTANTS_ADDRESS, &constants, sizeof(constants));
+    bool constants_valid = is_PID_constants_valid(&constants);
+
+    uint8_t packed[LEGACY_NUM_PROFILES][PACKED_PROFILE_SIZE];
+    uint16_t valid = 0;
+    for (int i = 0; i < LEGACY_NUM_PROFILES; i++)
+    {
+        LegacyReflowProfile legacy;
+        readBytes(LEGACY_PROFILES_ADDRESS + i * sizeof(LegacyReflowProfile), &legacy, sizeof(legacy));
+
+        ReflowProfile profile;
+        convertLegacyProfile(&legacy, &profile);
+        if (isProfileValid(&profile))
+        {
+            packProfile(&profile, packed[i]);
+            valid |= 1 << i;
+        }
+    }
+
+    if (constants_valid)
+    {
+        writeRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, &constants, sizeof(constants));
+    }
+    else
+    {
+        invalidateRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, sizeof(PID_Constants));
+    }
+
+    for (int i = 0; i < LEGACY_NUM_PROFILES && i < NUM_REFLOW_PROFILES; i++)
+    {
+        if (valid & (1 << i))
+        {
+            writeRecord(PROFILE_RECORD_ADDRESS(i), RECORD_PROFILE(i), packed[i], PACKED_PROFILE_SIZE);
+        }
+        else
+        {
+            // caller puts a default in
+            invalidateRecord(PROFILE_RECORD_ADDRESS(i), RECORD_PROFILE(i), PACKED_PROFILE_SIZE);
+        }
+    }
+    invalidateProfileRecords(LEGACY_NUM_PROFILES, NUM_REFLOW_PROFILES);
+}
+
+/**
+ * @brief repack layout 1 profile records (raw LegacyReflowProfile) in place.
+ *
+ * Packed records are smaller, so each one lands at or before the record it came from
+ * and going first-to-last never overwrites a record that hasn't been read yet.
+ */
+static void migrateV1Profiles(uint8_t num_profiles)
+{
+    for (int i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        LegacyReflowProfile legacy;
+        if (i < num_profiles && readRecord(V1_PROFILE_RECORD_ADDRESS(i), RECORD_PROFILE(i), &legacy, sizeof(legacy)))
+        {
+            ReflowProfile profile;
+            convertLegacyProfile(&legacy, &profile);
+            writePackedProfileRecord(i, &profile);
+        }
+        else
+        {
+            invalidateRecord(PROFILE_RECORD_ADDRESS(i), RECORD_PROFILE(i), PACKED_PROFILE_SIZE);
+        }
+    }
+}
+
+/**
+ * @brief layout 3: the PID's D term only started working with this layout, so a stored D gain was never
+ * tried on the oven. start it from the default rather than let an untested value take effect
+ */
+static void resetDerivativeGain(void)
+{
+    PID_Constants constants;
+    if (readRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, &constants, sizeof(constants)))
+    {
+        constants.PID_d = DEFAULT_PID_D;
+        writeRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, &constants, sizeof(constants));
+    }
+}
+
+/**
+ * @brief bring a store of an older layout version up to date, one version at a time
+ *
+ * @param from_version layout version found in the header. 0: no store
+ * @param num_profiles profile slot count found in the header
+ * @return true: migrated
+ * @return false: version unknown (newer firmware wrote it); caller formats
+ */
+static bool migrateStore(uint8_t from_version, uint8_t num_profiles)
+{
+    switch (from_version)
+    {
+    case 0:
+        // straight to layout 2
+        migrateFromLegacy();
+        resetDerivativeGain();
+        break;
+    case 1:
+        migrateV1Profiles(num_profiles);
+        // fall through
+    case 2:
+        resetDerivativeGain();
+        break;
+    default:
+        return false;
+    }
+
+    writeHeader();
+    return true;
+}
+
+uint8_t beginStore(void)
+{
+    StoreHeader header;
+    readBytes(STORE_BASE_ADDRESS, &header, sizeof(header));
+
+    if (header.magic == STORE_MAGIC && header.version == STORE_LAYOUT_VERSION && header.num_profiles == NUM_REFLOW_PROFILES)
+    {
+        return STORE_OK;
+    }
+
+    if (header.magic == STORE_MAGIC && header.version == STORE_LAYOUT_VERSION)
+    {
+        // only the slot count changed. existing slots stay where they are; new ones start empty
+        if (header.num_profiles < NUM_REFLOW_PROFILES)
+        {
+            invalidateProfileRecords(header.num_profiles, NUM_REFLOW_PROFILES);
+        }
+        writeHeader();
+        return STORE_MIGRATED;
+    }
+
+    // no magic: written by the firmware from before the store existed
+    uint8_t from_version = header.magic == STORE_MAGIC ? header.version : 0;
+
+    if (from_version < STORE_LAYOUT_VERSION && migrateStore(from_version, header.num_profiles))
+    {
+        return STORE_MIGRATED;
+    }
+
+    // unknown layout. every record gets a default
+    invalidateAllRecords();
+    writeHeader();
+    return STORE_FORMATTED;
+}
+
+bool readRecordAt(uint16_t address, uint8_t record_id, void *payload, uint16_t length)
+{
+    if (length > RECORD_MAX_PAYLOAD)
+    {
+        return false;
+    }
+    return readRecord(address, record_id, payload, length);
+}
+
+void writeRecordAt(uint16_t address, uint8_t record_id, const void *payload, uint16_t length)
+{
+    if (length > RECORD_MAX_PAYLOAD)
+    {
+        return;
+    }
+    writeRecord(address, record_id, payload, length);
+}
+
+bool readPIDConstantsRecord(PID_Constants *ptr_constants)
+{
+    return readRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, ptr_constants, sizeof(PID_Constants));
+}
+
+void writePIDConstantsRecord(PID_Constants *ptr_constants)
+{
+    writeRecord(PID_RECORD_ADDRESS, RECORD_PID_CONSTANTS, ptr_constants, sizeof(PID_Constants));
+}
+
+bool readProfileRecord(uint8_t index, ReflowProfile *ptr_profile)
+{
+    if (index >= NUM_REFLOW_PROFILES)
+    {
+        return false;
+    }
+
+    uint8_t packed[PACKED_PROFILE_SIZE];
+    if (!readRecord(PROFILE_RECORD_ADDRESS(index), RECORD_PROFILE(index), packed, sizeof(packed)))
+    {
+        return false;
+    }
+
+    unpackProfile(packed, ptr_profile);
+    return true;
+}
+
+bool loadProfile(uint8_t index, ReflowProfile *ptr_profile)
+{
+    if (readProfileRecord(index, ptr_profile))
+    {
+        return true;
+    }
+
+    *ptr_profile = default_reflow_profile;
+    return false;
+}
+
+bool writeProfileRecord(uint8_t index, ReflowProfile *ptr_profile)
+{
+    if (index >= NUM_REFLOW_PROFILES)
+    {
+        return false;
+    }
+
+    writePackedProfileRecord(index, ptr_profile);
+    profile_write_count++;
+    return true;
+}
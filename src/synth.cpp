@@ -0,0 +1,140 @@
+#include "synth.h"
+
+/**
+ * @brief append a segment; gates get no band or timeout here, the caller fills those in for its controller
+ */
+static void addSegment(SegmentProfile *ptr_segments, uint8_t type, int16_t target_c, uint16_t value, uint8_t gate, bool fan_on)
+{
+    ProfileSegment *ptr_segment = &ptr_segments->segments[ptr_segments->num_segments++];
+    ptr_segment->type = type;
+    ptr_segment->fan_on = fan_on;
+    ptr_segment->target_c = target_c;
+    ptr_segment->value = value;
+    ptr_segment->gate = gate;
+    ptr_segment->band_c = 0;
+    ptr_segment->timeout_s = 0;
+    ptr_segment->abort_on_timeout = false;
+}
+
+/**
+ * @brief seconds a ramp of rate (0.1 C/s) takes over span_c; rounded up like compileRunPlan()
+ */
+static uint32_t rampSeconds(int32_t span_c, uint16_t rate)
+{
+    if (span_c < 0)
+    {
+        span_c = -span_c;
+    }
+    return ((uint32_t)span_c * 10 + rate - 1) / rate;
+}
+
+void defaultPasteWindow(PasteWindow *ptr_window)
+{
+    ptr_window->max_ramp = SYNTH_DEFAULT_RAMP;
+    ptr_window->max_cool = SYNTH_DEFAULT_COOL;
+    ptr_window->soak_min_c = 150;
+    ptr_window->soak_max_c = 200;
+    ptr_window->soak_min_s = 60;
+    ptr_window->soak_max_s = 120;
+    ptr_window->liquidus_c = 217;
+    ptr_window->tal_min_s = 45;
+    ptr_window->tal_max_s = 90;
+    ptr_window->peak_min_c = 235;
+    ptr_window->peak_max_c = 250;
+}
+
+uint8_t synthesizeProfile(const PasteWindow *ptr_window, const OvenRates *ptr_oven, int16_t start_c, int16_t end_c, bool fan_on,
+                          SegmentProfile *ptr_segments, SynthReport *ptr_report)
+{
+    const PasteWindow *w = ptr_window;
+
+    if (w->soak_min_c > w->soak_max_c || w->soak_min_s > w->soak_max_s || w->tal_min_s > w->tal_max_s || w->peak_min_c > w->peak_max_c ||
+        start_c >= w->soak_min_c || w->soak_max_c >= w->liquidus_c || w->liquidus_c >= w->peak_min_c || end_c >= w->liquidus_c)
+    {
+        return SYNTH_BAD_WINDOW;
+    }
+    if (w->max_ramp == 0 || ptr_oven->heat == 0 || ptr_oven->cool == 0)
+    {
+        return SYNTH_NO_RATE;
+    }
+
+    // as fast as both the paste and the oven allow
+    uint16_t ramp = w->max_ramp < ptr_oven->heat ? w->max_ramp : ptr_oven->heat;
+    bool cool_limited = w->max_cool > 0 && w->max_cool < ptr_oven->cool;
+    uint16_t cool = cool_limited ? w->max_cool : ptr_oven->cool;
+
+    // soak: middle of the time window, but no steeper than the oven can follow
+    int16_t soak_span = w->soak_max_c - w->soak_min_c;
+    uint32_t soak_s = ((uint32_t)w->soak_min_s + w->soak_max_s) / 2;
+    uint32_t fastest_soak_s = rampSeconds(soak_span, ramp);
+    if (fastest_soak_s > w->soak_max_s)
+    {
+        return SYNTH_SOAK_SLOW;
+    }
+    if (soak_s < fastest_soak_s)
+    {
+        soak_s = fastest_soak_s;
+    }
+    uint16_t soak_rate = 0;
+    if (soak_span > 0)
+    {
+        // nearest whole 0.1 C/s, then the time that rate really takes
+        soak_rate = ((uint32_t)soak_span * 10 + soak_s / 2) / soak_s;
+        if (soak_rate == 0)
+        {
+            soak_rate = 1;
+        }
+        if (soak_rate > ramp)
+        {
+            soak_rate = ramp;
+        }
+        soak_s = rampSeconds(soak_span, soak_rate);
+    }
+
+    // time above liquidus: rise, hold, fall. bring the peak down if rise and fall alone overshoot the middle TAL
+    uint32_t tal_s = ((uint32_t)w->tal_min_s + w->tal_max_s) / 2;
+    int16_t peak_c = (w->peak_min_c + w->peak_max_c) / 2;
+    while (peak_c > w->peak_min_c && rampSeconds(peak_c - w->liquidus_c, ramp) + rampSeconds(peak_c - w->liquidus_c, cool) > tal_s)
+    {
+        peak_c--;
+    }
+    uint32_t rise_fall_s = rampSeconds(peak_c - w->liquidus_c, ramp) + rampSeconds(peak_c - w->liquidus_c, cool);
+    if (rise_fall_s > w->tal_max_s)
+    {
+        return SYNTH_TAL_LONG;
+    }
+    uint32_t hold_s = rise_fall_s < tal_s ? tal_s - rise_fall_s : 0;
+
+    ptr_segments->num_segments = 0;
+    addSegment(ptr_segments, SEGMENT_RAMP, w->soak_min_c, ramp, GATE_TIME_AND_TEMP, fan_on);
+    if (soak_span > 0)
+    {
+        addSegment(ptr_segments, SEGMENT_RAMP, w->soak_max_c, soak_rate, GATE_TIME, fan_on);
+    }
+    else
+    {
+        addSegment(ptr_segments, SEGMENT_HOLD, w->soak_max_c, soak_s, GATE_TIME, fan_on);
+    }
+    addSegment(ptr_segments, SEGMENT_RAMP, peak_c, ramp, GATE_TIME_AND_TEMP, fan_on);
+    addSegment(ptr_segments, SEGMENT_HOLD, peak_c, hold_s, GATE_TIME, fan_on);
+
+    uint32_t cool_s = rampSeconds(peak_c - end_c, cool);
+    if (cool_limited)
+    {
+        // heater off would drop faster than the paste allows; walk the setpoint down instead
+        addSegment(ptr_segments, SEGMENT_RAMP, end_c, cool, GATE_TIME, fan_on);
+    }
+    else
+    {
+        addSegment(ptr_segments, SEGMENT_COOLDOWN, end_c, 0, GATE_TIME, fan_on);
+    }
+
+    ptr_report->ramp = ramp;
+    ptr_report->cool = cool;
+    ptr_report->peak_c = peak_c;
+    ptr_report->soak_s = soak_s;
+    ptr_report->hold_s = hold_s;
+    ptr_report->tal_s = rise_fall_s + hold_s;
+    ptr_report->total_s = rampSeconds(w->soak_min_c - start_c, ramp) + soak_s + rampSeconds(peak_c - w->soak_max_c, ramp) + hold_s + cool_s;
+    return SYNTH_OK;
+}
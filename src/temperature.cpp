@@ -1,31 +1,27 @@
 #include "temperature.h"
+#include "settings.h"
 #include <Arduino.h>
 
 // MAX6675 thermocouple(THERMO_CLK, THERMO_CS, THERMO_DO);
 // Adafruit_MAX31856 thermocouple(THERMO_CS, 31, THERMO_DO, THERMO_CLK);
 Adafruit_MAX31856 thermocouple(THERMO_CS);
-unsigned long last_time_ran = 0;
 double last_temp = 0.0f;
+static bool thermocouple_started = false;
 
-bool getTemperature(double *temp)
-{
-    Serial.println("Going to read temperature");
-    Serial.println("Checking MIN_TIME_BETWEEN_THERMO_READ");
-
-    if (millis() - last_time_ran < MIN_TIME_BETWEEN_THERMO_READ)
-    {
-        Serial.println("Too soon between temp readings, passing.");
-        *temp = last_temp;
-        return true;
-    }
+// conversion in progress, and when it (or the last one) was started
+static bool converting = false;
+static unsigned long conversion_start_ms = 0;
+// when the next reading should be ready
+static unsigned long read_due_ms = 0;
 
+/**
+ * @brief read out a finished conversion. false, with the faults printed, when it isn't a plausible temperature
+ */
+static bool readConversion(double *temp)
+{
     double temp_temp;
     // double temp_temp = 0.0f;
-    Serial.print("Taking temp reading now.");
-
     temp_temp = thermocouple.readThermocoupleTemperature();
-    Serial.print("Temp read is: ");
-    Serial.println(temp_temp);
     if (isnan(temp_temp) || temp_temp <= 1.0 || temp_temp > 1000)
     {
         Serial.println("PROBABLY failed to read temp.");
@@ -53,18 +49,71 @@ bool getTemperature(double *temp)
                 Serial.println("Thermocouple Open Fault");
         }
 
-        last_time_ran = millis();
         return false;
     }
-    Serial.println("Supposedly successful temp read.");
-
     *temp = temp_temp;
     last_temp = temp_temp;
-    last_time_ran = millis();
 
     return true;
 }
 
+static void startConversion(void)
+{
+    thermocouple.triggerOneShot();
+    converting = true;
+    conversion_start_ms = millis();
+    // nobody asked for the one after; it comes at the idle rate unless a PID tick wants it sooner
+    read_due_ms = conversion_start_ms + THERMO_CONVERSION_MS + THERMO_IDLE_READ_MS;
+}
+
+bool getTemperature(double *temp)
+{
+    startConversion();
+    while (!thermocouple.conversionComplete())
+    {
+        if (millis() - conversion_start_ms >= THERMO_CONVERSION_TIMEOUT_MS)
+        {
+            converting = false;
+            return false;
+        }
+    }
+    converting = false;
+
+    return readConversion(temp);
+}
+
+bool serviceTemperature(double *temp)
+{
+    if (converting)
+    {
+        if (thermocouple.conversionComplete())
+        {
+            converting = false;
+            return readConversion(temp);
+        }
+        if (millis() - conversion_start_ms >= THERMO_CONVERSION_TIMEOUT_MS)
+        {
+            // start over on the next pass
+            Serial.println("Thermocouple conversion timed out.");
+            converting = false;
+        }
+        return false;
+    }
+
+    // start early enough to be done by read_due_ms, but no more often than SETTING_THERMO_READ_MS
+    unsigned long now = millis();
+    if ((long)(now + THERMO_CONVERSION_MS - read_due_ms) >= 0 && now - conversion_start_ms >= getSetting(SETTING_THERMO_READ_MS))
+    {
+        startConversion();
+    }
+    return false;
+}
+
+void scheduleTemperature(unsigned long due_ms)
+{
+    read_due_ms = due_ms;
+}
+
 bool initializeTemperature()
 {
     if (!thermocouple.begin())
@@ -73,7 +122,10 @@ bool initializeTemperature()
         return false;
     }
 
-    thermocouple.setThermocoupleType(MAX31856_TCTYPE_K);
+    thermocouple_started = true;
+    thermocouple.setThermocoupleType((max31856_thermocoupletype_t)getSetting(SETTING_THERMOCOUPLE_TYPE));
+    // conversions are started and collected by serviceTemperature(); the library mustn't wait for them
+    thermocouple.setConversionMode(MAX31856_ONESHOT_NOWAIT);
 
     Serial.print("Thermocouple type: ");
     switch (thermocouple.getThermocoupleType())
@@ -113,4 +165,13 @@ bool initializeTemperature()
         break;
     }
     return true;
-}
\ No newline at end of file
+}
+
+void applyThermocoupleType(uint8_t type)
+{
+    // before initializeTemperature() the SPI bus isn't set up; it picks the setting up itself
+    if (thermocouple_started && thermocouple.getThermocoupleType() != type)
+    {
+        thermocouple.setThermocoupleType((max31856_thermocoupletype_t)type);
+    }
+}
@@ -0,0 +1,332 @@
+#include "trace.h"
+#include "storage.h"
+#include "eeprom_cache.h"
+#include "paste_library.h"
+
+#define TRACE_SLOT_ADDRESS(slot) (TRACE_BASE_ADDRESS + (slot) * TRACE_SLOT_SIZE)
+#define TRACE_DATA_ADDRESS(slot) (TRACE_SLOT_ADDRESS(slot) + sizeof(TraceHeader))
+#define TRACE_DATA_CAPACITY (TRACE_SLOT_SIZE - sizeof(TraceHeader))
+
+#define TRACE_SHORT_MIN_DELTA -32
+#define TRACE_SHORT_MAX_DELTA 31
+#define TRACE_LONG_FORM 0x40
+#define TRACE_HEATER_ON 0x80
+
+static_assert(TRACE_BASE_ADDRESS >= STORE_END_ADDRESS, "trace slots overlap the record store");
+
+/**
+ * @brief trace being recorded. only valid while recording is true
+ */
+static bool recording = false;
+static uint8_t trace_slot;
+static TraceHeader trace_header;
+static uint16_t data_crc; // crc of the samples written so far
+static uint8_t samples_since_checkpoint;
+
+// previous sample. the next one is stored as a delta from it
+static uint32_t last_time;
+static int16_t last_temp;
+static int16_t last_target;
+
+static uint16_t headerCRC(TraceHeader *ptr_header, uint16_t samples_crc)
+{
+    return crc16(samples_crc, (const uint8_t *)ptr_header + sizeof(ptr_header->crc), sizeof(TraceHeader) - sizeof(ptr_header->crc));
+}
+
+static void writeTraceHeader(void)
+{
+    trace_header.crc = headerCRC(&trace_header, data_crc);
+    // staged after the samples it covers, so it reaches the EEPROM after them
+    eepromCacheWrite(TRACE_SLOT_ADDRESS(trace_slot), &trace_header, sizeof(trace_header));
+    samples_since_checkpoint = 0;
+}
+
+/**
+ * @brief read a slot's header and check it against the samples
+ *
+ * @return true: header and samples intact
+ */
+static bool readTraceHeader(uint8_t slot, TraceHeader *ptr_header)
+{
+    eepromCacheRead(TRACE_SLOT_ADDRESS(slot), ptr_header, sizeof(TraceHeader));
+    if (ptr_header->length > TRACE_DATA_CAPACITY)
+    {
+        return false;
+    }
+
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < ptr_header->length; i++)
+    {
+        uint8_t data;
+        eepromCacheRead(TRACE_DATA_ADDRESS(slot) + i, &data, 1);
+        crc = crc16Update(crc, data);
+    }
+
+    return ptr_header->crc == headerCRC(ptr_header, crc);
+}
+
+static uint8_t putVarint(uint8_t *buffer, uint32_t value)
+{
+    uint8_t length = 0;
+    while (value >= 0x80)
+    {
+        buffer[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buffer[length++] = value;
+    return length;
+}
+
+static uint32_t getVarint(uint16_t *ptr_address)
+{
+    uint32_t value = 0;
+    uint8_t data;
+    uint8_t shift = 0;
+    do
+    {
+        eepromCacheRead((*ptr_address)++, &data, 1);
+        value |= (uint32_t)(data & 0x7F) << shift;
+        shift += 7;
+    } while ((data & 0x80) && shift < 32);
+    return value;
+}
+
+/**
+ * @brief map signed to unsigned so small negative deltas stay small varints: 0, -1, 1, -2 -> 0, 1, 2, 3
+ */
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+void beginTrace(uint32_t start_time, uint8_t profile_index)
+{
+    endTrace();
+
+    // reuse an empty or corrupt slot, otherwise the one holding the oldest run
+    bool found_empty = false;
+    bool found_any = false;
+    uint16_t newest_run = 0;
+    uint16_t oldest_run = 0;
+    trace_slot = 0;
+
+    for (uint8_t slot = 0; slot < TRACE_NUM_SLOTS; slot++)
+    {
+        TraceHeader header;
+        if (!readTraceHeader(slot, &header))
+        {
+            if (!found_empty)
+            {
+                found_empty = true;
+                trace_slot = slot;
+            }
+            continue;
+        }
+
+        // run numbers wrap; compare by difference
+        if (!found_any || (int16_t)(header.run_number - newest_run) > 0)
+        {
+            newest_run = header.run_number;
+        }
+        if (!found_empty && (!found_any || (int16_t)(header.run_number - oldest_run) < 0))
+        {
+            oldest_run = header.run_number;
+            trace_slot = slot;
+        }
+        found_any = true;
+    }
+
+    memset(&trace_header, 0, sizeof(trace_header));
+    trace_header.run_number = found_any ? newest_run + 1 : 0;
+    trace_header.start_time = start_time;
+    trace_header.profile_index = profile_index;
+
+    data_crc = 0xFFFF;
+    recording = true;
+    writeTraceHeader();
+}
+
+void recordTraceSample(uint32_t now, double temp_c, double target_c, bool heater_on)
+{
+    if (!recording || (trace_header.flags & TRACE_FLAG_TRUNCATED))
+    {
+        return;
+    }
+    // signed, so a clock stepped backwards just holds off sampling until it catches up
+    if (trace_header.num_samples > 0 && (int32_t)(now - last_time) < TRACE_SAMPLE_PERIOD_S)
+    {
+        return;
+    }
+
+    int16_t temp = (int16_t)lround(temp_c * 4);
+    int16_t target = (int16_t)lround(target_c);
+
+    if (trace_header.num_samples == 0)
+    {
+        // the first sample is a delta from these
+        trace_header.start_temp = temp;
+        trace_header.start_target = target;
+        last_time = trace_header.start_time;
+        last_temp = temp;
+        last_target = target;
+    }
+
+    uint8_t sample[TRACE_MAX_SAMPLE_BYTES];
+    uint8_t length = 0;
+    uint32_t time_delta = (int32_t)(now - last_time) > 0 ? min(now - last_time, (uint32_t)0xFFFF) : 0;
+    int32_t temp_delta = (int32_t)temp - last_temp;
+    int32_t target_delta = (int32_t)target - last_target;
+
+    sample[0] = heater_on ? TRACE_HEATER_ON : 0;
+    if (time_delta == 1 && target_delta == 0 && temp_delta >= TRACE_SHORT_MIN_DELTA && temp_delta <= TRACE_SHORT_MAX_DELTA)
+    {
+        sample[length++] |= temp_delta & 0x3F;
+    }
+    else
+    {
+        sample[length++] |= TRACE_LONG_FORM;
+        length += putVarint(sample + length, time_delta);
+        length += putVarint(sample + length, zigzag(temp_delta));
+        length += putVarint(sample + length, zigzag(target_delta));
+    }
+
+    if (trace_header.length + length > TRACE_DATA_CAPACITY)
+    {
+        trace_header.flags |= TRACE_FLAG_TRUNCATED;
+        writeTraceHeader();
+        return;
+    }
+
+    eepromCacheWrite(TRACE_DATA_ADDRESS(trace_slot) + trace_header.length, sample, length);
+    data_crc = crc16(data_crc, sample, length);
+    trace_header.length += length;
+    trace_header.num_samples++;
+
+    last_time = now;
+    last_temp = temp;
+    last_target = target;
+
+    if (++samples_since_checkpoint >= TRACE_CHECKPOINT_SAMPLES)
+    {
+        writeTraceHeader();
+    }
+}
+
+void endTrace(void)
+{
+    if (!recording)
+    {
+        return;
+    }
+
+    trace_header.flags |= TRACE_FLAG_ENDED;
+    writeTraceHeader();
+    recording = false;
+}
+
+bool isTraceRecording(void)
+{
+    return recording;
+}
+
+static void printTrace(uint8_t slot, TraceHeader *ptr_header)
+{
+    Serial.print(F("# run "));
+    Serial.print(ptr_header->run_number);
+    Serial.print(F(", profile "));
+    if (isLibraryProfile(ptr_header->profile_index) && ptr_header->profile_index < LIBRARY_PROFILE_INDEX + NUM_LIBRARY_PROFILES)
+    {
+        char name[STR_LEN];
+        getLibraryProfileName(ptr_header->profile_index - LIBRARY_PROFILE_INDEX, name);
+        Serial.print(name);
+    }
+    else
+    {
+        Serial.print(ptr_header->profile_index + 1);
+    }
+    Serial.print(F(", start "));
+    Serial.print(ptr_header->start_time);
+    Serial.print(F(", "));
+    Serial.print(ptr_header->num_samples);
+    Serial.print(F(" samples, "));
+    Serial.print(ptr_header->length);
+    Serial.print(F(" bytes"));
+    if (!(ptr_header->flags & TRACE_FLAG_ENDED))
+    {
+        Serial.print(F(", power lost"));
+    }
+    if (ptr_header->flags & TRACE_FLAG_TRUNCATED)
+    {
+        Serial.print(F(", truncated"));
+    }
+    Serial.println();
+    Serial.println(F("t_s,temp_c,target_c,heater"));
+
+    uint16_t address = TRACE_DATA_ADDRESS(slot);
+    uint32_t elapsed = 0;
+    int32_t temp = ptr_header->start_temp;
+    int32_t target = ptr_header->start_target;
+
+    for (uint16_t i = 0; i < ptr_header->num_samples; i++)
+    {
+        uint8_t data;
+        eepromCacheRead(address++, &data, 1);
+
+        if (data & TRACE_LONG_FORM)
+        {
+            elapsed += getVarint(&address);
+            temp += unzigzag(getVarint(&address));
+            target += unzigzag(getVarint(&address));
+        }
+        else
+        {
+            elapsed++;
+            temp += (int8_t)(data << 2) >> 2; // sign extend the 6 bit delta
+        }
+
+        Serial.print(elapsed);
+        Serial.print(',');
+        Serial.print(temp / 4.0f, 2);
+        Serial.print(',');
+        Serial.print(target);
+        Serial.print(',');
+        Serial.println((data & TRACE_HEATER_ON) ? 1 : 0);
+    }
+}
+
+uint8_t dumpTraces(long run_number)
+{
+    TraceHeader headers[TRACE_NUM_SLOTS];
+    bool valid[TRACE_NUM_SLOTS];
+    for (uint8_t slot = 0; slot < TRACE_NUM_SLOTS; slot++)
+    {
+        valid[slot] = readTraceHeader(slot, &headers[slot]) && (run_number < 0 || headers[slot].run_number == run_number);
+    }
+
+    // oldest run first
+    uint8_t printed = 0;
+    while (true)
+    {
+        int oldest = -1;
+        for (uint8_t slot = 0; slot < TRACE_NUM_SLOTS; slot++)
+        {
+            if (valid[slot] && (oldest < 0 || (int16_t)(headers[slot].run_number - headers[oldest].run_number) < 0))
+            {
+                oldest = slot;
+            }
+        }
+        if (oldest < 0)
+        {
+            return printed;
+        }
+
+        printTrace(oldest, &headers[oldest]);
+        valid[oldest] = false;
+        printed++;
+    }
+}
@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "reflow.h"
+
+#define PACKED_TEMP_MAX ((1 << PACKED_TEMP_BITS) - 1)
+#define PACKED_TIME_MAX ((1 << PACKED_TIME_BITS) - 1)
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief every field at its minimum
+ */
+static void minProfile(ReflowProfile *ptr_profile)
+{
+    ptr_profile->fan_on = false;
+    ptr_profile->preheat_temp_c = 0;
+    ptr_profile->preheat_time_s = 0;
+    ptr_profile->soak_temp_c = 0;
+    ptr_profile->soak_time_s = 0;
+    ptr_profile->reflow_temp = 0;
+    ptr_profile->reflow_hold_time_s = 0;
+    ptr_profile->preheat_gate = GATE_TIME;
+    ptr_profile->soak_gate = GATE_TIME;
+    ptr_profile->reflow_gate = GATE_TIME;
+}
+
+/**
+ * @brief every field at the most its bits hold
+ */
+static void maxProfile(ReflowProfile *ptr_profile)
+{
+    ptr_profile->fan_on = true;
+    ptr_profile->preheat_temp_c = PACKED_TEMP_MAX;
+    ptr_profile->preheat_time_s = PACKED_TIME_MAX;
+    ptr_profile->soak_temp_c = PACKED_TEMP_MAX;
+    ptr_profile->soak_time_s = PACKED_TIME_MAX;
+    ptr_profile->reflow_temp = PACKED_TEMP_MAX;
+    ptr_profile->reflow_hold_time_s = PACKED_TIME_MAX;
+    ptr_profile->preheat_gate = GATE_TIME_AND_TEMP;
+    ptr_profile->soak_gate = GATE_TIME_AND_TEMP;
+    ptr_profile->reflow_gate = GATE_TIME_AND_TEMP;
+}
+
+static void assertProfilesEqual(const ReflowProfile *ptr_expected, const ReflowProfile *ptr_actual)
+{
+    TEST_ASSERT_EQUAL(ptr_expected->fan_on, ptr_actual->fan_on);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->preheat_temp_c, ptr_actual->preheat_temp_c);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->preheat_time_s, ptr_actual->preheat_time_s);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->soak_temp_c, ptr_actual->soak_temp_c);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->soak_time_s, ptr_actual->soak_time_s);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->reflow_temp, ptr_actual->reflow_temp);
+    TEST_ASSERT_EQUAL_INT(ptr_expected->reflow_hold_time_s, ptr_actual->reflow_hold_time_s);
+    TEST_ASSERT_EQUAL_UINT8(ptr_expected->preheat_gate, ptr_actual->preheat_gate);
+    TEST_ASSERT_EQUAL_UINT8(ptr_expected->soak_gate, ptr_actual->soak_gate);
+    TEST_ASSERT_EQUAL_UINT8(ptr_expected->reflow_gate, ptr_actual->reflow_gate);
+}
+
+static void assertRoundTrip(ReflowProfile *ptr_profile)
+{
+    uint8_t packed[PACKED_PROFILE_SIZE];
+    ReflowProfile unpacked;
+
+    packProfile(ptr_profile, packed);
+    unpackProfile(packed, &unpacked);
+    assertProfilesEqual(ptr_profile, &unpacked);
+}
+
+void test_all_min(void)
+{
+    ReflowProfile profile;
+    minProfile(&profile);
+    assertRoundTrip(&profile);
+}
+
+void test_all_max(void)
+{
+    ReflowProfile profile;
+    maxProfile(&profile);
+    assertRoundTrip(&profile);
+}
+
+/**
+ * @brief each field on its own at min among maxed neighbours, then at max among zeroed ones, so a field
+ * spilling into the next one shows up
+ */
+void test_each_field_alone(void)
+{
+    for (uint8_t field = 0; field < 10; field++)
+    {
+        for (uint8_t at_max = 0; at_max < 2; at_max++)
+        {
+            ReflowProfile profile;
+            ReflowProfile other;
+            if (at_max)
+            {
+                minProfile(&profile);
+                maxProfile(&other);
+            }
+            else
+            {
+                maxProfile(&profile);
+                minProfile(&other);
+            }
+
+            switch (field)
+            {
+            case 0:
+                profile.fan_on = other.fan_on;
+                break;
+            case 1:
+                profile.preheat_temp_c = other.preheat_temp_c;
+                break;
+            case 2:
+                profile.preheat_time_s = other.preheat_time_s;
+                break;
+            case 3:
+                profile.soak_temp_c = other.soak_temp_c;
+                break;
+            case 4:
+                profile.soak_time_s = other.soak_time_s;
+                break;
+            case 5:
+                profile.reflow_temp = other.reflow_temp;
+                break;
+            case 6:
+                profile.reflow_hold_time_s = other.reflow_hold_time_s;
+                break;
+            case 7:
+                profile.preheat_gate = other.preheat_gate;
+                break;
+            case 8:
+                profile.soak_gate = other.soak_gate;
+                break;
+            case 9:
+                profile.reflow_gate = other.reflow_gate;
+                break;
+            }
+            assertRoundTrip(&profile);
+        }
+    }
+}
+
+void test_every_gate_value(void)
+{
+    for (uint8_t gate = 0; gate < NUM_GATES; gate++)
+    {
+        ReflowProfile profile;
+        minProfile(&profile);
+        profile.preheat_gate = gate;
+        profile.soak_gate = (gate + 1) % NUM_GATES;
+        profile.reflow_gate = (gate + 2) % NUM_GATES;
+        assertRoundTrip(&profile);
+    }
+}
+
+void test_out_of_range_is_clamped(void)
+{
+    ReflowProfile profile;
+    maxProfile(&profile);
+    profile.preheat_temp_c = PACKED_TEMP_MAX + 1;
+    profile.soak_time_s = PACKED_TIME_MAX + 100;
+    profile.reflow_temp = -5;
+    profile.reflow_gate = NUM_GATES + 1;
+
+    uint8_t packed[PACKED_PROFILE_SIZE];
+    ReflowProfile unpacked;
+    packProfile(&profile, packed);
+    unpackProfile(packed, &unpacked);
+
+    TEST_ASSERT_EQUAL_INT(PACKED_TEMP_MAX, unpacked.preheat_temp_c);
+    TEST_ASSERT_EQUAL_INT(PACKED_TIME_MAX, unpacked.soak_time_s);
+    TEST_ASSERT_EQUAL_INT(0, unpacked.reflow_temp);
+    TEST_ASSERT_EQUAL_UINT8(GATE_TIME_AND_TEMP, unpacked.reflow_gate);
+    // neighbours untouched
+    TEST_ASSERT_EQUAL_INT(PACKED_TIME_MAX, unpacked.preheat_time_s);
+    TEST_ASSERT_EQUAL_INT(PACKED_TIME_MAX, unpacked.reflow_hold_time_s);
+}
+
+void setup()
+{
+    // give the serial monitor time to attach after the reset
+    delay(2000);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_all_min);
+    RUN_TEST(test_all_max);
+    RUN_TEST(test_each_field_alone);
+    RUN_TEST(test_every_gate_value);
+    RUN_TEST(test_out_of_range_is_clamped);
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,134 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "run_plan.h"
+#include "recovery.h"
+#include "journal.h"
+#include "reflow.h"
+
+/*
+Run checkpoints taken mid-step and picked back up with seekRunPlan(). Runs on the board; commits the journal.
+*/
+
+#define HOLD_TARGET_C 200
+#define HOLD_S 60
+#define COLD_C 25
+
+static SegmentProfile profile;
+static RunPlan plan;
+
+/**
+ * @brief one temperature gated hold, waiting forever for the oven
+ */
+void setUp(void)
+{
+    memset(&profile, 0, sizeof(profile));
+    profile.num_segments = 1;
+    profile.segments[0].type = SEGMENT_HOLD;
+    profile.segments[0].target_c = HOLD_TARGET_C;
+    profile.segments[0].value = HOLD_S;
+    profile.segments[0].gate = GATE_TEMP;
+    profile.segments[0].band_c = 5;
+    TEST_ASSERT_EQUAL_UINT8(PLAN_OK, compileRunPlan(&profile, COLD_C, 0, MAX_TEMP_C, &plan));
+}
+
+void tearDown(void)
+{
+    // don't leave a run for the firmware to offer to resume
+    clearRunCheckpoint();
+    commitJournal();
+}
+
+/**
+ * @brief checkpoint a run at now_s and read it back from the journal
+ */
+static void checkpoint(const PlanRun *ptr_run, uint32_t now_s, float temp_c, RunCheckpoint *ptr_checkpoint)
+{
+    saveRunCheckpoint(0, ptr_run, now_s, temp_c);
+    TEST_ASSERT_TRUE(findRunCheckpoint(ptr_checkpoint));
+    TEST_ASSERT_EQUAL_UINT8(0, ptr_checkpoint->profile_index);
+}
+
+void test_short_hold(void)
+{
+    PlanRun run;
+    beginRunPlan(&run, &plan, 0, COLD_C);
+    TEST_ASSERT_TRUE(stepRunPlan(&run, &plan, 100, HOLD_TARGET_C));
+
+    RunCheckpoint saved;
+    checkpoint(&run, 110, HOLD_TARGET_C, &saved);
+    TEST_ASSERT_TRUE(saved.position.end_known);
+    TEST_ASSERT_TRUE(saved.position.gate_met);
+
+    PlanRun resumed;
+    beginRunPlan(&resumed, &plan, 1000, HOLD_TARGET_C);
+    TEST_ASSERT_TRUE(seekRunPlan(&resumed, &plan, &saved.position, 1000));
+    // 50s of the hold were left
+    TEST_ASSERT_TRUE(stepRunPlan(&resumed, &plan, 1049, HOLD_TARGET_C));
+    TEST_ASSERT_FALSE(stepRunPlan(&resumed, &plan, 1050, HOLD_TARGET_C));
+}
+
+/**
+ * @brief the oven takes longer than a uint16 of seconds to reach the gate, so the step ends too far after
+ * its start for the checkpoint to hold the offset as is
+ */
+void test_long_gate_temp_hold(void)
+{
+    const uint32_t gate_s = 70000;
+
+    PlanRun run;
+    beginRunPlan(&run, &plan, 0, COLD_C);
+    TEST_ASSERT_TRUE(stepRunPlan(&run, &plan, gate_s, COLD_C));
+    TEST_ASSERT_FALSE(run.end_known);
+    TEST_ASSERT_TRUE(stepRunPlan(&run, &plan, gate_s, HOLD_TARGET_C));
+    TEST_ASSERT_EQUAL_UINT32(gate_s + HOLD_S, run.step_end_s);
+
+    RunCheckpoint saved;
+    checkpoint(&run, gate_s + 10, HOLD_TARGET_C, &saved);
+    TEST_ASSERT_TRUE(saved.position.end_known);
+    TEST_ASSERT_EQUAL_UINT32(HOLD_S - 10, (uint32_t)saved.position.end_offset_s - saved.position.elapsed_s);
+
+    PlanRun resumed;
+    beginRunPlan(&resumed, &plan, 100, HOLD_TARGET_C);
+    TEST_ASSERT_TRUE(seekRunPlan(&resumed, &plan, &saved.position, 100));
+    TEST_ASSERT_EQUAL_UINT32(100 + HOLD_S - 10, resumed.step_end_s);
+    TEST_ASSERT_TRUE(stepRunPlan(&resumed, &plan, 100 + HOLD_S - 11, HOLD_TARGET_C));
+    TEST_ASSERT_FALSE(stepRunPlan(&resumed, &plan, 100 + HOLD_S - 10, HOLD_TARGET_C));
+}
+
+/**
+ * @brief still waiting for the gate: the resumed run waits again, for as long as it takes
+ */
+void test_before_gate(void)
+{
+    PlanRun run;
+    beginRunPlan(&run, &plan, 0, COLD_C);
+    TEST_ASSERT_TRUE(stepRunPlan(&run, &plan, 70000, COLD_C));
+
+    RunCheckpoint saved;
+    checkpoint(&run, 70000, COLD_C, &saved);
+    TEST_ASSERT_FALSE(saved.position.end_known);
+
+    PlanRun resumed;
+    beginRunPlan(&resumed, &plan, 100, COLD_C);
+    TEST_ASSERT_TRUE(seekRunPlan(&resumed, &plan, &saved.position, 100));
+    TEST_ASSERT_TRUE(stepRunPlan(&resumed, &plan, 200, COLD_C));
+    TEST_ASSERT_TRUE(stepRunPlan(&resumed, &plan, 300, HOLD_TARGET_C));
+    TEST_ASSERT_EQUAL_UINT32(300 + HOLD_S, resumed.step_end_s);
+}
+
+void setup()
+{
+    // give the serial monitor time to attach after the reset
+    delay(2000);
+    beginJournal();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_short_hold);
+    RUN_TEST(test_long_gate_temp_hold);
+    RUN_TEST(test_before_gate);
+    UNITY_END();
+}
+
+void loop()
+{
+}
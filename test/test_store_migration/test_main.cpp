@@ -0,0 +1,233 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include "storage.h"
+#include "eeprom_cache.h"
+
+/*
+Migration of stored profiles from older store layouts. Runs on the board and rewrites its EEPROM.
+*/
+
+// layouts 0 and 1 stored profiles as this struct, raw
+struct LegacyProfile
+{
+    bool fan_on;
+    int preheat_temp_c;
+    int preheat_time_s;
+    int soak_temp_c;
+    int soak_time_s;
+    int reflow_temp;
+    int reflow_hold_time_s;
+};
+
+// layout 0: raw constants, then a raw array of 10 profiles
+#define LEGACY_NUM_PROFILES 10
+#define LEGACY_BAD_PROFILE 3 // fails isProfileValid(); must not survive
+
+// layout 1: the current store, with raw LegacyProfile records
+#define V1_PID_RECORD_ADDRESS (STORE_BASE_ADDRESS + sizeof(StoreHeader))
+#define V1_PROFILE_RECORD_ADDRESS(index) (V1_PID_RECORD_ADDRESS + sizeof(uint16_t) + sizeof(PID_Constants) + (index) * (sizeof(uint16_t) + sizeof(LegacyProfile)))
+#define V1_BAD_PROFILE 50 // stored with a broken CRC
+
+// everything either layout ever used
+#define OLD_LAYOUT_END V1_PROFILE_RECORD_ADDRESS(NUM_REFLOW_PROFILES)
+
+static const PID_Constants test_constants = {2.0f, 0.5f, 10.0f, 0.3f};
+
+void setUp(void)
+{
+    // start from blank EEPROM, nothing staged
+    flushEepromCache();
+    for (uint16_t address = STORE_BASE_ADDRESS; address < OLD_LAYOUT_END; address++)
+    {
+        EEPROM.update(address, 0xFF);
+    }
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief a different, valid profile for every slot
+ */
+static void slotProfile(uint8_t index, LegacyProfile *ptr_profile)
+{
+    ptr_profile->fan_on = index % 2;
+    ptr_profile->preheat_temp_c = 100 + index;
+    ptr_profile->preheat_time_s = index * 6;
+    ptr_profile->soak_temp_c = 150 + index;
+    ptr_profile->soak_time_s = MAX_TIME_S - index * 6;
+    ptr_profile->reflow_temp = 200 + index;
+    ptr_profile->reflow_hold_time_s = index % 60;
+}
+
+static uint16_t recordCRC(uint8_t record_id, const void *payload, uint16_t length)
+{
+    return crc16(crc16Update(0xFFFF, record_id), payload, length);
+}
+
+static void assertMigrated(uint8_t index)
+{
+    LegacyProfile expected;
+    slotProfile(index, &expected);
+
+    ReflowProfile profile;
+    TEST_ASSERT_TRUE_MESSAGE(readProfileRecord(index, &profile), "profile lost");
+    TEST_ASSERT_EQUAL(expected.fan_on, profile.fan_on);
+    TEST_ASSERT_EQUAL_INT(expected.preheat_temp_c, profile.preheat_temp_c);
+    TEST_ASSERT_EQUAL_INT(expected.preheat_time_s, profile.preheat_time_s);
+    TEST_ASSERT_EQUAL_INT(expected.soak_temp_c, profile.soak_temp_c);
+    TEST_ASSERT_EQUAL_INT(expected.soak_time_s, profile.soak_time_s);
+    TEST_ASSERT_EQUAL_INT(expected.reflow_temp, profile.reflow_temp);
+    TEST_ASSERT_EQUAL_INT(expected.reflow_hold_time_s, profile.reflow_hold_time_s);
+    // old profiles were all time gated
+    TEST_ASSERT_EQUAL_UINT8(GATE_TIME, profile.preheat_gate);
+    TEST_ASSERT_EQUAL_UINT8(GATE_TIME, profile.soak_gate);
+    TEST_ASSERT_EQUAL_UINT8(GATE_TIME, profile.reflow_gate);
+}
+
+/**
+ * @brief constants survive, except the D gain: layout 3 puts it back to the default
+ */
+static void assertConstantsKept(void)
+{
+    PID_Constants constants;
+    TEST_ASSERT_TRUE_MESSAGE(readPIDConstantsRecord(&constants), "PID constants lost");
+    TEST_ASSERT_EQUAL_FLOAT(test_constants.PID_k, constants.PID_k);
+    TEST_ASSERT_EQUAL_FLOAT(test_constants.PID_i, constants.PID_i);
+    TEST_ASSERT_EQUAL_FLOAT(DEFAULT_PID_D, constants.PID_d);
+    TEST_ASSERT_EQUAL_FLOAT(test_constants.threshold, constants.threshold);
+}
+
+void test_layout_0_to_current(void)
+{
+    EEPROM.put(DEFAULT_CONSTANTS_ADDRESS, test_constants);
+    for (uint8_t i = 0; i < LEGACY_NUM_PROFILES; i++)
+    {
+        LegacyProfile legacy;
+        slotProfile(i, &legacy);
+        if (i == LEGACY_BAD_PROFILE)
+        {
+            legacy.preheat_temp_c = MAX_TEMP_C + 1;
+        }
+        EEPROM.put(DEFAULT_PROFILES_ADDRESS + i * sizeof(LegacyProfile), legacy);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_MIGRATED, beginStore());
+    // check what reached the EEPROM, not what's staged
+    flushEepromCache();
+
+    assertConstantsKept();
+    for (uint8_t i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        if (i < LEGACY_NUM_PROFILES && i != LEGACY_BAD_PROFILE)
+        {
+            assertMigrated(i);
+        }
+        else
+        {
+            ReflowProfile profile;
+            TEST_ASSERT_FALSE(readProfileRecord(i, &profile));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_OK, beginStore());
+}
+
+void test_layout_1_to_current(void)
+{
+    StoreHeader header = {STORE_MAGIC, 1, NUM_REFLOW_PROFILES};
+    EEPROM.put(STORE_BASE_ADDRESS, header);
+
+    uint16_t crc = recordCRC(RECORD_PID_CONSTANTS, &test_constants, sizeof(test_constants));
+    EEPROM.put(V1_PID_RECORD_ADDRESS, crc);
+    EEPROM.put(V1_PID_RECORD_ADDRESS + sizeof(crc), test_constants);
+
+    for (uint8_t i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        LegacyProfile legacy;
+        slotProfile(i, &legacy);
+        crc = recordCRC(RECORD_PROFILE(i), &legacy, sizeof(legacy));
+        if (i == V1_BAD_PROFILE)
+        {
+            crc = ~crc;
+        }
+        EEPROM.put(V1_PROFILE_RECORD_ADDRESS(i), crc);
+        EEPROM.put(V1_PROFILE_RECORD_ADDRESS(i) + sizeof(crc), legacy);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_MIGRATED, beginStore());
+    flushEepromCache();
+
+    // every slot is rewritten in place; none may clobber one that hasn't been read yet
+    assertConstantsKept();
+    for (uint8_t i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        if (i == V1_BAD_PROFILE)
+        {
+            ReflowProfile profile;
+            TEST_ASSERT_FALSE(readProfileRecord(i, &profile));
+        }
+        else
+        {
+            assertMigrated(i);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_OK, beginStore());
+}
+
+void test_layout_2_to_3(void)
+{
+    // a current store, then marked as layout 2
+    beginStore();
+    PID_Constants constants = test_constants;
+    writePIDConstantsRecord(&constants);
+    for (uint8_t i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        LegacyProfile legacy;
+        slotProfile(i, &legacy);
+        ReflowProfile profile;
+        memset(&profile, 0, sizeof(profile));
+        profile.fan_on = legacy.fan_on;
+        profile.preheat_temp_c = legacy.preheat_temp_c;
+        profile.preheat_time_s = legacy.preheat_time_s;
+        profile.soak_temp_c = legacy.soak_temp_c;
+        profile.soak_time_s = legacy.soak_time_s;
+        profile.reflow_temp = legacy.reflow_temp;
+        profile.reflow_hold_time_s = legacy.reflow_hold_time_s;
+        writeProfileRecord(i, &profile);
+    }
+    flushEepromCache();
+    StoreHeader header = {STORE_MAGIC, 2, NUM_REFLOW_PROFILES};
+    EEPROM.put(STORE_BASE_ADDRESS, header);
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_MIGRATED, beginStore());
+    flushEepromCache();
+
+    // only the D gain changes
+    assertConstantsKept();
+    for (uint8_t i = 0; i < NUM_REFLOW_PROFILES; i++)
+    {
+        assertMigrated(i);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(STORE_OK, beginStore());
+}
+
+void setup()
+{
+    // give the serial monitor time to attach after the reset
+    delay(2000);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_layout_0_to_current);
+    RUN_TEST(test_layout_1_to_current);
+    RUN_TEST(test_layout_2_to_3);
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,109 @@
+// Host front end for the profile synthesizer (src/synth.cpp), the same code the serial "synth" command runs.
+//
+//   g++ -O2 -std=gnu++11 -iquote include tools/profile_synth.cpp src/synth.cpp -o profile_synth
+//   ./profile_synth [field=value ...]
+//
+// Fields are the serial command's (ramp, cool, soak_lo, soak_hi, soak_min_s, soak_max_s, liquidus, tal_min_s,
+// tal_max_s, peak_lo, peak_hi), plus oven_heat, oven_cool (C/s), start and end (C). Rates are in C/s.
+// Starts from the SAC305-style defaults. Prints the segments and what they work out to.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "synth.h"
+
+int main(int argc, char **argv)
+{
+    PasteWindow window;
+    defaultPasteWindow(&window);
+    OvenRates oven = {20, 10};
+    int start_c = 25;
+    int end_c = SYNTH_DEFAULT_END_C;
+
+    struct
+    {
+        const char *key;
+        void *ptr_value;
+        bool rate;
+    } fields[] = {
+        {"ramp", &window.max_ramp, true},
+        {"cool", &window.max_cool, true},
+        {"soak_lo", &window.soak_min_c, false},
+        {"soak_hi", &window.soak_max_c, false},
+        {"soak_min_s", &window.soak_min_s, false},
+        {"soak_max_s", &window.soak_max_s, false},
+        {"liquidus", &window.liquidus_c, false},
+        {"tal_min_s", &window.tal_min_s, false},
+        {"tal_max_s", &window.tal_max_s, false},
+        {"peak_lo", &window.peak_min_c, false},
+        {"peak_hi", &window.peak_max_c, false},
+        {"oven_heat", &oven.heat, true},
+        {"oven_cool", &oven.cool, true},
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        char *value = strchr(argv[i], '=');
+        if (value == NULL)
+        {
+            fprintf(stderr, "expected field=value: %s\n", argv[i]);
+            return 2;
+        }
+        *value++ = '\0';
+
+        if (strcmp(argv[i], "start") == 0)
+        {
+            start_c = atoi(value);
+            continue;
+        }
+        if (strcmp(argv[i], "end") == 0)
+        {
+            end_c = atoi(value);
+            continue;
+        }
+
+        bool found = false;
+        for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+        {
+            if (strcmp(argv[i], fields[f].key) == 0)
+            {
+                // every field is 16 bits
+                *(int16_t *)fields[f].ptr_value = fields[f].rate ? (int16_t)(atof(value) * 10 + 0.5) : atoi(value);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            fprintf(stderr, "unknown field: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    SegmentProfile segments;
+    SynthReport report;
+    uint8_t error = synthesizeProfile(&window, &oven, start_c, end_c, true, &segments, &report);
+    if (error != SYNTH_OK)
+    {
+        printf("can't meet the windows: error %u\n", error);
+        return 1;
+    }
+
+    static const char *const type_names[NUM_SEGMENT_TYPES] = {"ramp", "hold", "until", "cooldown"};
+    for (uint8_t i = 0; i < segments.num_segments; i++)
+    {
+        const ProfileSegment *ptr_segment = &segments.segments[i];
+        printf("%u %s %dC", i + 1, type_names[ptr_segment->type], ptr_segment->target_c);
+        if (ptr_segment->type == SEGMENT_RAMP)
+        {
+            printf(" at %.1fC/s", ptr_segment->value / 10.0);
+        }
+        else if (ptr_segment->type == SEGMENT_HOLD)
+        {
+            printf(" for %us", ptr_segment->value);
+        }
+        printf("\n");
+    }
+    printf("ramp %.1fC/s, cool %.1fC/s, peak %dC, soak %us, hold %us, TAL %us, total %lus\n", report.ramp / 10.0, report.cool / 10.0,
+           report.peak_c, report.soak_s, report.hold_s, report.tal_s, (unsigned long)report.total_s);
+    return 0;
+}
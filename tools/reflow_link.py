@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+"""Host side of the oven's binary serial protocol (include/serial_protocol.h).
+
+Read and write profile slots and PID constants without going through the menus,
+e.g. to provision a fleet of ovens from one JSON file:
+
+    reflow_link.py /dev/ttyACM0 export > oven.json
+    reflow_link.py /dev/ttyACM0 import oven.json
+    reflow_link.py /dev/ttyACM0 get-profile 3
+    reflow_link.py /dev/ttyACM0 set-pid 1.0 0.0 22.0 0.1
+
+The encode/decode helpers have no serial dependency and can be imported on their own.
+Needs pyserial for talking to an oven.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+REPLY = 0x80
+
+PING = 0x01
+READ_PROFILE = 0x10
+WRITE_PROFILE = 0x11
+READ_PID = 0x20
+WRITE_PID = 0x21
+
+STATUS = {
+    0: "ok",
+    1: "bad crc",
+    2: "unknown command",
+    3: "bad length",
+    4: "bad slot",
+    5: "invalid value",
+    6: "busy: oven is running",
+    7: "empty slot",
+}
+OK = 0
+EMPTY_SLOT = 7
+
+PROFILE_FORMAT = "<B6h"
+PROFILE_FIELDS = ("fan_on", "preheat_temp_c", "preheat_time_s", "soak_temp_c",
+                  "soak_time_s", "reflow_temp", "reflow_hold_time_s")
+GATE_FIELDS = ("preheat_gate", "soak_gate", "reflow_gate")
+GATES = ("time", "temp", "both")  # SegmentGate, in order
+PID_FORMAT = "<4f"
+PID_FIELDS = ("PID_k", "PID_i", "PID_d", "threshold")
+
+
+class ProtocolError(Exception):
+    pass
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT, same as crc16() in storage.h"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(command, payload=b""):
+    body = bytes([len(payload), command]) + bytes(payload)
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+
+def decode_frame(frame):
+    """Split a whole frame into (command, payload). Raises ProtocolError if it's malformed."""
+    if len(frame) < 5 or frame[0] != SYNC or len(frame) != frame[1] + 5:
+        raise ProtocolError("malformed frame")
+    body = frame[1:-2]
+    if crc16(body) != struct.unpack("<H", frame[-2:])[0]:
+        raise ProtocolError("reply failed its crc")
+    return frame[2], bytes(frame[3:-2])
+
+
+def encode_profile(profile):
+    gates = 0
+    for i, field in enumerate(GATE_FIELDS):
+        gates |= GATES.index(profile.get(field, "time")) << (2 * i)
+    return struct.pack(PROFILE_FORMAT, *(int(profile[field]) for field in PROFILE_FIELDS)) + bytes([gates])
+
+
+def decode_profile(data):
+    size = struct.calcsize(PROFILE_FORMAT)
+    profile = dict(zip(PROFILE_FIELDS, struct.unpack(PROFILE_FORMAT, data[:size])))
+    profile["fan_on"] = bool(profile["fan_on"])
+    # protocol version 1 had no gate byte; those stages were all time gated
+    gates = data[size] if len(data) > size else 0
+    for i, field in enumerate(GATE_FIELDS):
+        profile[field] = GATES[(gates >> (2 * i)) & 3]
+    return profile
+
+
+def encode_pid(constants):
+    return struct.pack(PID_FORMAT, *(float(constants[field]) for field in PID_FIELDS))
+
+
+def decode_pid(data):
+    return {field: round(value, 4) for field, value in zip(PID_FIELDS, struct.unpack(PID_FORMAT, data))}
+
+
+class Oven:
+    def __init__(self, port, baud=9600, timeout=2.0):
+        import serial  # pyserial; only needed to talk to a real oven
+
+        self.serial = serial.Serial(port, baud, timeout=timeout)
+        # opening the port resets most Arduinos; wait out the bootloader and setup()
+        time.sleep(2.5)
+        self.serial.reset_input_buffer()
+
+    def request(self, command, payload=b""):
+        self.serial.write(encode_frame(command, payload))
+
+        # skip anything that isn't a frame (debug prints etc.)
+        while True:
+            byte = self.serial.read(1)
+            if not byte:
+                raise ProtocolError("no reply")
+            if byte[0] == SYNC:
+                break
+        length = self.serial.read(1)
+        if not length:
+            raise ProtocolError("no reply")
+        rest = self.serial.read(length[0] + 3)
+        reply_command, reply = decode_frame(byte + length + rest)
+
+        if reply_command != command | REPLY or not reply:
+            raise ProtocolError("unexpected reply 0x%02x" % reply_command)
+        return reply[0], reply[1:]
+
+    def check(self, status, allowed=(OK,)):
+        if status not in allowed:
+            raise ProtocolError(STATUS.get(status, "status %d" % status))
+        return status
+
+    def ping(self):
+        status, data = self.request(PING)
+        self.check(status)
+        return {"version": data[0], "profiles": data[1]}
+
+    def read_profile(self, slot):
+        status, data = self.request(READ_PROFILE, bytes([slot]))
+        self.check(status, (OK, EMPTY_SLOT))
+        return decode_profile(data[1:]), status == OK
+
+    def write_profile(self, slot, profile):
+        status, _ = self.request(WRITE_PROFILE, bytes([slot]) + encode_profile(profile))
+        self.check(status)
+
+    def read_pid(self):
+        status, data = self.request(READ_PID)
+        self.check(status)
+        return decode_pid(data)
+
+    def write_pid(self, constants):
+        status, _ = self.request(WRITE_PID, encode_pid(constants))
+        self.check(status)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=9600)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    commands.add_parser("ping")
+    get_profile = commands.add_parser("get-profile")
+    get_profile.add_argument("slot", type=int, help="1-based, as shown on the oven")
+    set_profile = commands.add_parser("set-profile")
+    set_profile.add_argument("slot", type=int, help="1-based, as shown on the oven")
+    set_profile.add_argument("json", help='e.g. {"fan_on": true, "preheat_temp_c": 150, ...}')
+    commands.add_parser("get-pid")
+    set_pid = commands.add_parser("set-pid")
+    for field in PID_FIELDS:
+        set_pid.add_argument(field, type=float)
+    commands.add_parser("export", help="print PID constants and every stored profile as JSON")
+    import_ = commands.add_parser("import", help="write everything in a file made by export")
+    import_.add_argument("file")
+
+    args = parser.parse_args()
+    oven = Oven(args.port, args.baud)
+
+    if args.command == "ping":
+        print(json.dumps(oven.ping()))
+    elif args.command == "get-profile":
+        profile, stored = oven.read_profile(args.slot - 1)
+        print(json.dumps(profile) + ("" if stored else "  # not stored, default"))
+    elif args.command == "set-profile":
+        oven.write_profile(args.slot - 1, json.loads(args.json))
+    elif args.command == "get-pid":
+        print(json.dumps(oven.read_pid()))
+    elif args.command == "set-pid":
+        oven.write_pid({field: getattr(args, field) for field in PID_FIELDS})
+    elif args.command == "export":
+        profiles = {}
+        for slot in range(oven.ping()["profiles"]):
+            profile, stored = oven.read_profile(slot)
+            if stored:
+                profiles[str(slot + 1)] = profile
+        json.dump({"pid": oven.read_pid(), "profiles": profiles}, sys.stdout, indent=2)
+        print()
+    elif args.command == "import":
+        with open(args.file) as f:
+            config = json.load(f)
+        if "pid" in config:
+            oven.write_pid(config["pid"])
+        for slot, profile in config.get("profiles", {}).items():
+            oven.write_profile(int(slot) - 1, profile)
+        print("wrote %d profiles" % len(config.get("profiles", {})))
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except ProtocolError as e:
+        sys.exit("error: %s" % e)
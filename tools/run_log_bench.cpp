@@ -0,0 +1,144 @@
+// Host exercise/benchmark for the run logger with the file backend standing in for the SD card.
+//
+//   g++ -O2 -std=gnu++11 -iquote include tools/run_log_bench.cpp src/run_log.cpp src/run_log_file.cpp -o run_log_bench
+//   ./run_log_bench [samples] [loop passes per sample] [output directory]
+//
+// Logs a simulated run, reads the files back and checks every block, then prints timings.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "run_log.h"
+
+static uint16_t getU16(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static double nowUs(void)
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief read back every file of a run and check block headers and record timestamps
+ *
+ * @return long records found, -1 on a bad block
+ */
+static long verifyRun(const char *directory, uint16_t run_number, uint8_t files)
+{
+    long records = 0;
+    uint16_t expected_sequence = 0;
+    uint32_t last_ms = 0;
+
+    for (uint8_t part = 0; part < files; part++)
+    {
+        char name[RUN_LOG_NAME_LEN];
+        char path[256];
+        runLogFileName(run_number, part, name);
+        snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+        FILE *file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            printf("missing %s\n", path);
+            return -1;
+        }
+
+        uint8_t block[RUN_LOG_BLOCK_SIZE];
+        while (fread(block, 1, sizeof(block), file) == sizeof(block))
+        {
+            if (getU16(block) != RUN_LOG_MAGIC || getU16(block + 2) != run_number || getU16(block + 4) != expected_sequence || block[7] != RUN_LOG_RECORD_SIZE)
+            {
+                printf("bad block %u in %s\n", expected_sequence, name);
+                fclose(file);
+                return -1;
+            }
+            expected_sequence++;
+
+            for (uint8_t i = 0; i < block[6]; i++)
+            {
+                uint32_t ms = getU32(block + RUN_LOG_HEADER_SIZE + i * RUN_LOG_RECORD_SIZE);
+                if (records > 0 && ms <= last_ms)
+                {
+                    printf("out of order record in block %u\n", expected_sequence - 1);
+                    fclose(file);
+                    return -1;
+                }
+                last_ms = ms;
+                records++;
+            }
+        }
+        fclose(file);
+    }
+
+    return records;
+}
+
+int main(int argc, char **argv)
+{
+    long samples = argc > 1 ? atol(argv[1]) : 7200; // an hour at the 500ms PID period
+    int passes = argc > 2 ? atoi(argv[2]) : 4;      // loop() passes between PID ticks
+    const char *directory = argc > 3 ? argv[3] : ".";
+
+    setRunLogDirectory(directory);
+    setRunLogBackend(&run_log_file_backend);
+
+    if (!beginRunLog(42, 0))
+    {
+        printf("couldn't open a log file in %s\n", directory);
+        return 1;
+    }
+
+    double log_us = 0, service_us = 0, worst_service_us = 0;
+    for (long i = 0; i < samples; i++)
+    {
+        RunLogSample sample;
+        sample.ms = i * 500;
+        sample.temp_c = 25 + i * 0.1f;
+        sample.target_c = 150;
+        sample.p_term = 1.5f;
+        sample.i_term = 0.2f;
+        sample.d_term = -0.3f;
+        sample.output = 1.4f;
+        sample.heater_on = i & 1;
+        sample.fan_on = true;
+
+        double start = nowUs();
+        logRunSample(&sample);
+        log_us += nowUs() - start;
+
+        for (int pass = 0; pass < passes; pass++)
+        {
+            start = nowUs();
+            serviceRunLog();
+            double elapsed = nowUs() - start;
+            service_us += elapsed;
+            if (elapsed > worst_service_us)
+            {
+                worst_service_us = elapsed;
+            }
+        }
+    }
+
+    double start = nowUs();
+    endRunLog();
+    double end_us = nowUs() - start;
+
+    const RunLogStats *stats = getRunLogStats();
+    long found = verifyRun(directory, 42, stats->files);
+
+    printf("records %lu, dropped %lu, blocks %u, files %u, failed %d\n", (unsigned long)stats->records, (unsigned long)stats->dropped_records, stats->blocks, stats->files, stats->failed);
+    printf("read back %ld records: %s\n", found, found == (long)stats->records ? "ok" : "MISMATCH");
+    printf("logRunSample %.3f us avg, serviceRunLog %.3f us avg / %.1f us worst, endRunLog %.1f us\n",
+           log_us / samples, service_us / (samples * (double)passes), worst_service_us, end_us);
+
+    return found == (long)stats->records ? 0 : 1;
+}